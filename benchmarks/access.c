@@ -0,0 +1,63 @@
+/*
+Accessor loops of the benchmarks, compiled in their own file without the implementation. This is where a user's
+systems usually live, so component and query accessors are only inlined when MECS_INLINE_ACCESSORS is defined.
+*/
+#include "../mecs.h"
+
+mecs_uint32_t bench_access_component_get(mecs_registry_t* io_registry, mecs_entity_t const* i_entities, mecs_size_t i_count, mecs_component_type_t* i_type)
+{
+    mecs_uint32_t sum;
+    mecs_size_t i;
+
+    sum = 0;
+    for (i = 0; i < i_count; ++i)
+    {
+        sum += *(mecs_uint32_t*)mecs_component_get_impl(io_registry, i_entities[i], i_type);
+    }
+    return sum;
+}
+
+/* Same as bench_access_component_get with a compile time id, as with STATIC_COMPONENTS_REGISTER. bench_comp_0 is registered first. */
+mecs_uint32_t bench_access_component_get_static(mecs_registry_t* io_registry, mecs_entity_t const* i_entities, mecs_size_t i_count)
+{
+    mecs_uint32_t sum;
+    mecs_size_t i;
+
+    sum = 0;
+    for (i = 0; i < i_count; ++i)
+    {
+        sum += *(mecs_uint32_t*)mecs_component_get_by_id(io_registry, i_entities[i], 0);
+    }
+    return sum;
+}
+
+mecs_uint32_t bench_access_component_has(mecs_registry_t const* i_registry, mecs_entity_t const* i_entities, mecs_size_t i_count, mecs_component_type_t* i_type)
+{
+    mecs_uint32_t sum;
+    mecs_size_t i;
+
+    sum = 0;
+    for (i = 0; i < i_count; ++i)
+    {
+        sum += mecs_component_has_impl(i_registry, i_entities[i], i_type) ? 1 : 0;
+    }
+    return sum;
+}
+
+/* Sums the first field of every queried component, the query must hold i_type_count arguments using i_types. */
+mecs_uint32_t bench_access_query_component_get(mecs_registry_t* io_registry, mecs_query_it_t* io_query_it, mecs_component_type_t** i_types, mecs_size_t i_type_count)
+{
+    mecs_uint32_t sum;
+    mecs_size_t i;
+
+    sum = 0;
+    for (mecs_query_begin(io_registry, io_query_it); mecs_query_next(io_query_it);)
+    {
+        sum += mecs_entity_get_id(mecs_query_entity_get(io_query_it));
+        for (i = 0; i < i_type_count; ++i)
+        {
+            sum += *(mecs_uint32_t*)mecs_query_component_get_impl(io_query_it, i_types[i], i);
+        }
+    }
+    return sum;
+}
@@ -0,0 +1,583 @@
+/*
+Benchmarks for the hot paths of mecs. Compatible with C89/C++98 and higher.
+
+Usage:
+    bench [--json]
+
+Build together with access.c, and define MECS_INLINE_ACCESSORS for both files to measure the inline accessors.
+
+Every benchmark is repeated a number of times on a freshly populated registry, after which the fastest and median
+repetition are reported. Results are written to stdout as CSV, or as JSON when --json is passed, so they can be
+compared between commits.
+*/
+#if !defined(_WIN32) && !defined(_POSIX_C_SOURCE)
+    #define _POSIX_C_SOURCE 199309L /* clock_gettime */
+#endif
+
+#include "../mecs.h"
+#include "../mecs_serialisation.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if defined(_WIN32)
+    #include <windows.h>
+#else
+    #include <time.h>
+#endif
+
+#define BENCH_REPETITIONS 7
+#define BENCH_MAX_RESULTS 256
+#define BENCH_COMPONENT_COUNT 8
+
+#if defined(__cplusplus)
+    #define BENCH_LANGUAGE "cpp"
+#else
+    #define BENCH_LANGUAGE "c"
+#endif
+
+#if defined(MECS_INLINE_ACCESSORS)
+    #define BENCH_ACCESSORS "inline"
+#else
+    #define BENCH_ACCESSORS "call"
+#endif
+
+/* --------------------------------------------------
+Timing
+-------------------------------------------------- */
+double bench_time_ns(void)
+{
+#if defined(_WIN32)
+    LARGE_INTEGER frequency;
+    LARGE_INTEGER counter;
+    QueryPerformanceFrequency(&frequency);
+    QueryPerformanceCounter(&counter);
+    return (double)counter.QuadPart * 1e9 / (double)frequency.QuadPart;
+#else
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return (double)time.tv_sec * 1e9 + (double)time.tv_nsec;
+#endif
+}
+
+typedef struct
+{
+    char const* name;
+    mecs_size_t entities;
+    mecs_size_t args;
+    mecs_size_t selectivity; /* Percentage of entities which have the queried components. */
+    double min_ns;
+    double median_ns;
+} bench_result_t;
+
+bench_result_t g_bench_results[BENCH_MAX_RESULTS];
+mecs_size_t g_bench_results_len;
+volatile mecs_uint32_t g_bench_sink; /* Prevents the compiler from optimising away the work being measured. */
+
+int bench_compare_double(void const* i_lhs, void const* i_rhs)
+{
+    double lhs = *(double const*)i_lhs;
+    double rhs = *(double const*)i_rhs;
+    return lhs < rhs ? -1 : (lhs > rhs ? 1 : 0);
+}
+
+void bench_report(char const* i_name, mecs_size_t i_entities, mecs_size_t i_args, mecs_size_t i_selectivity, double* io_samples)
+{
+    bench_result_t* result;
+    if (g_bench_results_len == BENCH_MAX_RESULTS)
+    {
+        return;
+    }
+
+    qsort(io_samples, BENCH_REPETITIONS, sizeof(double), &bench_compare_double);
+    result = &g_bench_results[g_bench_results_len++];
+    result->name = i_name;
+    result->entities = i_entities;
+    result->args = i_args;
+    result->selectivity = i_selectivity;
+    result->min_ns = io_samples[0];
+    result->median_ns = io_samples[BENCH_REPETITIONS / 2];
+}
+
+void bench_print_csv(void)
+{
+    mecs_size_t i;
+    bench_result_t* result;
+
+    printf("language,accessors,benchmark,entities,args,selectivity,repetitions,min_ns,median_ns,min_ns_per_entity\n");
+    for (i = 0; i < g_bench_results_len; ++i)
+    {
+        result = &g_bench_results[i];
+        printf("%s,%s,%s,%lu,%lu,%lu,%d,%.0f,%.0f,%.3f\n",
+            BENCH_LANGUAGE, BENCH_ACCESSORS, result->name, (unsigned long)result->entities, (unsigned long)result->args, (unsigned long)result->selectivity,
+            BENCH_REPETITIONS, result->min_ns, result->median_ns, result->min_ns / (double)result->entities);
+    }
+}
+
+void bench_print_json(void)
+{
+    mecs_size_t i;
+    bench_result_t* result;
+
+    printf("[\n");
+    for (i = 0; i < g_bench_results_len; ++i)
+    {
+        result = &g_bench_results[i];
+        printf("  {\"language\": \"%s\", \"accessors\": \"%s\", \"benchmark\": \"%s\", \"entities\": %lu, \"args\": %lu, \"selectivity\": %lu, \"repetitions\": %d, \"min_ns\": %.0f, \"median_ns\": %.0f, \"min_ns_per_entity\": %.3f}%s\n",
+            BENCH_LANGUAGE, BENCH_ACCESSORS, result->name, (unsigned long)result->entities, (unsigned long)result->args, (unsigned long)result->selectivity,
+            BENCH_REPETITIONS, result->min_ns, result->median_ns, result->min_ns / (double)result->entities, i + 1 == g_bench_results_len ? "" : ",");
+    }
+    printf("]\n");
+}
+
+/* --------------------------------------------------
+Components
+-------------------------------------------------- */
+/* C++ finds component types through a template, a lone ';' would trip -Wpedantic. */
+#if defined(__cplusplus)
+    #define BENCH_COMPONENT_DECLARE(T)
+#else
+    #define BENCH_COMPONENT_DECLARE(T) COMPONENT_DECLARE(T);
+#endif
+
+#define BENCH_COMPONENT(T)                                                                                                  \
+    typedef struct                                                                                                          \
+    {                                                                                                                       \
+        mecs_uint32_t v;                                                                                                    \
+        mecs_uint32_t x;                                                                                                    \
+        mecs_uint32_t y;                                                                                                    \
+        mecs_uint32_t z;                                                                                                    \
+    } T;                                                                                                                    \
+                                                                                                                            \
+    ARCHIVE(T, MECS_TRUE)                                                                                                   \
+    {                                                                                                                       \
+        archive_add(mecs_uint32_t, v, 0);                                                                                   \
+        archive_add(mecs_uint32_t, x, 0);                                                                                   \
+        archive_add(mecs_uint32_t, y, 0);                                                                                   \
+        archive_add(mecs_uint32_t, z, 0);                                                                                   \
+    }                                                                                                                       \
+    BENCH_COMPONENT_DECLARE(T)                                                                                              \
+
+BENCH_COMPONENT(bench_comp_0)
+BENCH_COMPONENT(bench_comp_1)
+BENCH_COMPONENT(bench_comp_2)
+BENCH_COMPONENT(bench_comp_3)
+BENCH_COMPONENT(bench_comp_4)
+BENCH_COMPONENT(bench_comp_5)
+BENCH_COMPONENT(bench_comp_6)
+BENCH_COMPONENT(bench_comp_7)
+
+mecs_component_type_t* g_bench_types[BENCH_COMPONENT_COUNT];
+
+registry_t* bench_registry_create(void)
+{
+    registry_t* registry;
+
+    registry = registry_create(BENCH_COMPONENT_COUNT);
+    COMPONENT_REGISTER(registry, bench_comp_0);
+    COMPONENT_REGISTER(registry, bench_comp_1);
+    COMPONENT_REGISTER(registry, bench_comp_2);
+    COMPONENT_REGISTER(registry, bench_comp_3);
+    COMPONENT_REGISTER(registry, bench_comp_4);
+    COMPONENT_REGISTER(registry, bench_comp_5);
+    COMPONENT_REGISTER(registry, bench_comp_6);
+    COMPONENT_REGISTER(registry, bench_comp_7);
+    return registry;
+}
+
+void bench_types_init(void)
+{
+    COMPONENT_REGISTER_SERIALISATION_HOOKS(bench_comp_0);
+    COMPONENT_REGISTER_SERIALISATION_HOOKS(bench_comp_1);
+    COMPONENT_REGISTER_SERIALISATION_HOOKS(bench_comp_2);
+    COMPONENT_REGISTER_SERIALISATION_HOOKS(bench_comp_3);
+    COMPONENT_REGISTER_SERIALISATION_HOOKS(bench_comp_4);
+    COMPONENT_REGISTER_SERIALISATION_HOOKS(bench_comp_5);
+    COMPONENT_REGISTER_SERIALISATION_HOOKS(bench_comp_6);
+    COMPONENT_REGISTER_SERIALISATION_HOOKS(bench_comp_7);
+    g_bench_types[0] = mecs_component_get_type_ptr(bench_comp_0);
+    g_bench_types[1] = mecs_component_get_type_ptr(bench_comp_1);
+    g_bench_types[2] = mecs_component_get_type_ptr(bench_comp_2);
+    g_bench_types[3] = mecs_component_get_type_ptr(bench_comp_3);
+    g_bench_types[4] = mecs_component_get_type_ptr(bench_comp_4);
+    g_bench_types[5] = mecs_component_get_type_ptr(bench_comp_5);
+    g_bench_types[6] = mecs_component_get_type_ptr(bench_comp_6);
+    g_bench_types[7] = mecs_component_get_type_ptr(bench_comp_7);
+}
+
+/* Populate a registry where every entity has the first component and every other component is added to one in
+   (100 / selectivity) entities. */
+registry_t* bench_registry_populate(mecs_size_t i_entities, mecs_size_t i_selectivity)
+{
+    registry_t* registry;
+    entity_t* entities;
+    mecs_size_t stride;
+    mecs_size_t i;
+    mecs_size_t type_idx;
+
+    registry = bench_registry_create();
+    entities = entity_create_array(registry, (mecs_entity_size_t)i_entities);
+    stride = 100 / i_selectivity;
+    for (i = 0; i < i_entities; ++i)
+    {
+        ((bench_comp_0*)mecs_component_add_impl(registry, entities[i], g_bench_types[0]))->v = (mecs_uint32_t)i;
+        if (i % stride != 0)
+        {
+            continue;
+        }
+        for (type_idx = 1; type_idx < BENCH_COMPONENT_COUNT; ++type_idx)
+        {
+            ((bench_comp_0*)mecs_component_add_impl(registry, entities[i], g_bench_types[type_idx]))->v = (mecs_uint32_t)i;
+        }
+    }
+    return registry;
+}
+
+/* --------------------------------------------------
+Benchmarks
+-------------------------------------------------- */
+/* Accessor loops, defined in access.c. */
+mecs_uint32_t bench_access_component_get(mecs_registry_t* io_registry, mecs_entity_t const* i_entities, mecs_size_t i_count, mecs_component_type_t* i_type);
+mecs_uint32_t bench_access_component_get_static(mecs_registry_t* io_registry, mecs_entity_t const* i_entities, mecs_size_t i_count);
+mecs_uint32_t bench_access_component_has(mecs_registry_t const* i_registry, mecs_entity_t const* i_entities, mecs_size_t i_count, mecs_component_type_t* i_type);
+mecs_uint32_t bench_access_query_component_get(mecs_registry_t* io_registry, mecs_query_it_t* io_query_it, mecs_component_type_t** i_types, mecs_size_t i_type_count);
+
+void bench_entity_create_array(mecs_size_t i_entities)
+{
+    double samples[BENCH_REPETITIONS];
+    registry_t* registry;
+    double start;
+    mecs_size_t rep;
+
+    for (rep = 0; rep < BENCH_REPETITIONS; ++rep)
+    {
+        registry = bench_registry_create();
+        start = bench_time_ns();
+        entity_create_array(registry, (mecs_entity_size_t)i_entities);
+        samples[rep] = bench_time_ns() - start;
+        registry_destroy(registry);
+    }
+    bench_report("entity_create_array", i_entities, 0, 100, samples);
+}
+
+void bench_component_add_remove(mecs_size_t i_entities)
+{
+    double samples_add[BENCH_REPETITIONS];
+    double samples_remove[BENCH_REPETITIONS];
+    registry_t* registry;
+    entity_t* entities;
+    double start;
+    mecs_size_t rep;
+    mecs_size_t i;
+
+    for (rep = 0; rep < BENCH_REPETITIONS; ++rep)
+    {
+        registry = bench_registry_create();
+        entities = entity_create_array(registry, (mecs_entity_size_t)i_entities);
+
+        start = bench_time_ns();
+        for (i = 0; i < i_entities; ++i)
+        {
+            mecs_component_add_impl(registry, entities[i], g_bench_types[0]);
+        }
+        samples_add[rep] = bench_time_ns() - start;
+
+        /* Remove in a strided order so the swap with the last element moves components around. */
+        start = bench_time_ns();
+        for (i = 0; i < i_entities; ++i)
+        {
+            mecs_component_remove_impl(registry, entities[(i * 7919) % i_entities], g_bench_types[0]);
+        }
+        samples_remove[rep] = bench_time_ns() - start;
+
+        registry_destroy(registry);
+    }
+    bench_report("component_add", i_entities, 1, 100, samples_add);
+    bench_report("component_remove", i_entities, 1, 100, samples_remove);
+}
+
+/* Same as component_add with the store and entities reserved first, as a level load would. */
+void bench_component_add_reserved(mecs_size_t i_entities)
+{
+    double samples[BENCH_REPETITIONS];
+    registry_t* registry;
+    entity_t* entities;
+    double start;
+    mecs_size_t rep;
+    mecs_size_t i;
+
+    for (rep = 0; rep < BENCH_REPETITIONS; ++rep)
+    {
+        registry = bench_registry_create();
+        registry_reserve_entities(registry, (mecs_entity_size_t)i_entities);
+        entities = entity_create_array(registry, (mecs_entity_size_t)i_entities);
+
+        start = bench_time_ns();
+        mecs_component_reserve_impl(registry, g_bench_types[0], (mecs_entity_size_t)i_entities);
+        mecs_component_reserve_ids_impl(registry, g_bench_types[0], entity_get_id(entities[0]), (mecs_entity_size_t)i_entities);
+        for (i = 0; i < i_entities; ++i)
+        {
+            mecs_component_add_impl(registry, entities[i], g_bench_types[0]);
+        }
+        samples[rep] = bench_time_ns() - start;
+        registry_destroy(registry);
+    }
+    bench_report("component_add_reserved", i_entities, 1, 100, samples);
+}
+
+void bench_entity_destroy(mecs_size_t i_entities)
+{
+    double samples[BENCH_REPETITIONS];
+    registry_t* registry;
+    entity_t* entities;
+    double start;
+    mecs_size_t rep;
+    mecs_size_t i;
+
+    for (rep = 0; rep < BENCH_REPETITIONS; ++rep)
+    {
+        registry = bench_registry_populate(i_entities, 50);
+        entities = registry->entities;
+        start = bench_time_ns();
+        for (i = 0; i < i_entities; ++i)
+        {
+            entity_destroy(registry, entities[i]);
+        }
+        samples[rep] = bench_time_ns() - start;
+        registry_destroy(registry);
+    }
+    bench_report("entity_destroy", i_entities, BENCH_COMPONENT_COUNT, 50, samples);
+}
+
+void bench_entity_destroy_array(mecs_size_t i_entities)
+{
+    double samples[BENCH_REPETITIONS];
+    registry_t* registry;
+    entity_t* entities;
+    double start;
+    mecs_size_t rep;
+
+    for (rep = 0; rep < BENCH_REPETITIONS; ++rep)
+    {
+        registry = bench_registry_populate(i_entities, 50);
+        entities = (entity_t*)malloc(sizeof(entity_t) * i_entities);
+        memcpy(entities, registry->entities, i_entities * sizeof(entity_t));
+        start = bench_time_ns();
+        entity_destroy_array(registry, entities, (mecs_entity_size_t)i_entities);
+        samples[rep] = bench_time_ns() - start;
+        free(entities);
+        registry_destroy(registry);
+    }
+    bench_report("entity_destroy_array", i_entities, BENCH_COMPONENT_COUNT, 50, samples);
+}
+
+void bench_query(mecs_size_t i_entities, mecs_size_t i_selectivity)
+{
+    double samples[BENCH_REPETITIONS];
+    registry_t* registry;
+    query_it_t query;
+    mecs_uint32_t sum;
+    double start;
+    mecs_size_t args;
+    mecs_size_t rep;
+    mecs_size_t i;
+
+    registry = bench_registry_populate(i_entities, i_selectivity);
+    for (args = 1; args <= BENCH_COMPONENT_COUNT; ++args)
+    {
+        for (rep = 0; rep < BENCH_REPETITIONS; ++rep)
+        {
+            sum = 0;
+            start = bench_time_ns();
+            query = query_create();
+            for (i = 0; i < args; ++i)
+            {
+                mecs_query_with_impl(&query, g_bench_types[i]);
+            }
+            for (query_begin(registry, &query); query_next(&query);)
+            {
+                sum += ((bench_comp_0*)mecs_query_component_get_impl(&query, g_bench_types[0], 0))->v;
+            }
+            samples[rep] = bench_time_ns() - start;
+            g_bench_sink += sum;
+        }
+        bench_report("query_next", i_entities, args, i_selectivity, samples);
+    }
+
+    /* Every entity has the base component, so all of them are candidates and only those without the second one match. */
+    for (rep = 0; rep < BENCH_REPETITIONS; ++rep)
+    {
+        sum = 0;
+        start = bench_time_ns();
+        query = query_create();
+        mecs_query_with_impl(&query, g_bench_types[0]);
+        mecs_query_without_impl(&query, g_bench_types[1]);
+        for (query_begin(registry, &query); query_next(&query);)
+        {
+            sum += ((bench_comp_0*)mecs_query_component_get_impl(&query, g_bench_types[0], 0))->v;
+        }
+        samples[rep] = bench_time_ns() - start;
+        g_bench_sink += sum;
+    }
+    bench_report("query_next_without", i_entities, 2, 100 - i_selectivity, samples);
+    registry_destroy(registry);
+}
+
+/* Random access through component_get/has and per entity access inside a query, which pay a function call per access
+   unless MECS_INLINE_ACCESSORS is defined. */
+void bench_accessors(mecs_size_t i_entities)
+{
+    double samples_get[BENCH_REPETITIONS];
+    double samples_get_static[BENCH_REPETITIONS];
+    double samples_has[BENCH_REPETITIONS];
+    double samples_query[BENCH_REPETITIONS];
+    registry_t* registry;
+    entity_t* entities;
+    query_it_t query;
+    mecs_size_t entities_len;
+    double start;
+    mecs_size_t rep;
+    mecs_size_t i;
+
+    registry = bench_registry_populate(i_entities, 50);
+    entities = (entity_t*)malloc(sizeof(entity_t) * i_entities);
+    entities_len = 0;
+    query = query_create();
+    mecs_query_with_impl(&query, g_bench_types[0]);
+    for (query_begin(registry, &query); query_next(&query);)
+    {
+        entities[entities_len++] = query_entity_get(&query);
+    }
+
+    query = query_create();
+    for (i = 0; i < 4; ++i)
+    {
+        mecs_query_with_impl(&query, g_bench_types[i]);
+    }
+
+    for (rep = 0; rep < BENCH_REPETITIONS; ++rep)
+    {
+        start = bench_time_ns();
+        g_bench_sink += bench_access_component_get(registry, entities, entities_len, g_bench_types[0]);
+        samples_get[rep] = bench_time_ns() - start;
+
+        start = bench_time_ns();
+        g_bench_sink += bench_access_component_get_static(registry, entities, entities_len);
+        samples_get_static[rep] = bench_time_ns() - start;
+
+        start = bench_time_ns();
+        g_bench_sink += bench_access_component_has(registry, entities, entities_len, g_bench_types[1]);
+        samples_has[rep] = bench_time_ns() - start;
+
+        start = bench_time_ns();
+        g_bench_sink += bench_access_query_component_get(registry, &query, g_bench_types, 4);
+        samples_query[rep] = bench_time_ns() - start;
+    }
+    free(entities);
+    registry_destroy(registry);
+    bench_report("component_get", i_entities, 1, 100, samples_get);
+    bench_report("component_get_static", i_entities, 1, 100, samples_get_static);
+    bench_report("component_has", i_entities, 1, 50, samples_has);
+    bench_report("query_component_get", i_entities, 4, 50, samples_query);
+}
+
+#if defined(__cplusplus) && __cplusplus >= 201103L /* C++11 */
+/* Same access pattern as query_component_get through a typed view, which fetches components without the query arguments. */
+void bench_view(mecs_size_t i_entities)
+{
+    double samples[BENCH_REPETITIONS];
+    registry_t* registry;
+    mecs_uint32_t sum;
+    double start;
+    mecs_size_t rep;
+
+    registry = bench_registry_populate(i_entities, 50);
+    for (rep = 0; rep < BENCH_REPETITIONS; ++rep)
+    {
+        sum = 0;
+        start = bench_time_ns();
+        mecs::view<mecs::with<bench_comp_0, bench_comp_1, bench_comp_2, bench_comp_3> >(registry).each([&](entity_t i_entity, bench_comp_0& i_comp0, bench_comp_1& i_comp1, bench_comp_2& i_comp2, bench_comp_3& i_comp3)
+        {
+            sum += mecs_entity_get_id(i_entity) + i_comp0.v + i_comp1.v + i_comp2.v + i_comp3.v;
+        });
+        samples[rep] = bench_time_ns() - start;
+        g_bench_sink += sum;
+    }
+    registry_destroy(registry);
+    bench_report("view_each", i_entities, 4, 50, samples);
+}
+#endif
+
+void bench_serialise_binary(mecs_size_t i_entities)
+{
+    double samples_serialise[BENCH_REPETITIONS];
+    double samples_deserialise[BENCH_REPETITIONS];
+    registry_t* registry0;
+    registry_t* registry1;
+    void* buffer;
+    mecs_size_t buffer_size;
+    double start;
+    mecs_size_t rep;
+
+    registry0 = bench_registry_populate(i_entities, 50);
+    for (rep = 0; rep < BENCH_REPETITIONS; ++rep)
+    {
+        start = bench_time_ns();
+        serialise_registry_binary(registry0, &buffer, &buffer_size);
+        samples_serialise[rep] = bench_time_ns() - start;
+
+        registry1 = bench_registry_create();
+        start = bench_time_ns();
+        deserialise_registry_binary(registry1, buffer, buffer_size);
+        samples_deserialise[rep] = bench_time_ns() - start;
+
+        registry_destroy(registry1);
+        free(buffer); /* Allocated with the default mecs_realloc. */
+    }
+    registry_destroy(registry0);
+    bench_report("serialise_registry_binary", i_entities, BENCH_COMPONENT_COUNT, 50, samples_serialise);
+    bench_report("deserialise_registry_binary", i_entities, BENCH_COMPONENT_COUNT, 50, samples_deserialise);
+}
+
+int main(int argc, char** argv)
+{
+    static mecs_size_t const entity_counts[] = { 1000, 10000, 60000 };
+    static mecs_size_t const selectivities[] = { 100, 50, 10 };
+    mecs_size_t entities_idx;
+    mecs_size_t selectivity_idx;
+    mecs_size_t entities;
+
+    bench_types_init();
+    for (entities_idx = 0; entities_idx < sizeof(entity_counts) / sizeof(entity_counts[0]); ++entities_idx)
+    {
+        entities = entity_counts[entities_idx];
+        bench_entity_create_array(entities);
+        bench_component_add_remove(entities);
+        bench_component_add_reserved(entities);
+        bench_entity_destroy(entities);
+        bench_entity_destroy_array(entities);
+        for (selectivity_idx = 0; selectivity_idx < sizeof(selectivities) / sizeof(selectivities[0]); ++selectivity_idx)
+        {
+            bench_query(entities, selectivities[selectivity_idx]);
+        }
+        bench_accessors(entities);
+        #if defined(__cplusplus) && __cplusplus >= 201103L /* C++11 */
+            bench_view(entities);
+        #endif
+        bench_serialise_binary(entities);
+    }
+
+    if (argc > 1 && strcmp(argv[1], "--json") == 0)
+    {
+        bench_print_json();
+    }
+    else
+    {
+        bench_print_csv();
+    }
+    return 0;
+}
+
+#define MECS_IMPLEMENTATION
+#include "../mecs.h"
+#include "../mecs_serialisation.h"
@@ -16,6 +16,9 @@ Table:
         1.2) Components
         1.3) Entities
         1.4) Queries
+        1.5) Jobs
+        1.6) Indexes
+        1.7) Hierarchy
     2.) Compile time options
     3.) Standard library compile time options
 
@@ -28,6 +31,42 @@ Table:
         registry_t* registry_create(mecs_component_size_t i_component_count_reserve)
         void registry_destroy(registry_t* io_registry)
 
+    registry_get_stats
+    component_store_get_stats
+        void registry_get_stats(registry_t const* i_registry, registry_stats_t* o_stats, component_store_stats_t* o_component_stats)
+        void component_store_get_stats(component_store_t const* i_component_store, component_store_stats_t* o_stats)
+
+        Reports the memory used by a registry and how well it is occupied. If o_component_stats is not NULL it must
+        hold components_len entries, entries of unregistered components are zeroed. Counting non-empty sparse blocks
+        and the entity free list walks their memory, so avoid calling this every frame. With MECS_THREAD_SAFE the
+        stats also count how often a lock had to be waited for, since the registry was created.
+
+    registry_merge
+    registry_merge_entities
+        void registry_merge(registry_t* io_dst, registry_t* io_src, entity_t* o_remap)
+        void registry_merge_entities(registry_t* io_dst, registry_t* io_src, entity_t const* i_entities, mecs_entity_size_t i_count, entity_t* o_entities)
+
+        Moves entities and their components from io_src into io_dst, such as a level streamed in on a loader thread.
+        The moved entities get new ids in io_dst and are destroyed in io_src. registry_merge moves every entity, when
+        io_dst doesn't end part way into a component page the pages of io_src are handed over without moving any
+        component. If o_remap is not NULL it must hold io_src->entities_len entries, it receives the new entity for
+        each id of io_src and MECS_ENTITY_INVALID for destroyed ids. registry_merge_entities moves i_count entities,
+        writing their new entities to o_entities, hierarchy links to entities which aren't moved are cut. Components
+        must be registered with both registries.
+
+    registry_reserve_entities
+        void registry_reserve_entities(registry_t* io_registry, mecs_entity_size_t i_count)
+
+        Grows the array of entities once so i_count more entities can be created without growing it, such as before
+        loading a level. Destroyed entities are reused first, so the reserve may last longer.
+
+    registry_clear
+        void registry_clear(registry_t* io_registry)
+
+        Destroys every entity and component, keeping all memory allocated so refilling the registry doesn't allocate
+        until it outgrows what it held before. Ids are handed out again from the start with their generation bumped, so
+        entities from before the clear report as destroyed. Indexes stay attached and are emptied.
+
 1.2) COMPONENTS
 
     COMPONENT_DECLARE
@@ -35,12 +74,44 @@ Table:
         void COMPONENT_DECLARE(T)
         void COMPONENT_REGISTER(registry_t* io_registry, T)
 
+        In C++, unless MECS_NO_DEFAULT_REGISTER_CPP_LIFETIME is defined, the constructor, destructor, move and copy
+        constructor of T are registered as hooks. Each hook is left out when T is trivial for it, so the component is
+        left uninitialised, isn't destructed, or is relocated or copied with memcpy instead. Before C++11 this can't
+        be detected, so specialise mecs_is_trivially_constructible, mecs_is_trivially_destructible,
+        mecs_is_trivially_relocatable or mecs_is_trivially_copyable with enum { value = 1 } for a component to opt in.
+
     COMPONENT_REGISTER_LIFE_TIME_HOOKS
         void COMPONENT_REGISTER_LIFE_TIME_HOOKS(registry_t* io_registry, T, mecs_ctor_func_t i_ctor_func_ptr, mecs_dtor_func_t i_dtor_func_ptr, mecs_move_and_dtor_func_t i_move_and_dtor_func_ptr)
         void mecs_ctor_func_t(void* io_data)
         void mecs_dtor_func_t(void* io_data)
         void mecs_move_and_dtor_func_t(void* io_src_to_move, void* io_dst_to_destruct)
 
+    COMPONENT_REGISTER_COPY_HOOK
+        void COMPONENT_REGISTER_COPY_HOOK(T, mecs_copy_func_t i_copy_func_ptr)
+        void mecs_copy_func_t(void* o_dst, void const* i_src)
+
+        Constructs a copy of a component into uninitialised memory when cloning entities, components without a copy
+        hook are copied with memcpy. In C++ the copy constructor is registered by default for components which aren't
+        trivially copyable, copying a component without copy constructor asserts.
+
+    COMPONENT_REGISTER_STORAGE
+    component_compact
+        void COMPONENT_REGISTER_STORAGE(T, mecs_storage_t i_storage)
+        void component_compact(registry_t* io_registry, T)
+
+        Removing a component of MECS_STORAGE_PACKED, the default, moves the last component of its store into the
+        hole. Removing a component of MECS_STORAGE_STABLE destructs it in place and leaves a tombstone, which a later
+        component_add fills, so pointers to components stay valid and large components are never moved. Queries and
+        views skip tombstones. component_compact moves components into the tombstones of a store, after which pointers
+        to its components are invalid. Merging registries compacts the stores of io_src. The storage must be chosen
+        before a component is added, the hierarchy component is always packed.
+
+    component_clear
+        void component_clear(registry_t* io_registry, T)
+
+        Removes the component from every entity. Destructors run in a single pass over the store and are skipped for
+        components without one, the allocated sparse blocks are reset and all pages are kept for reuse.
+
     component_add
     component_remove
         T* component_add(registry_t* io_registry, entity_t i_entity, T)
@@ -52,6 +123,46 @@ Table:
     component_get
         T* component_get(registry_t* io_registry, entity_t i_entity, T)
 
+    component_reserve
+    component_reserve_ids
+        void component_reserve(registry_t* io_registry, T, mecs_entity_size_t i_count)
+        void component_reserve_ids(registry_t* io_registry, T, mecs_entity_id_t i_first_id, mecs_entity_size_t i_count)
+
+        component_reserve allocates the dense array and component pages so i_count more components can be added
+        without allocating. component_reserve_ids allocates the sparse blocks mapping the entity ids i_first_id up to
+        i_first_id + i_count, such as the ids of entities just created for a level. Both only ever grow a store.
+
+    component_name_hash
+    component_find_by_name_hash
+        mecs_uint32_t component_name_hash(char const* i_name)
+        mecs_component_type_t* component_find_by_name_hash(registry_t const* i_registry, mecs_uint32_t i_name_hash)
+
+        Components registered with a registry can be looked up in O(1) by a hash of the name they were registered
+        with. The hash is stable between builds as long as the name passed to COMPONENT_REGISTER does not change.
+        Components whose names share a hash are registered as usual, but can't be told apart by their hash, so
+        looking up that hash returns NULL and out of order deserialisation skips their data.
+
+    STATIC_COMPONENTS_DECLARE
+    STATIC_COMPONENTS_REGISTER
+    component_has_static
+    component_get_static
+        void STATIC_COMPONENTS_DECLARE(LIST)
+        void STATIC_COMPONENTS_REGISTER(registry_t* io_registry, LIST)
+        bool component_has_static(i_registry, entity_t i_entity, T)
+        T* component_get_static(registry_t* io_registry, entity_t i_entity, T)
+
+        Assigns ids at compile time to a set of components listed by an X-macro, such as
+        #define GAME_COMPONENTS(X) X(position) X(velocity). STATIC_COMPONENTS_DECLARE defines the constants
+        MECS_STATIC_COMPONENT_ID(T) and LIST##_COUNT. STATIC_COMPONENTS_REGISTER registers the components in order and
+        must come before any other component is registered, with registries created with a reserve of LIST##_COUNT.
+        The accessors index the component stores with a constant, which is folded into the access when
+        MECS_INLINE_ACCESSORS is defined. Types must be named by a single identifier, typedef namespaced C++ types.
+
+    component_has_by_id
+    component_get_by_id
+        bool component_has_by_id(i_registry, entity_t i_entity, mecs_component_id_t i_id)
+        void* component_get_by_id(registry_t* io_registry, entity_t i_entity, mecs_component_id_t i_id)
+
 1.3) ENTITIES
     entity_get_id
     entity_get_generation
@@ -63,9 +174,36 @@ Table:
         entity_t entity_create(registry_t* io_registry)
         void entity_destroy(registry_t* io_registry, entity_t i_entity)
 
+    entity_create_array
+    entity_create_array_copy
+        entity_t* entity_create_array(registry_t* io_registry, mecs_entity_size_t i_count)
+        bool entity_create_array_copy(registry_t* io_registry, mecs_entity_size_t i_count, entity_t* o_entities)
+
+        Creates i_count entities with consecutive ids. entity_create_array returns them as part of the array of
+        entities, valid until the next entity is created. entity_create_array_copy writes them to o_entities instead,
+        which is safe with MECS_THREAD_SAFE while other threads create entities. Both fail if the ids run out.
+
+    entity_destroy_array
+        mecs_size_t entity_destroy_array(registry_t* io_registry, entity_t const* i_entities, mecs_entity_size_t i_count)
+
+        Destroys i_count entities at once, such as when unloading a level, returning how many were destroyed.
+        Destroyed entities and duplicates are skipped. Each component store removes the components of all destroyed
+        entities in a single pass over its dense array, unless only a few of its entities are affected, and all ids
+        are pushed onto the list of destroyed entities together.
+
     entity_is_destroyed
         bool entity_is_destroyed(registry_t* io_registry, entity_t i_entity)
 
+    entity_clone
+    entity_instantiate
+        void entity_clone(registry_t* io_registry, entity_t i_entity, mecs_entity_size_t i_count, entity_t* o_entities)
+        void entity_instantiate(registry_t* io_registry, registry_t* i_prefab_registry, entity_t i_prefab, mecs_entity_size_t i_count, entity_t* o_entities)
+
+        Creates i_count entities holding a copy of every component of i_entity, writing them to o_entities. Each
+        component store grows once for all copies. entity_instantiate copies from an entity in another registry, such
+        as a registry only holding prefabs, whose components must also be registered with io_registry. Copies of a 
+        hierarchy component start out without parent or children.
+
 1.4) QUERIES
     query_create
         query_it_t query_create()
@@ -79,10 +217,31 @@ Table:
     query_optional
         void query_optional(query_it_t* io_query_it, T)
 
+    query_any_of
+        void query_any_of(query_it_t* io_query_it, T, mecs_uint32_t i_group)
+
+        Matches entities which have at least one of the components added with the same i_group, below 32. Several
+        groups combine with AND, so (A or B) and (C or D) uses two groups. When the components of a group hold fewer
+        entities in total than the smallest with argument, the iterator walks each of their dense arrays in turn and
+        skips entities already visited through an earlier component of the group. A none-of group is a query_without
+        per component.
+
+    query_destroy
+        void query_destroy(query_it_t* io_query_it)
+
+        Queries store up to MECS_QUERY_LOCAL_LEN arguments inline, longer queries move their arguments to the heap and
+        must be destroyed. Arguments must not be added after query_begin.
+
     query_begin
     query_next
+    query_end
         void query_begin(registry_t* io_registry, query_it_t* io_query_it)
         bool query_next(mecs_query_it_t* io_query_it)
+        void query_end(mecs_query_it_t* io_query_it)
+
+        With MECS_THREAD_SAFE query_begin read locks the component stores of all arguments until query_next returns
+        false, so the loop must not add or remove components of those types. A loop left early must call query_end to
+        release them. query_end does nothing otherwise.
 
     query_entity_get
         entity_t query_entity_get(query_it_t* io_query_it)
@@ -93,6 +252,78 @@ Table:
     query_component_get
         T* query_component_get(query_it_t* io_query_it, T, mecs_size_t i_index)
 
+    mecs::view (C++11)
+        mecs::view<mecs::with<A, B>, mecs::without<C>>(registry_t* io_registry).each([](entity_t i_entity, A& io_a, B& io_b) {})
+
+        Typed query resolving its component stores when each is called, the smallest with component store is the base.
+        The function is inlined into a loop over the base dense array and receives a reference to each with component.
+        Components of the viewed types must not be added or removed from within the function.
+
+1.5) JOBS
+    parallel_for_sequential
+        void parallel_for_sequential(void* io_user_data, mecs_job_func_t i_job_func, void* io_job_data, mecs_size_t i_job_count)
+        void mecs_job_func_t(void* io_job_data, mecs_size_t i_job_index)
+        void mecs_parallel_for_func_t(void* io_user_data, mecs_job_func_t i_job_func, void* io_job_data, mecs_size_t i_job_count)
+
+1.6) INDEXES
+    index_create
+    index_destroy
+        index_t* index_create(registry_t* io_registry, T, mecs_index_kind_t i_kind, mecs_index_key_func_t i_key_func)
+        void index_destroy(index_t* io_index)
+        mecs_uint64_t mecs_index_key_func_t(void const* i_component)
+
+        Creates an index over the keys i_key_func extracts from each component of type T, owned by the registry and
+        destroyed along with it. MECS_INDEX_KIND_HASH_UNIQUE and MECS_INDEX_KIND_HASH_MULTI find entities by key in
+        O(1), where a unique index asserts when a second entity is indexed with the same key. MECS_INDEX_KIND_ORDERED 
+        keeps entities sorted by key to allow range lookups, at the cost of O(n) inserts and removals.
+
+    index_update
+        void index_update(registry_t* io_registry, entity_t i_entity, T)
+
+        Components are indexed with the key they hold on the first lookup after being added, so keys written right
+        after component_add are picked up, and leave the index when they are removed or their entity is destroyed.
+        Changing the key of an indexed component requires calling index_update to move it within the index.
+
+    index_find
+    index_find_all
+    index_find_range
+        entity_t index_find(index_t* io_index, mecs_uint64_t i_key)
+        mecs_size_t index_find_all(index_t* io_index, mecs_uint64_t i_key, entity_t* o_entities, mecs_size_t i_capacity)
+        mecs_size_t index_find_range(index_t* io_index, mecs_uint64_t i_min, mecs_uint64_t i_max, entity_t* o_entities, mecs_size_t i_capacity)
+
+        index_find returns an entity indexed with the key or MECS_ENTITY_INVALID. index_find_all and the ordered
+        only index_find_range write up to i_capacity entities and return how many there are in total.
+
+1.7) HIERARCHY
+    hierarchy_t
+        Builtin component linking an entity to its parent, first child and siblings. Register it with
+        COMPONENT_REGISTER(registry, mecs_hierarchy_t) to use the functions below.
+
+    hierarchy_set_parent
+    hierarchy_get_parent
+        void hierarchy_set_parent(registry_t* io_registry, entity_t i_child, entity_t i_parent)
+        entity_t hierarchy_get_parent(registry_t* io_registry, entity_t i_entity)
+
+        Attaches a child as the first child of a parent, or makes it a root when i_parent is MECS_ENTITY_INVALID. Adds
+        the hierarchy component to both entities if needed. Removing the hierarchy component, or destroying its entity,
+        detaches the entity from its parent and turns its children into roots.
+
+    hierarchy_begin
+    hierarchy_next
+        void hierarchy_begin(registry_t* io_registry, hierarchy_it_t* o_hierarchy_it)
+        bool hierarchy_next(hierarchy_it_t* io_hierarchy_it)
+
+        Visits every entity in the hierarchy, parents before their children and each subtree in one contiguous run. 
+        hierarchy_begin sorts the dense array of the hierarchy component depth first when the hierarchy changed, so the
+        iteration walks memory in order. The entity and its hierarchy component are available as the entity and 
+        hierarchy members of the iterator. The hierarchy must not change while iterating.
+
+    hierarchy_destroy_recursive
+        void hierarchy_destroy_recursive(registry_t* io_registry, entity_t i_entity)
+
+        Destroys an entity along with all its descendants. Links within the subtree are cut up front, so each entity is
+        destroyed without walking its siblings or children.
+
 2.) COMPILE TIME OPTIONS
 
     #define MECS_PAGE_LEN_SPARSE
@@ -107,6 +338,14 @@ Table:
         Define how many components should be helt per page of the dense array.
         Defaults to 512 items.
 
+    #define MECS_QUERY_BATCH
+        Must be defined globally.
+
+        Define how many candidate entities query_next matches at once, at
+        most 32. Each with and without argument is tested for the whole batch
+        in a loop without branches, which compilers can vectorise. Queries
+        with any of arguments match one entity at a time. Defaults to 16.
+
     #define MECS_NO_SHORT_NAMES
         Must be defined globally.
         
@@ -124,6 +363,49 @@ Table:
 
         Allows to disable support for serialisation and deserialisation of components.
 
+    #define MECS_QUERY_STATS
+        Must be defined globally.
+
+        Allows queries to count the entities they scanned, the entities they
+        matched and the sparse arrays they probed, reset by query_begin. A low
+        ratio of matched to scanned entities indicates a query worth
+        restructuring. A with or without argument probes all candidates of a
+        batch unless an earlier argument ruled out the whole batch. Default
+        undefined.
+
+    #define MECS_INLINE_ACCESSORS
+        Must be defined globally.
+
+        Defines component_has, component_get, entity_get_id, the query
+        component getters and their sparse/dense helpers as static inline
+        functions in every file including mecs.h, so hot loops don't pay a
+        function call per access without link time optimisation. The asserts
+        inside them follow the NDEBUG or mecs_assert of the including file.
+        Default undefined.
+
+    #define MECS_THREAD_SAFE
+        Must be defined globally.
+
+        Gives each component store a reader/writer spin lock, and the
+        registry one for its entities. component_has, component_get, queries
+        and views read lock the stores they access, so any number of threads
+        can access stores concurrently while none of them adds or removes
+        components. component_add, component_remove and index lookups, which
+        may update the index, write lock their store. Entities are created
+        and destroyed without locks, popping and pushing the list of
+        destroyed entities and bumping entities_len with atomics. Only
+        growing the array of entities waits for other threads creating or
+        destroying entities, and may move the array returned by
+        entity_create_array at any time, so use entity_create_array_copy. Destroying entities removes
+        their components before touching the list, so entities can be created
+        within a query. Readers only wait while a writer holds a lock,
+        so a thread may read lock a store it already read locked, but must
+        not add or remove components of a store it is iterating. Components
+        returned by component_get stay valid until a component of their
+        store is removed. Registering components, merging registries,
+        creating indexes and changing the hierarchy are not synchronised.
+        Default undefined.
+
 3.) STANDARD LIBRARY COMPILE TIME OPTIONS
 
     #define mecs_uint8_t 
@@ -158,15 +440,41 @@ Table:
         that on compilers/platforms that have build in support. 
         
     #define MECS_CHAR_BIT
-        Must be defined by the file containing #define MECS_IMPLEMENTATION.
+        Must be defined by the file containing #define MECS_IMPLEMENTATION, or
+        globally when MECS_INLINE_ACCESSORS is defined.
 
         Defaults to "limits.h" or "climits". Can be used to provide your own
         implementation for how many bits are in a byte on platforms that don't
         support this through the C/C++ standard library.
 
-    #define mecs_assert(i_condition)
+    #define mecs_atomic_add(io_value, i_add)
+    #define mecs_atomic_cas(io_value, i_expected, i_desired)
+    #define mecs_atomic_load(i_value)
+    #define mecs_atomic_store(io_value, i_value)
+    #define mecs_pause()
+        Must be defined globally when MECS_THREAD_SAFE is defined.
+
+        Defaults to the atomic builtins of GCC, Clang and MSVC. Operate on a
+        mecs_uint32_t, add returns the previous value and cas whether it
+        replaced i_expected, all with full barriers. mecs_pause hints the CPU
+        while spinning. If you define one, you must define all.
+
+    #define mecs_profile_begin(i_name)
+    #define mecs_profile_end(i_name)
         Must be defined by the file containing #define MECS_IMPLEMENTATION.
 
+        Defaults to nothing. Called with a string literal naming the function
+        at the start and end of queries, adding and removing components,
+        destroying entities and (de)serialisation. Can be used to forward these
+        to a profiler, for example Tracy:
+            #define mecs_profile_begin(i_name) TracyCZoneN(mecs_zone, i_name, 1)
+            #define mecs_profile_end(i_name) TracyCZoneEnd(mecs_zone)
+        If you define one, you must define the other.
+
+    #define mecs_assert(i_condition)
+        Must be defined by the file containing #define MECS_IMPLEMENTATION, or
+        globally when MECS_INLINE_ACCESSORS is defined.
+
         Defaults to "assert.h" or "cassert". Mecs heavily depend on asserts for
         error checking. Can be used to provide your own assert implementation.
 
@@ -200,10 +508,24 @@ V1, 10-Nov-2023, Initial version released.
 #define COMPONENT_DECLARE                       MECS_COMPONENT_DECLARE                                                  
 #define COMPONENT_REGISTER                      MECS_COMPONENT_REGISTER                                                   
 #define COMPONENT_REGISTER_LIFE_TIME_HOOKS      MECS_COMPONENT_REGISTER_LIFE_TIME_HOOKS                                                                                
+#define COMPONENT_REGISTER_COPY_HOOK            MECS_COMPONENT_REGISTER_COPY_HOOK
+#define COMPONENT_REGISTER_STORAGE              MECS_COMPONENT_REGISTER_STORAGE
 #define component_add                           mecs_component_add                                                              
 #define component_remove                        mecs_component_remove                                                                 
 #define component_has                           mecs_component_has                                                              
 #define component_get                           mecs_component_get                                                              
+#define component_reserve                       mecs_component_reserve
+#define component_reserve_ids                   mecs_component_reserve_ids
+#define component_compact                       mecs_component_compact
+#define component_clear                         mecs_component_clear
+#define component_name_hash                     mecs_component_name_hash
+#define component_find_by_name_hash             mecs_component_find_by_name_hash
+#define STATIC_COMPONENTS_DECLARE               MECS_STATIC_COMPONENTS_DECLARE
+#define STATIC_COMPONENTS_REGISTER              MECS_STATIC_COMPONENTS_REGISTER
+#define component_has_static                    mecs_component_has_static
+#define component_get_static                    mecs_component_get_static
+#define component_has_by_id                     mecs_component_has_by_id
+#define component_get_by_id                     mecs_component_get_by_id
 
 #define entity_t                                mecs_entity_t                                         
 #define entity_id_t                             mecs_entity_id_t                                            
@@ -212,23 +534,57 @@ V1, 10-Nov-2023, Initial version released.
 #define entity_get_generation                   mecs_entity_get_generation                                                        
 #define entity_create                           mecs_entity_create                                        
 #define entity_create_array                     mecs_entity_create_array                                        
+#define entity_create_array_copy                mecs_entity_create_array_copy
 #define entity_destroy                          mecs_entity_destroy                                          
+#define entity_destroy_array                    mecs_entity_destroy_array
 #define entity_is_destroyed                     mecs_entity_is_destroyed                                                    
+#define entity_clone                            mecs_entity_clone
+#define entity_instantiate                      mecs_entity_instantiate
 
 #define registry_t                              mecs_registry_t
 #define registry_create                         mecs_registry_create                                            
 #define registry_destroy                        mecs_registry_destroy                                              
+#define registry_merge                          mecs_registry_merge
+#define registry_merge_entities                 mecs_registry_merge_entities
+#define registry_reserve_entities               mecs_registry_reserve_entities
+#define registry_clear                          mecs_registry_clear
 
 #define query_it_t                              mecs_query_it_t
 #define query_with                              mecs_query_with                                  
 #define query_without                           mecs_query_without                                        
 #define query_optional                          mecs_query_optional                                          
+#define query_any_of                            mecs_query_any_of
+#define query_destroy                           mecs_query_destroy
 #define query_create                            mecs_query_create
 #define query_begin                             mecs_query_begin
 #define query_next                              mecs_query_next
+#define query_end                               mecs_query_end
 #define query_entity_get                        mecs_query_entity_get
 #define query_component_has                     mecs_query_component_has                                                    
 #define query_component_get                     mecs_query_component_get                                                     
+
+#define parallel_for_sequential                 mecs_parallel_for_sequential
+
+#define index_t                                 mecs_index_t
+#define index_create                            mecs_index_create
+#define index_destroy                           mecs_index_destroy
+#define index_update                            mecs_index_update
+#define index_find                              mecs_index_find
+#define index_find_all                          mecs_index_find_all
+#define index_find_range                        mecs_index_find_range
+
+#define hierarchy_t                             mecs_hierarchy_t
+#define hierarchy_it_t                          mecs_hierarchy_it_t
+#define hierarchy_set_parent                    mecs_hierarchy_set_parent
+#define hierarchy_get_parent                    mecs_hierarchy_get_parent
+#define hierarchy_begin                         mecs_hierarchy_begin
+#define hierarchy_next                          mecs_hierarchy_next
+#define hierarchy_destroy_recursive             mecs_hierarchy_destroy_recursive
+
+#define registry_stats_t                        mecs_registry_stats_t
+#define component_store_stats_t                 mecs_component_store_stats_t
+#define registry_get_stats                      mecs_registry_get_stats
+#define component_store_get_stats               mecs_component_store_get_stats
 #endif
 
 /* --------------------------------------------------
@@ -241,6 +597,7 @@ Definition of compiler and platform agnostic standard library types/functions.
         #error "You must define all of mecs_uint8_t, mecs_uint16_t, mecs_uint32_t, mecs_uint64_t and mecs_size_t."
     #endif
 #elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L /* C99 */
+    #include <stddef.h>
     #include <stdint.h>
     typedef uint8_t             mecs_uint8_t;
     typedef uint16_t            mecs_uint16_t;
@@ -248,17 +605,34 @@ Definition of compiler and platform agnostic standard library types/functions.
     typedef uint64_t            mecs_uint64_t;
     typedef size_t              mecs_size_t;
 #elif defined(__cplusplus) && __cplusplus >= 201103L /* C++11 */
+    #include <cstddef>
     #include <cstdint>
     typedef std::uint8_t        mecs_uint8_t;
     typedef std::uint16_t       mecs_uint16_t;
     typedef std::uint32_t       mecs_uint32_t;
     typedef std::uint64_t       mecs_uint64_t;
-    typedef size_t              mecs_size_t;
+    typedef std::size_t         mecs_size_t;
 #else
+    /* Pick the fixed size types based on the range of the built in types, long is 64 bits on LP64 platforms. */
+    #if defined(__cplusplus)
+        #include <cstddef>
+        #include <climits>
+    #else
+        #include <stddef.h>
+        #include <limits.h>
+    #endif
     typedef unsigned char       mecs_uint8_t;
     typedef unsigned short      mecs_uint16_t;
-    typedef unsigned long       mecs_uint32_t;
-    typedef unsigned long long  mecs_uint64_t;
+    #if UINT_MAX == 0xFFFFFFFFUL
+        typedef unsigned int    mecs_uint32_t;
+    #else
+        typedef unsigned long   mecs_uint32_t;
+    #endif
+    #if ULONG_MAX > 0xFFFFFFFFUL
+        typedef unsigned long   mecs_uint64_t;
+    #else
+        typedef unsigned long long mecs_uint64_t;
+    #endif
     typedef size_t              mecs_size_t;
 #endif
 
@@ -267,7 +641,12 @@ Definition of compiler and platform agnostic standard library types/functions.
     #if !defined(mecs_bool_t) || !defined(MECS_TRUE) || !defined(MECS_FALSE)
         #error "You must define all of mecs_bool_t, MECS_TRUE and MECS_FALSE."
     #endif
-#elif defined(__cplusplus) || (defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L) /* C++ or C99 */
+#elif defined(__cplusplus)
+    typedef bool            mecs_bool_t;
+    #define MECS_TRUE       true
+    #define MECS_FALSE      false
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L /* C99 */
+    #include <stdbool.h>
     typedef bool            mecs_bool_t;
     #define MECS_TRUE       true
     #define MECS_FALSE      false
@@ -342,6 +721,43 @@ Definition of compiler and platform agnostic standard library types/functions.
     #endif
 #endif
 
+/* Provide custom or default implementation of the atomics used by the locks of MECS_THREAD_SAFE. */
+#if defined(MECS_THREAD_SAFE)
+    #if defined(mecs_atomic_add) || defined(mecs_atomic_cas) || defined(mecs_atomic_load) || defined(mecs_atomic_store) || defined(mecs_pause)
+        #if !defined(mecs_atomic_add) || !defined(mecs_atomic_cas) || !defined(mecs_atomic_load) || !defined(mecs_atomic_store) || !defined(mecs_pause)
+            #error "You must define all of mecs_atomic_add, mecs_atomic_cas, mecs_atomic_load, mecs_atomic_store and mecs_pause."
+        #endif
+    #elif defined(_MSC_VER)
+        #include <intrin.h>
+        #define mecs_atomic_add(io_value, i_add)                    ((mecs_uint32_t)_InterlockedExchangeAdd((long volatile*)(io_value), (long)(i_add)))
+        #define mecs_atomic_cas(io_value, i_expected, i_desired)    (_InterlockedCompareExchange((long volatile*)(io_value), (long)(i_desired), (long)(i_expected)) == (long)(i_expected))
+        #define mecs_atomic_load(i_value)                           ((mecs_uint32_t)_InterlockedOr((long volatile*)(i_value), 0))
+        #define mecs_atomic_store(io_value, i_value)                ((void)_InterlockedExchange((long volatile*)(io_value), (long)(i_value)))
+        #if defined(_M_IX86) || defined(_M_X64)
+            #define mecs_pause()                                    _mm_pause()
+        #else
+            #define mecs_pause()                                    __yield()
+        #endif
+    #elif defined(__GNUC__)
+        #define mecs_atomic_add(io_value, i_add)                    __sync_fetch_and_add((io_value), (mecs_uint32_t)(i_add))
+        #define mecs_atomic_cas(io_value, i_expected, i_desired)    __sync_bool_compare_and_swap((io_value), (mecs_uint32_t)(i_expected), (mecs_uint32_t)(i_desired))
+        #if defined(__ATOMIC_SEQ_CST)
+            #define mecs_atomic_load(i_value)                       __atomic_load_n((i_value), __ATOMIC_SEQ_CST)
+            #define mecs_atomic_store(io_value, i_value)            __atomic_store_n((io_value), (mecs_uint32_t)(i_value), __ATOMIC_SEQ_CST)
+        #else
+            #define mecs_atomic_load(i_value)                       __sync_fetch_and_add((i_value), 0)
+            #define mecs_atomic_store(io_value, i_value)            do { __sync_synchronize(); *(io_value) = (i_value); __sync_synchronize(); } while (0)
+        #endif
+        #if defined(__i386__) || defined(__x86_64__)
+            #define mecs_pause()                                    __builtin_ia32_pause()
+        #else
+            #define mecs_pause()                                    __sync_synchronize()
+        #endif
+    #else
+        #error "MECS_THREAD_SAFE needs mecs_atomic_add, mecs_atomic_cas, mecs_atomic_load, mecs_atomic_store and mecs_pause for this compiler."
+    #endif
+#endif
+
 /* --------------------------------------------------
 Definition of the core library.
 -------------------------------------------------- */
@@ -373,16 +789,79 @@ typedef mecs_entity_t mecs_dense_t;
 #if !defined(MECS_PAGE_LEN_DENSE)
     #define MECS_PAGE_LEN_DENSE 512
 #endif
+#if !defined(MECS_QUERY_BATCH)
+    #define MECS_QUERY_BATCH 16
+#elif MECS_QUERY_BATCH < 1 || MECS_QUERY_BATCH > 32
+    #error "MECS_QUERY_BATCH must be between 1 and 32, a batch is matched into a 32 bit mask."
+#endif
 
 /* Hooks for callbacks regarding the lifetime of a component. In C++ we automatically register the constructor and destructor by default. */
 typedef void(*mecs_ctor_func_t)(void* io_data);
 typedef void(*mecs_dtor_func_t)(void* io_data);
 typedef void(*mecs_move_and_dtor_func_t)(void* io_src_to_move, void* io_dst_to_destruct);
+typedef void(*mecs_copy_func_t)(void* o_dst, void const* i_src);
 
 #if !defined(MECS_NO_DEFAULT_REGISTER_CPP_LIFETIME) && defined(__cplusplus)
     template<typename T> void mecs_ctor_cpp_impl(void* io_data);
     template<typename T> void mecs_dtor_cpp_impl(void* io_data);
     template<typename T> void mecs_move_and_dtor_cpp_impl(void* io_src_to_move, void* io_dst_to_destruct);
+    template<typename T> void mecs_copy_cpp_impl(void* o_dst, void const* i_src);
+    template<typename T> void mecs_copy_cpp_deleted(void* o_dst, void const* i_src);
+
+    /* Traits deciding which hooks can be left NULL, so trivial components skip the indirect calls and are moved with memcpy. 
+       Before C++11 every type is assumed to be non-trivial, specialise these traits to opt in. */
+    #if __cplusplus >= 201103L /* C++11 */
+        #include <type_traits>
+        template<typename T> struct mecs_is_trivially_constructible { enum { value = std::is_trivially_default_constructible<T>::value }; };
+        template<typename T> struct mecs_is_trivially_destructible { enum { value = std::is_trivially_destructible<T>::value }; };
+        template<typename T> struct mecs_is_trivially_relocatable { enum { value = std::is_trivially_copyable<T>::value }; };
+        template<typename T> struct mecs_is_trivially_copyable { enum { value = std::is_trivially_copyable<T>::value }; };
+        template<typename T> struct mecs_is_copy_constructible { enum { value = std::is_copy_constructible<T>::value }; };
+    #else
+        template<typename T> struct mecs_is_trivially_constructible { enum { value = 0 }; };
+        template<typename T> struct mecs_is_trivially_destructible { enum { value = 0 }; };
+        template<typename T> struct mecs_is_trivially_relocatable { enum { value = 0 }; };
+        template<typename T> struct mecs_is_trivially_copyable { enum { value = 0 }; };
+        template<typename T> struct mecs_is_copy_constructible { enum { value = 1 }; };
+    #endif
+
+    template<typename T>
+    inline mecs_ctor_func_t mecs_ctor_cpp_get(void)
+    {
+        return mecs_is_trivially_constructible<T>::value ? (mecs_ctor_func_t)NULL : &mecs_ctor_cpp_impl<T>;
+    }
+
+    template<typename T>
+    inline mecs_dtor_func_t mecs_dtor_cpp_get(void)
+    {
+        return mecs_is_trivially_destructible<T>::value ? (mecs_dtor_func_t)NULL : &mecs_dtor_cpp_impl<T>;
+    }
+
+    /* Without a move hook components are relocated by destructing the destination and copying the source's bytes over it. */
+    template<typename T>
+    inline mecs_move_and_dtor_func_t mecs_move_and_dtor_cpp_get(void)
+    {
+        return mecs_is_trivially_relocatable<T>::value ? (mecs_move_and_dtor_func_t)NULL : &mecs_move_and_dtor_cpp_impl<T>;
+    }
+
+    /* Selected at compile time, so components without copy constructor can still be registered. */
+    template<typename T, bool i_is_copy_constructible>
+    struct mecs_copy_cpp_select
+    {
+        static mecs_copy_func_t get(void) { return &mecs_copy_cpp_deleted<T>; }
+    };
+
+    template<typename T>
+    struct mecs_copy_cpp_select<T, true>
+    {
+        static mecs_copy_func_t get(void) { return mecs_is_trivially_copyable<T>::value ? (mecs_copy_func_t)NULL : &mecs_copy_cpp_impl<T>; }
+    };
+
+    template<typename T>
+    inline mecs_copy_func_t mecs_copy_cpp_get(void)
+    {
+        return mecs_copy_cpp_select<T, mecs_is_copy_constructible<T>::value != 0>::get();
+    }
 #endif
 
 /* Hooks serialisation of a type. */
@@ -393,11 +872,24 @@ typedef void(*mecs_move_and_dtor_func_t)(void* io_src_to_move, void* io_dst_to_d
     typedef void(*mecs_deserialise_func_t)(mecs_deserialiser_t* io_deserialiser, void* o_data);
 #endif
 
+/* Hooks for running independent jobs concurrently. Mecs never creates threads itself, instead a parallel for hook allows plugging in any job system.
+   A parallel for must invoke i_job_func once for every index in [0, i_job_count) and may only return once all jobs have finished. */
+typedef void(*mecs_job_func_t)(void* io_job_data, mecs_size_t i_job_index);
+typedef void(*mecs_parallel_for_func_t)(void* io_user_data, mecs_job_func_t i_job_func, void* io_job_data, mecs_size_t i_job_count);
+
+/* How removing a component treats the other components in its store. */
+typedef enum
+{
+    MECS_STORAGE_PACKED,    /* Move the last component into the hole, keeping components contiguous. */
+    MECS_STORAGE_STABLE     /* Leave a tombstone to be reused, components never move until compacted. */
+} mecs_storage_t;
+
 /* Type information about a component. If a component is shared between registries, it's type information is shared between them. The first registry to use the component assigns it. */
 typedef struct 
 {
     mecs_component_id_t id;
     char const* name;
+    mecs_uint32_t name_hash; /* Stable hash of the name. Can be used to identify a component independent of the order in which components are registered. */
     mecs_size_t size;
     mecs_size_t alignment;
 
@@ -405,11 +897,15 @@ typedef struct
     mecs_ctor_func_t ctor_func;
     mecs_dtor_func_t dtor_func;
     mecs_move_and_dtor_func_t move_and_dtor_func;
+    mecs_copy_func_t copy_func;
+    mecs_storage_t storage;
     
     #if !defined(MECS_NO_SERIALISATION)
         mecs_serialise_func_t serialise_func;
         mecs_deserialise_func_t deserialise_func;
         mecs_bool_t is_trivial;
+        mecs_uint8_t const* byte_swap_fields; /* Size in bytes of each consecutive field of a trivial component. Allows converting the byte order of components serialised as binary blobs. */
+        mecs_size_t byte_swap_fields_len;
     #endif
 } mecs_component_type_t;
 
@@ -419,6 +915,19 @@ typedef struct
     mecs_sparse_t block[MECS_PAGE_LEN_SPARSE]; 
 } mecs_sparse_block_t;
 
+typedef struct mecs_index_t mecs_index_t;
+
+#if defined(MECS_THREAD_SAFE)
+/* Reader/writer spin lock. The state counts the readers, with the top bit set while a writer holds the lock. */
+typedef struct
+{
+    volatile mecs_uint32_t state;
+    volatile mecs_uint32_t read_contentions;    /* Number of read locks which had to wait for a writer. */
+    volatile mecs_uint32_t write_contentions;   /* Number of write locks which had to wait for readers or another writer. */
+} mecs_rwlock_t;
+#define MECS_RWLOCK_WRITER 0x80000000UL
+#endif
+
 typedef struct mecs_component_store_t mecs_component_store_t;
 struct mecs_component_store_t
 {
@@ -436,8 +945,14 @@ struct mecs_component_store_t
     mecs_dense_t* dense;            /* Array entities for each components. Size is entities_count and capacity matches components_len * MECS_PAGE_LEN_DENSE. */
     void** components;              /* Array of pointers to blocks sized MECS_PAGE_LEN_DENSE elements containing each component. */
     mecs_entity_size_t sparse_len;
-    mecs_entity_size_t entities_count;
+    mecs_entity_size_t entities_count;  /* Length of the dense array, including tombstones. */
     mecs_entity_size_t components_len;
+    mecs_entity_size_t free_slot;       /* Dense index of the first tombstone, each tombstone holds the next in its generation. MECS_ENTITY_ID_INVALID if none. */
+    mecs_entity_size_t tombstones_count;
+    mecs_index_t* indexes;          /* Linked list of indexes over this component, updated as components are added and removed. */
+    #if defined(MECS_THREAD_SAFE)
+        mecs_rwlock_t lock;
+    #endif
 };
 
 /* The registry is the base storage of all entities and components. There can be multiple decoupled registries. */
@@ -450,6 +965,10 @@ struct mecs_registry_t
     mecs_component_size_t components_len;
     mecs_component_size_t valid_components_count;
 
+    /* Open addressing hash table of component ids keyed by the name hash of their type. Capacity is a power of two and at least twice the number of valid components. */
+    mecs_component_id_t* components_lookup;
+    mecs_component_size_t components_lookup_cap;
+
     /* Array of both alive entities and destroyed entities. Destroyed entities form an implicit linked list within the array. 
        Destroyed entity ids will be reused first when creating new entities. The generation will be incremented and can therefore be used to check if an entity is alive.
        Example:
@@ -457,10 +976,64 @@ struct mecs_registry_t
        [gen_0|id_0] [gen_1|id_4] [gen_0|id_2] [gen_0|id_3] [gen_2|id_5] [gen_4|0xff] [gen_8|id_6] 
        next: id_1 ---^        `-----------------------------^        `---^
     */
-    mecs_entity_t next_free_entity;
+    mecs_entity_t next_free_entity; /* With MECS_THREAD_SAFE the generation bits count changes to the head, so a stale head fails to swap. */
     mecs_entity_t* entities;
-    mecs_entity_size_t entities_len;
+    #if defined(MECS_THREAD_SAFE)
+        mecs_uint32_t entities_len; /* Wide enough for the atomics. */
+    #else
+        mecs_entity_size_t entities_len;
+    #endif
     mecs_entity_size_t entities_cap;
+    mecs_entity_size_t entities_used;   /* Ids used before registry_clear, from entities_len on their entries hold the generation to hand out next. */
+    #if defined(MECS_THREAD_SAFE)
+        mecs_rwlock_t entities_lock;
+    #endif
+
+    mecs_bool_t hierarchy_sorted; /* Whether the dense array of the hierarchy component is in depth first order. */
+};
+
+/* Indexes allow looking up entities by a key extracted from one of their components. */
+typedef mecs_uint64_t(*mecs_index_key_func_t)(void const* i_component);
+
+typedef mecs_uint8_t mecs_index_kind_t;
+#define MECS_INDEX_KIND_HASH_UNIQUE 0
+#define MECS_INDEX_KIND_HASH_MULTI  1
+#define MECS_INDEX_KIND_ORDERED     2
+
+/* State of an entity id within an index. */
+#define MECS_INDEX_STATE_NONE       0
+#define MECS_INDEX_STATE_PENDING    1
+#define MECS_INDEX_STATE_INDEXED    2
+
+typedef struct
+{
+    mecs_uint64_t key;
+    mecs_entity_t entity;
+} mecs_index_entry_t;
+
+struct mecs_index_t
+{
+    mecs_index_t* next;
+    mecs_registry_t* registry;
+    mecs_component_type_t* type;
+    mecs_index_key_func_t key_func;
+    mecs_index_kind_t kind;
+
+    /* Hash indexes use an open addressing table with linear probing, where MECS_ENTITY_INVALID marks an empty entry. Capacity is a power of two and at least twice the length.
+       Ordered indexes use an array sorted by key and entity, inserts are appended and merged in by mecs_index_sort_entries. */
+    mecs_index_entry_t* entries;
+    mecs_size_t entries_len;
+    mecs_size_t entries_cap;
+
+    /* Key and state of each entity id, so entities can leave the index even if their component holds a different key by then. */
+    mecs_uint64_t* keys;
+    mecs_uint8_t* states;
+    mecs_size_t keys_cap;
+
+    /* Entities added since the last lookup. May hold entities which have since been removed, these no longer have a pending state. */
+    mecs_entity_t* pending;
+    mecs_size_t pending_len;
+    mecs_size_t pending_cap;
 };
 
 /* Queries can be used to match all entities with a certain set of components and retreive their data. */
@@ -468,11 +1041,14 @@ typedef mecs_uint8_t mecs_query_type_t;
 #define MECS_QUERY_TYPE_WITH     0
 #define MECS_QUERY_TYPE_WITHOUT  1
 #define MECS_QUERY_TYPE_OPTIONAL 2
-#define MECS_QUERY_MAX_LEN 15
+#define MECS_QUERY_TYPE_ANY_OF   3
+#define MECS_QUERY_LOCAL_LEN 15 /* Number of arguments stored within the iterator before they move to the heap. */
+#define MECS_QUERY_MAX_GROUPS 32
 
 typedef struct
 {
     mecs_query_type_t type;
+    mecs_uint8_t group; /* Any of group of MECS_QUERY_TYPE_ANY_OF arguments. */
     mecs_component_type_t* component_type;
 } mecs_query_arg_t;
 
@@ -485,19 +1061,94 @@ typedef struct
     mecs_entity_t* end;
     mecs_component_store_t* component_stores; 
 
-    /* Evaluating a query only touches the sparse arrays, but chache the dense index as we likely need it to access the component data. */
-    mecs_sparse_t sparse_elements[MECS_QUERY_MAX_LEN]; 
-
+    /* Evaluating a query only touches the sparse arrays, but chache the dense index as we likely need it to access the component data. 
+       Point to the local arrays or the heap arrays, set by mecs_query_begin so the iterator can be copied before. */
+    mecs_sparse_t* sparse_elements; 
+    mecs_query_arg_t* args;
     mecs_size_t args_len;
-    mecs_query_arg_t args[MECS_QUERY_MAX_LEN];
+
+    mecs_size_t base_arg;              /* Argument whose dense array is iterated, an any of group visits the dense arrays of all its arguments. */
+    mecs_uint32_t any_of_groups;       /* Bit for each any of group, an entity must match one argument of each. */
+    mecs_dense_t* batch_end;           /* End of the batch of candidates matched last, current walks through it. */
+    mecs_uint32_t batch_mask;          /* Bit for each candidate from current on which matched and wasn't returned yet. */
+
+    mecs_sparse_t sparse_elements_local[MECS_QUERY_LOCAL_LEN]; 
+    mecs_query_arg_t args_local[MECS_QUERY_LOCAL_LEN];
+    mecs_sparse_t* sparse_elements_heap;
+    mecs_query_arg_t* args_heap;
+    mecs_size_t args_heap_cap;
+
+    #if defined(MECS_QUERY_STATS)
+        mecs_size_t entities_scanned;
+        mecs_size_t entities_matched;
+        mecs_size_t sparse_probes;
+    #endif
+    #if defined(MECS_THREAD_SAFE)
+        mecs_bool_t locked;             /* Whether the component stores of the arguments are read locked. */
+    #endif
 } mecs_query_it_t;
 
+/* Statistics about the memory used by a component store and how well it is occupied. */
+typedef struct
+{
+    mecs_component_type_t* type;                /* NULL if the component is not registered. */
+    mecs_size_t sparse_bytes;                   /* Bytes used by the array of sparse blocks and all allocated sparse blocks. */
+    mecs_entity_size_t sparse_blocks_len;       /* Number of entries in the array of sparse blocks. */
+    mecs_entity_size_t sparse_blocks_allocated; /* Number of sparse blocks allocated. */
+    mecs_entity_size_t sparse_blocks_used;      /* Number of allocated sparse blocks which map at least one entity. */
+    mecs_entity_size_t entities_count;
+    mecs_entity_size_t tombstones_count;        /* Holes left by removing MECS_STORAGE_STABLE components, counted as waste. */
+    mecs_size_t dense_capacity;
+    mecs_size_t dense_bytes;
+    mecs_entity_size_t component_pages;
+    mecs_size_t component_bytes;                /* Bytes used by all component pages. */
+    mecs_size_t component_waste_bytes;          /* Bytes in component pages not holding a component, at the end of the last used page and in unused pages. */
+    mecs_size_t lock_read_contentions;          /* Read locks which had to wait, always 0 without MECS_THREAD_SAFE. */
+    mecs_size_t lock_write_contentions;         /* Write locks which had to wait, always 0 without MECS_THREAD_SAFE. */
+} mecs_component_store_stats_t;
+
+/* Statistics about the memory used by a registry, including all its component stores. */
+typedef struct
+{
+    mecs_size_t bytes;
+    mecs_entity_size_t entities_len;
+    mecs_entity_size_t entities_cap;
+    mecs_entity_size_t entities_alive;
+    mecs_entity_size_t free_entities_len;       /* Length of the list of destroyed entities which will be reused. */
+    mecs_component_size_t component_stores_count;
+    mecs_size_t component_stores_bytes;
+    mecs_size_t component_waste_bytes;
+    mecs_size_t lock_read_contentions;          /* Summed over the entities and all component stores. */
+    mecs_size_t lock_write_contentions;
+} mecs_registry_stats_t;
+
+/* Hot accessors can be defined as static inline functions in every file including mecs.h, allowing them to be inlined without link time optimisation. */
+#if defined(MECS_INLINE_ACCESSORS)
+    #if defined(__cplusplus) || (defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L) /* C++ or C99 */
+        #define MECS_ACCESSOR static inline
+    #elif defined(_MSC_VER)
+        #define MECS_ACCESSOR static __inline
+    #elif defined(__GNUC__)
+        #define MECS_ACCESSOR static __inline__
+    #else
+        #define MECS_ACCESSOR static
+    #endif
+#else
+    #define MECS_ACCESSOR
+#endif
+
 /*
 Registry
 */
 
 mecs_registry_t*    mecs_registry_create(mecs_component_size_t i_component_count_reserve);
 void                mecs_registry_destroy(mecs_registry_t* io_registry);
+void                mecs_registry_merge(mecs_registry_t* io_dst, mecs_registry_t* io_src, mecs_entity_t* o_remap /*= NULL */);
+void                mecs_registry_merge_entities(mecs_registry_t* io_dst, mecs_registry_t* io_src, mecs_entity_t const* i_entities, mecs_entity_size_t i_count, mecs_entity_t* o_entities);
+void                mecs_registry_reserve_entities(mecs_registry_t* io_registry, mecs_entity_size_t i_count);
+void                mecs_registry_clear(mecs_registry_t* io_registry);
+void                mecs_registry_get_stats(mecs_registry_t const* i_registry, mecs_registry_stats_t* o_stats, mecs_component_store_stats_t* o_component_stats /*= NULL */);
+void                mecs_component_store_get_stats(mecs_component_store_t const* i_component_store, mecs_component_store_stats_t* o_stats);
 
 /*
 Types info
@@ -515,17 +1166,17 @@ Types info
     #define mecs_component_get_type_ptr(T) mecs_get_component_type<T>()
 #else
     #define MECS_COMPONENT_DECLARE(T) mecs_component_type_t mecs_component_type_##T
-    #define mecs_component_get_type_ptr(T) &mecs_component_type_##T
+    #define mecs_component_get_type_ptr(T) (&mecs_component_type_##T)
 #endif
 
 /* Add a component to the registry. If this component type is shared between registries, the first registry will populate it's type information. 
    Any components shared between registries should be registed first to make sure they canall use the same id. */
 #if !defined(__cplusplus) || defined(MECS_NO_DEFAULT_REGISTER_CPP_LIFETIME)
     #define MECS_COMPONENT_REGISTER(io_registry, T) \
-        mecs_component_register_impl((io_registry), mecs_component_get_type_ptr(T), #T, sizeof(T), mecs_alignof(T), NULL, NULL, NULL )
+        mecs_component_register_impl((io_registry), mecs_component_get_type_ptr(T), #T, sizeof(T), mecs_alignof(T), NULL, NULL, NULL, NULL )
 #else
     #define MECS_COMPONENT_REGISTER(io_registry, T) \
-        mecs_component_register_impl((io_registry), mecs_component_get_type_ptr(T), #T, sizeof(T), mecs_alignof(T), &mecs_ctor_cpp_impl<T>, &mecs_dtor_cpp_impl<T>, &mecs_move_and_dtor_cpp_impl<T> )
+        mecs_component_register_impl((io_registry), mecs_component_get_type_ptr(T), #T, sizeof(T), mecs_alignof(T), mecs_ctor_cpp_get<T>(), mecs_dtor_cpp_get<T>(), mecs_move_and_dtor_cpp_get<T>(), mecs_copy_cpp_get<T>() )
 #endif
 
 void mecs_component_register_impl(
@@ -536,7 +1187,8 @@ void mecs_component_register_impl(
     mecs_size_t alignment, 
     mecs_ctor_func_t i_ctor /*= NULL */,
     mecs_dtor_func_t i_dtor /*= NULL */,
-    mecs_move_and_dtor_func_t i_move_and_dtor /*= NULL */
+    mecs_move_and_dtor_func_t i_move_and_dtor /*= NULL */,
+    mecs_copy_func_t i_copy /*= NULL */
 );
 
 /* Manually register hooks for the life time of a component. All hooks are optional, passing NULLwill leave them unregistered. */
@@ -550,6 +1202,40 @@ void mecs_component_register_life_time_hooks_impl(
     mecs_move_and_dtor_func_t i_move_and_dtor /*= NULL */
 );
 
+/* Manually register a hook copying a component when cloning entities, passing NULL copies components with memcpy. */
+#define MECS_COMPONENT_REGISTER_COPY_HOOK(T, i_copy_func_ptr /*= NULL */) \
+    mecs_component_register_copy_hook_impl(mecs_component_get_type_ptr(T), (i_copy_func_ptr))
+
+void mecs_component_register_copy_hook_impl(mecs_component_type_t* o_type, mecs_copy_func_t i_copy /*= NULL */);
+
+/* Choose how removing a component treats the other components in its store, before adding any component. */
+#define MECS_COMPONENT_REGISTER_STORAGE(T, i_storage) \
+    mecs_component_register_storage_impl(mecs_component_get_type_ptr(T), (i_storage))
+
+void mecs_component_register_storage_impl(mecs_component_type_t* o_type, mecs_storage_t i_storage);
+
+/* Compile time ids for a set of components listed by an X-macro, LIST(X) must expand X(T) for each component. */
+#define MECS_STATIC_COMPONENT_ID(T) mecs_static_id_##T
+#define MECS_STATIC_COMPONENT_ENUM(T) MECS_STATIC_COMPONENT_ID(T),
+#define MECS_STATIC_COMPONENTS_DECLARE(LIST) enum { LIST(MECS_STATIC_COMPONENT_ENUM) LIST##_COUNT }
+
+#define MECS_STATIC_COMPONENT_REGISTER(T) \
+    MECS_COMPONENT_REGISTER(mecs_static_registry, T); \
+    mecs_component_check_static_id(mecs_component_get_type_ptr(T), MECS_STATIC_COMPONENT_ID(T));
+#define MECS_STATIC_COMPONENTS_REGISTER(io_registry, LIST) \
+    do { mecs_registry_t* mecs_static_registry = (io_registry); LIST(MECS_STATIC_COMPONENT_REGISTER) } while (0)
+
+#define mecs_component_has_static(i_registry, i_entity, T)      mecs_component_has_by_id((i_registry), (i_entity), MECS_STATIC_COMPONENT_ID(T))
+#define mecs_component_get_static(io_registry, i_entity, T)     ((T*)mecs_component_get_by_id((io_registry), (i_entity), MECS_STATIC_COMPONENT_ID(T)))
+
+/* Asserts a component received the id it was listed with, components with static ids must be registered first. */
+void mecs_component_check_static_id(mecs_component_type_t const* i_type, mecs_component_id_t i_id);
+
+/* Look up a component registered with this registry by the hash of its name. Returns NULL if no such component is registered. */
+mecs_uint32_t           mecs_component_name_hash(char const* i_name);
+mecs_component_type_t*  mecs_component_find_by_name_hash(mecs_registry_t const* i_registry, mecs_uint32_t i_name_hash);
+mecs_bool_t             mecs_component_lookup_insert(mecs_registry_t* io_registry, mecs_component_type_t* i_type);
+
 /*
 Component management 
 */
@@ -558,27 +1244,74 @@ Component management
 #define mecs_component_remove(io_registry, i_entity, T)     mecs_component_remove_impl((io_registry), (i_entity), mecs_component_get_type_ptr(T))
 #define mecs_component_has(i_registry, i_entity, T)         mecs_component_has_impl((i_registry), (i_entity), mecs_component_get_type_ptr(T))
 #define mecs_component_get(io_registry, i_entity, T)        ((T*)mecs_component_get_impl((io_registry), (i_entity), mecs_component_get_type_ptr(T)))
+#define mecs_component_reserve(io_registry, T, i_count)     mecs_component_reserve_impl((io_registry), mecs_component_get_type_ptr(T), (i_count))
+#define mecs_component_reserve_ids(io_registry, T, i_first_id, i_count) mecs_component_reserve_ids_impl((io_registry), mecs_component_get_type_ptr(T), (i_first_id), (i_count))
+#define mecs_component_compact(io_registry, T)              mecs_component_compact_impl((io_registry), mecs_component_get_type_ptr(T))
+#define mecs_component_clear(io_registry, T)                mecs_component_clear_impl((io_registry), mecs_component_get_type_ptr(T))
 
 void*               mecs_component_add_impl(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type);
 void                mecs_component_remove_impl(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type);
-mecs_bool_t         mecs_component_has_impl(mecs_registry_t const* i_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type);
-void*               mecs_component_get_impl(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type);
-
-mecs_sparse_t*      mecs_component_get_sparse_element(mecs_component_store_t* i_component_store, mecs_entity_t i_entity);
-mecs_dense_t*       mecs_component_get_dense_element(mecs_component_store_t* i_component_store, mecs_entity_size_t i_index);
-void*               mecs_component_get_component_element(mecs_component_store_t* i_component_store, mecs_entity_size_t i_index);
+void                mecs_component_reserve_impl(mecs_registry_t* io_registry, mecs_component_type_t* i_type, mecs_entity_size_t i_count);
+void                mecs_component_reserve_ids_impl(mecs_registry_t* io_registry, mecs_component_type_t* i_type, mecs_entity_id_t i_first_id, mecs_entity_size_t i_count);
+void                mecs_component_compact_impl(mecs_registry_t* io_registry, mecs_component_type_t* i_type);
+void                mecs_component_clear_impl(mecs_registry_t* io_registry, mecs_component_type_t* i_type);
+MECS_ACCESSOR mecs_bool_t         mecs_component_has_impl(mecs_registry_t const* i_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type);
+MECS_ACCESSOR void*               mecs_component_get_impl(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type);
+MECS_ACCESSOR mecs_bool_t         mecs_component_has_by_id(mecs_registry_t const* i_registry, mecs_entity_t i_entity, mecs_component_id_t i_id);
+MECS_ACCESSOR void*               mecs_component_get_by_id(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_id_t i_id);
+
+MECS_ACCESSOR mecs_sparse_t*      mecs_component_get_sparse_element(mecs_component_store_t* i_component_store, mecs_entity_t i_entity);
+MECS_ACCESSOR mecs_dense_t*       mecs_component_get_dense_element(mecs_component_store_t* i_component_store, mecs_entity_size_t i_index);
+MECS_ACCESSOR void*               mecs_component_get_component_element(mecs_component_store_t* i_component_store, mecs_entity_size_t i_index);
+MECS_ACCESSOR void*               mecs_component_store_get(mecs_component_store_t* i_component_store, mecs_entity_t i_entity);
 void*               mecs_component_get_last_component_element(mecs_component_store_t* i_component_store);
-mecs_bool_t         mecs_component_has_sparse_element(mecs_component_store_t const* i_component_store, mecs_entity_t i_entity);
+MECS_ACCESSOR mecs_bool_t         mecs_component_has_sparse_element(mecs_component_store_t const* i_component_store, mecs_entity_t i_entity);
 mecs_sparse_t*      mecs_component_add_sparse_element(mecs_component_store_t* i_component_store, mecs_entity_t i_entity);
 void*               mecs_component_add_dense_elements(mecs_component_store_t* i_component_store, mecs_entity_size_t i_count);
+void                mecs_component_add_sparse_elements(mecs_component_store_t* i_component_store, mecs_entity_size_t i_first_index, mecs_entity_size_t i_count);
+mecs_bool_t         mecs_component_grow_sparse(mecs_component_store_t* io_component_store, mecs_entity_size_t i_sparse_len);
+mecs_bool_t         mecs_component_grow_pages(mecs_component_store_t* io_component_store, mecs_entity_size_t i_components_len);
+void                mecs_component_remove_element(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type, mecs_bool_t i_relocated);
+void                mecs_component_relocate(mecs_component_type_t* i_type, void* o_dst, void* io_src);
+void                mecs_component_store_merge(mecs_component_store_t* io_dst_store, mecs_component_store_t* io_src_store, mecs_entity_t const* i_remap);
+void                mecs_component_store_compact(mecs_component_store_t* io_component_store);
+void                mecs_component_store_sweep(mecs_component_store_t* io_component_store, mecs_uint8_t const* i_destroyed);
+void                mecs_component_store_clear(mecs_registry_t* io_registry, mecs_component_store_t* io_component_store);
+
+/* Locks of MECS_THREAD_SAFE, which compile to nothing otherwise. Read locking a const store or registry is allowed. */
+#if defined(MECS_THREAD_SAFE)
+    #define mecs_lock_read(i_lock)                          mecs_rwlock_lock_read((mecs_rwlock_t*)(i_lock))
+    #define mecs_unlock_read(i_lock)                        mecs_rwlock_unlock_read((mecs_rwlock_t*)(i_lock))
+    #define mecs_lock_write(io_lock)                        mecs_rwlock_lock_write(io_lock)
+    #define mecs_unlock_write(io_lock)                      mecs_rwlock_unlock_write(io_lock)
+MECS_ACCESSOR void                mecs_rwlock_lock_read(mecs_rwlock_t* io_lock);
+MECS_ACCESSOR void                mecs_rwlock_unlock_read(mecs_rwlock_t* io_lock);
+MECS_ACCESSOR void                mecs_rwlock_lock_write(mecs_rwlock_t* io_lock);
+MECS_ACCESSOR void                mecs_rwlock_unlock_write(mecs_rwlock_t* io_lock);
+#else
+    #define mecs_lock_read(i_lock)                          ((void)0)
+    #define mecs_unlock_read(i_lock)                        ((void)0)
+    #define mecs_lock_write(io_lock)                        ((void)0)
+    #define mecs_unlock_write(io_lock)                      ((void)0)
+#endif
 
-mecs_entity_t       mecs_entity_compose(mecs_entity_gen_t i_generation, mecs_entity_id_t i_id);
-mecs_entity_id_t    mecs_entity_get_id(mecs_entity_t i_entity);
-mecs_entity_gen_t   mecs_entity_get_generation(mecs_entity_t i_entity);
+MECS_ACCESSOR mecs_entity_t       mecs_entity_compose(mecs_entity_gen_t i_generation, mecs_entity_id_t i_id);
+MECS_ACCESSOR mecs_entity_id_t    mecs_entity_get_id(mecs_entity_t i_entity);
+MECS_ACCESSOR mecs_entity_gen_t   mecs_entity_get_generation(mecs_entity_t i_entity);
 mecs_entity_t       mecs_entity_create(mecs_registry_t* io_registry);
 mecs_entity_t*      mecs_entity_create_array(mecs_registry_t* io_registry, mecs_entity_size_t i_count);
+mecs_bool_t         mecs_entity_create_array_copy(mecs_registry_t* io_registry, mecs_entity_size_t i_count, mecs_entity_t* o_entities);
 mecs_bool_t         mecs_entity_destroy(mecs_registry_t* io_registry, mecs_entity_t i_entity);
+mecs_size_t         mecs_entity_destroy_array(mecs_registry_t* io_registry, mecs_entity_t const* i_entities, mecs_entity_size_t i_count);
 mecs_bool_t         mecs_entity_is_destroyed(mecs_registry_t* io_registry, mecs_entity_t i_entity);
+mecs_entity_t*      mecs_entity_create_array_unlocked(mecs_registry_t* io_registry, mecs_entity_size_t i_count);
+mecs_entity_t*      mecs_entity_create_array_atomic(mecs_registry_t* io_registry, mecs_entity_size_t i_count);
+mecs_bool_t         mecs_entity_grow(mecs_registry_t* io_registry, mecs_entity_size_t i_count);
+mecs_bool_t         mecs_entity_grow_shared(mecs_registry_t* io_registry, mecs_entity_size_t i_count);
+mecs_entity_t       mecs_entity_fresh(mecs_registry_t const* i_registry, mecs_entity_id_t i_id);
+mecs_bool_t         mecs_entity_is_destroyed_unlocked(mecs_registry_t* io_registry, mecs_entity_t i_entity);
+void                mecs_entity_clone(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_entity_size_t i_count, mecs_entity_t* o_entities);
+void                mecs_entity_instantiate(mecs_registry_t* io_registry, mecs_registry_t* i_prefab_registry, mecs_entity_t i_prefab, mecs_entity_size_t i_count, mecs_entity_t* o_entities);
 
 /*
 Queries
@@ -587,6 +1320,7 @@ Queries
 #define mecs_query_with(io_query_it, T)                    mecs_query_with_impl((io_query_it), mecs_component_get_type_ptr(T))
 #define mecs_query_without(io_query_it, T)                 mecs_query_without_impl((io_query_it), mecs_component_get_type_ptr(T))
 #define mecs_query_optional(io_query_it, T)                mecs_query_optional_impl((io_query_it), mecs_component_get_type_ptr(T))
+#define mecs_query_any_of(io_query_it, T, i_group)         mecs_query_any_of_impl((io_query_it), mecs_component_get_type_ptr(T), (i_group))
 #define mecs_query_component_has(io_query_it, T, i_index)  mecs_query_component_has_impl((io_query_it), mecs_component_get_type_ptr(T), i_index)
 #define mecs_query_component_get(io_query_it, T, i_index)  ((T*)mecs_query_component_get_impl((io_query_it), mecs_component_get_type_ptr(T), i_index))
 
@@ -594,19 +1328,223 @@ mecs_query_it_t         mecs_query_create(void);
 void                    mecs_query_with_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type);
 void                    mecs_query_without_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type);
 void                    mecs_query_optional_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type);
+void                    mecs_query_any_of_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type, mecs_uint32_t i_group);
+void                    mecs_query_destroy(mecs_query_it_t* io_query_it);
+void                    mecs_query_add_arg(mecs_query_it_t* io_query_it, mecs_query_type_t i_type, mecs_component_type_t* i_component_type, mecs_uint32_t i_group);
 void                    mecs_query_begin(mecs_registry_t* io_registry, mecs_query_it_t* io_query_it);
 mecs_bool_t             mecs_query_next(mecs_query_it_t* io_query_it);
-mecs_entity_t           mecs_query_entity_get(mecs_query_it_t* io_query_it);
-mecs_bool_t             mecs_query_component_has_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type, mecs_size_t i_index);
-void*                   mecs_query_component_get_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type, mecs_size_t i_index);
+void                    mecs_query_end(mecs_query_it_t* io_query_it);
+mecs_bool_t             mecs_query_next_base(mecs_query_it_t* io_query_it);
+mecs_bool_t             mecs_query_next_batch(mecs_query_it_t* io_query_it);
+mecs_uint32_t           mecs_query_match_batch(mecs_query_it_t* io_query_it, mecs_dense_t const* i_candidates, mecs_size_t i_count);
+MECS_ACCESSOR mecs_entity_t           mecs_query_entity_get(mecs_query_it_t* io_query_it);
+MECS_ACCESSOR mecs_bool_t             mecs_query_component_has_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type, mecs_size_t i_index);
+MECS_ACCESSOR void*                   mecs_query_component_get_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type, mecs_size_t i_index);
+
+/* Typed queries for C++11, resolved at compile time so each component is fetched without going through the query arguments. */
+#if defined(__cplusplus) && __cplusplus >= 201103L /* C++11 */
+namespace mecs
+{
+    template<typename... T> struct with {};
+    template<typename... T> struct without {};
 
-#endif /* MECS_H */
+    namespace detail
+    {
+        template<mecs_size_t... I> struct index_sequence_t {};
+        template<mecs_size_t N, mecs_size_t... I> struct make_index_sequence_t : make_index_sequence_t<N - 1, N - 1, I...> {};
+        template<mecs_size_t... I> struct make_index_sequence_t<0, I...> { typedef index_sequence_t<I...> type; };
 
-#ifdef MECS_IMPLEMENTATION
+        /* Mirrors mecs_component_has_sparse_element, returning the dense index as well so it is only read once. */
+        inline bool lookup(mecs_component_store_t const* i_component_store, mecs_entity_t i_entity, mecs_entity_size_t* o_index)
+        {
+            mecs_entity_t const id_mask = (mecs_entity_t)((((mecs_entity_t)1) << MECS_ENTITY_ID_BITCOUNT) - 1);
+            mecs_entity_size_t const entity_id = (mecs_entity_size_t)(i_entity & id_mask);
+            mecs_entity_size_t const page_index = entity_id / MECS_PAGE_LEN_SPARSE;
+            mecs_sparse_t sparse_elem;
+            if (page_index >= i_component_store->sparse_len || i_component_store->sparse[page_index] == NULL)
+            {
+                return false;
+            }
+            sparse_elem = i_component_store->sparse[page_index]->block[entity_id % MECS_PAGE_LEN_SPARSE];
+            *o_index = (mecs_entity_size_t)(sparse_elem & id_mask);
+            return (sparse_elem >> MECS_ENTITY_ID_BITCOUNT) == (i_entity >> MECS_ENTITY_ID_BITCOUNT);
+        }
+
+        template<typename T>
+        inline T& component(mecs_component_store_t* i_component_store, mecs_entity_size_t i_index)
+        {
+            return static_cast<T*>(i_component_store->components[i_index / MECS_PAGE_LEN_DENSE])[i_index % MECS_PAGE_LEN_DENSE];
+        }
+    }
+
+    template<typename T_with, typename T_without = without<> > class view;
+
+    template<typename... T_with, typename... T_without>
+    class view<with<T_with...>, without<T_without...> >
+    {
+    public:
+        static_assert(sizeof...(T_with) > 0, "A view needs at least one with component to iterate.");
+
+        explicit view(mecs_registry_t* io_registry) : 
+            m_registry(io_registry)
+        {}
+
+        /* Calls i_func(entity, T_with&...) for every matching entity. */
+        template<typename T_func>
+        void each(T_func&& i_func)
+        {
+            mecs_component_store_t* with_stores[sizeof...(T_with)] = { &m_registry->components[mecs_get_component_type<T_with>()->id]... };
+            mecs_component_store_t* without_stores[sizeof...(T_without) + 1] = { &m_registry->components[mecs_get_component_type<T_without>()->id]..., NULL };
+            mecs_entity_size_t indices[sizeof...(T_with)];
+            mecs_component_store_t* base;
+            mecs_entity_size_t i;
+            mecs_size_t k;
+            mecs_entity_size_t unused;
+            mecs_entity_t entity;
+            bool match;
+
+            #if defined(MECS_THREAD_SAFE)
+                for (k = 0; k < sizeof...(T_with); ++k)
+                {
+                    mecs_lock_read(&with_stores[k]->lock);
+                }
+                for (k = 0; k < sizeof...(T_without); ++k)
+                {
+                    mecs_lock_read(&without_stores[k]->lock);
+                }
+            #endif
+
+            /* Resolve the stores once per call, they move when components are registered. */
+            base = with_stores[0];
+            for (k = 1; k < sizeof...(T_with); ++k)
+            {
+                base = with_stores[k]->entities_count < base->entities_count ? with_stores[k] : base;
+            }
+
+            for (i = 0; i < base->entities_count; ++i)
+            {
+                entity = base->dense[i];
+                match = mecs_entity_get_id(entity) != MECS_ENTITY_ID_INVALID; /* Skip tombstones. */
+                for (k = 0; k < sizeof...(T_with) && match; ++k)
+                {
+                    if (with_stores[k] == base)
+                    {
+                        indices[k] = i;
+                    }
+                    else
+                    {
+                        match = detail::lookup(with_stores[k], entity, &indices[k]);
+                    }
+                }
+                for (k = 0; k < sizeof...(T_without) && match; ++k)
+                {
+                    match = !detail::lookup(without_stores[k], entity, &unused);
+                }
+                if (match)
+                {
+                    call(i_func, entity, with_stores, indices, typename detail::make_index_sequence_t<sizeof...(T_with)>::type());
+                }
+            }
+
+            #if defined(MECS_THREAD_SAFE)
+                for (k = 0; k < sizeof...(T_with); ++k)
+                {
+                    mecs_unlock_read(&with_stores[k]->lock);
+                }
+                for (k = 0; k < sizeof...(T_without); ++k)
+                {
+                    mecs_unlock_read(&without_stores[k]->lock);
+                }
+            #endif
+        }
+
+    private:
+        template<typename T_func, mecs_size_t... I>
+        static void call(T_func& i_func, mecs_entity_t i_entity, mecs_component_store_t* const* i_stores, mecs_entity_size_t const* i_indices, detail::index_sequence_t<I...>)
+        {
+            i_func(i_entity, detail::component<T_with>(i_stores[I], i_indices[I])...);
+        }
+
+        mecs_registry_t* m_registry;
+    };
+}
+#endif
+
+/*
+Indexes
+*/
+
+#define mecs_index_create(io_registry, T, i_kind, i_key_func)   mecs_index_create_impl((io_registry), mecs_component_get_type_ptr(T), (i_kind), (i_key_func))
+#define mecs_index_update(io_registry, i_entity, T)             mecs_index_update_impl((io_registry), (i_entity), mecs_component_get_type_ptr(T))
+
+mecs_index_t*           mecs_index_create_impl(mecs_registry_t* io_registry, mecs_component_type_t* i_type, mecs_index_kind_t i_kind, mecs_index_key_func_t i_key_func);
+void                    mecs_index_destroy(mecs_index_t* io_index);
+void                    mecs_index_update_impl(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type);
+void                    mecs_index_rebuild(mecs_index_t* io_index);
+mecs_entity_t           mecs_index_find(mecs_index_t* io_index, mecs_uint64_t i_key);
+mecs_size_t             mecs_index_find_all(mecs_index_t* io_index, mecs_uint64_t i_key, mecs_entity_t* o_entities, mecs_size_t i_capacity);
+mecs_size_t             mecs_index_find_range(mecs_index_t* io_index, mecs_uint64_t i_min, mecs_uint64_t i_max, mecs_entity_t* o_entities, mecs_size_t i_capacity);
+
+mecs_uint32_t           mecs_index_hash(mecs_uint64_t i_key);
+mecs_size_t             mecs_index_lower_bound(mecs_index_t const* i_index, mecs_uint64_t i_key, mecs_entity_t i_entity);
+mecs_bool_t             mecs_index_insert_entry(mecs_index_t* io_index, mecs_uint64_t i_key, mecs_entity_t i_entity);
+void                    mecs_index_sort_entries(mecs_index_t* io_index, mecs_size_t i_sorted_len);
+void                    mecs_index_erase_entry(mecs_index_t* io_index, mecs_uint64_t i_key, mecs_entity_t i_entity);
+void                    mecs_index_insert_entity(mecs_index_t* io_index, mecs_entity_t i_entity);
+void                    mecs_index_erase_entity(mecs_index_t* io_index, mecs_entity_t i_entity);
+mecs_bool_t             mecs_index_reserve_keys(mecs_index_t* io_index, mecs_entity_id_t i_entity_id);
+void                    mecs_index_add_pending(mecs_index_t* io_index, mecs_entity_t i_entity);
+void                    mecs_index_flush(mecs_index_t* io_index);
+
+/*
+Hierarchy
+*/
+
+/* Builtin component forming a tree out of linked lists of siblings. Unused links are MECS_ENTITY_INVALID. */
+typedef struct
+{
+    mecs_entity_t parent;
+    mecs_entity_t first_child;
+    mecs_entity_t next_sibling;
+    mecs_entity_t prev_sibling;
+} mecs_hierarchy_t;
+
+typedef struct
+{
+    mecs_component_store_t* component_store;
+    mecs_entity_size_t index;
+    mecs_entity_t entity;
+    mecs_hierarchy_t* hierarchy;
+} mecs_hierarchy_it_t;
+
+#if !defined(__cplusplus)
+    extern mecs_component_type_t mecs_component_type_mecs_hierarchy_t;
+#endif
+
+void                    mecs_hierarchy_set_parent(mecs_registry_t* io_registry, mecs_entity_t i_child, mecs_entity_t i_parent);
+mecs_entity_t           mecs_hierarchy_get_parent(mecs_registry_t* io_registry, mecs_entity_t i_entity);
+void                    mecs_hierarchy_begin(mecs_registry_t* io_registry, mecs_hierarchy_it_t* o_hierarchy_it);
+mecs_bool_t             mecs_hierarchy_next(mecs_hierarchy_it_t* io_hierarchy_it);
+void                    mecs_hierarchy_destroy_recursive(mecs_registry_t* io_registry, mecs_entity_t i_entity);
+mecs_bool_t             mecs_hierarchy_is_registered(mecs_registry_t const* i_registry);
+void                    mecs_hierarchy_sort(mecs_registry_t* io_registry);
+void                    mecs_hierarchy_detach(mecs_registry_t* io_registry, mecs_entity_t i_entity);
+void                    mecs_hierarchy_unlink(mecs_registry_t* io_registry, mecs_entity_t i_entity);
+
+/*
+Jobs
+*/
+
+/* Default parallel for which runs all jobs in order on the calling thread. Used whenever NULL is passed as parallel for hook. */
+void                    mecs_parallel_for_sequential(void* io_user_data, mecs_job_func_t i_job_func, void* io_job_data, mecs_size_t i_job_count);
+
+#endif /* MECS_H */
 
 /* --------------------------------------------------
-Implementaton of compiler and platform agnostic standard library types/functions.
+Hot accessors. Defined by the implementation, or by every file including mecs.h if MECS_INLINE_ACCESSORS is defined.
 -------------------------------------------------- */
+#if (defined(MECS_INLINE_ACCESSORS) || defined(MECS_IMPLEMENTATION)) && !defined(MECS_ACCESSORS_DEFINED)
+#define MECS_ACCESSORS_DEFINED
 
 /* Provide custom or default implementation for the number of bits in a char. */
 #if !defined(MECS_CHAR_BIT)
@@ -628,33 +1566,241 @@ Implementaton of compiler and platform agnostic standard library types/functions
     #define mecs_assert(i_condition) assert(i_condition)
 #endif
 
-/* Provide custom or default implementation for memset. */
-#if !defined(mecs_memset)
-    #if defined(__cplusplus)
-        #include <cstring>
-        #define mecs_memset(i_ptr, i_value, i_size)     std::memset((i_ptr), (i_value), (i_size))
-    #else
-        #include <string.h>
-        #define mecs_memset(i_ptr, i_value, i_size)     memset((i_ptr), (i_value), (i_size))
-    #endif
-#endif
+MECS_ACCESSOR mecs_entity_t mecs_entity_compose(mecs_entity_gen_t i_generation, mecs_entity_id_t i_id)
+{
+    mecs_assert(i_id == mecs_entity_get_id(i_id));
+    return (((mecs_entity_t)i_generation) << MECS_ENTITY_ID_BITCOUNT) | ((mecs_entity_t)i_id);
+}
 
-/* Memory management. Provide custom allocator implementation or default implementation build on the C standard library. */
-#if defined(mecs_realloc) && !defined(mecs_free) || !defined(mecs_realloc) && defined(mecs_free)
-    #error "You must define both mecs_realloc and mecs_free."
-#endif
-#if defined(mecs_realloc_aligned) && !defined(mecs_free_aligned) || !defined(mecs_realloc_aligned) && defined(mecs_free_aligned)
-    #error "You must define both mecs_realloc_aligned and mecs_free_aligned."
-#endif
+MECS_ACCESSOR mecs_entity_id_t mecs_entity_get_id(mecs_entity_t i_entity)
+{
+    /* Convert bitcount into a mask to prevent needing a second constant that can get out of sync. Should get optimized into a compile time constant by the compiler. */
+    mecs_entity_t const mask = ((mecs_entity_t)-1) >> ((sizeof(mecs_entity_t) * MECS_CHAR_BIT) - MECS_ENTITY_ID_BITCOUNT);
+    return (mecs_entity_id_t)(i_entity & mask);
+}
 
-#if !defined(mecs_realloc) && !defined(mecs_free)
-    #if defined(__cplusplus)
-        #include <cstdlib>
-    #else
-        #include <stdlib.h>
-    #endif
-    #define mecs_realloc(io_data, i_size)                       realloc((io_data), (i_size))
-    #define mecs_free(io_data)                                  free(io_data)
+MECS_ACCESSOR mecs_entity_gen_t mecs_entity_get_generation(mecs_entity_t i_entity)
+{
+    return (mecs_entity_gen_t)(i_entity >> MECS_ENTITY_ID_BITCOUNT);
+}
+
+MECS_ACCESSOR mecs_bool_t mecs_component_has_impl(mecs_registry_t const* i_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type)
+{
+    return mecs_component_has_by_id(i_registry, i_entity, i_type->id);
+}
+
+MECS_ACCESSOR void* mecs_component_get_impl(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type)
+{
+    return mecs_component_get_by_id(io_registry, i_entity, i_type->id);
+}
+
+MECS_ACCESSOR mecs_bool_t mecs_component_has_by_id(mecs_registry_t const* i_registry, mecs_entity_t i_entity, mecs_component_id_t i_id)
+{
+    mecs_bool_t has_component;
+    mecs_assert(i_registry != NULL);
+
+    mecs_lock_read(&i_registry->components[i_id].lock);
+    has_component = mecs_component_has_sparse_element(&i_registry->components[i_id], i_entity);
+    mecs_unlock_read(&i_registry->components[i_id].lock);
+    return has_component;
+}
+
+MECS_ACCESSOR void* mecs_component_get_by_id(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_id_t i_id)
+{
+    void* component;
+    mecs_assert(io_registry != NULL);
+
+    mecs_lock_read(&io_registry->components[i_id].lock);
+    component = mecs_component_store_get(&io_registry->components[i_id], i_entity);
+    mecs_unlock_read(&io_registry->components[i_id].lock);
+    return component;
+}
+
+MECS_ACCESSOR void* mecs_component_store_get(mecs_component_store_t* i_component_store, mecs_entity_t i_entity)
+{
+    /* Get without locking, for use while the store is locked already. */
+    mecs_sparse_t* sparse_elem;
+    mecs_entity_size_t dense_index;
+
+    sparse_elem = mecs_component_get_sparse_element(i_component_store, i_entity);
+    dense_index = mecs_entity_get_id(*sparse_elem);
+    return mecs_component_get_component_element(i_component_store, dense_index);
+}
+
+MECS_ACCESSOR mecs_sparse_t* mecs_component_get_sparse_element(mecs_component_store_t* i_component_store, mecs_entity_t i_entity)
+{
+    mecs_entity_size_t page_index;
+    mecs_entity_size_t page_offset;
+    mecs_assert(i_component_store != NULL);
+
+    page_index = mecs_entity_get_id(i_entity) / MECS_PAGE_LEN_SPARSE;
+    page_offset = mecs_entity_get_id(i_entity) % MECS_PAGE_LEN_SPARSE;
+    return &i_component_store->sparse[page_index]->block[page_offset];
+}
+
+MECS_ACCESSOR mecs_dense_t* mecs_component_get_dense_element(mecs_component_store_t* i_component_store, mecs_entity_size_t i_index)
+{
+    mecs_assert(i_component_store != NULL);
+    return &i_component_store->dense[i_index];
+}
+
+MECS_ACCESSOR void* mecs_component_get_component_element(mecs_component_store_t* i_component_store, mecs_entity_size_t i_index)
+{
+    mecs_entity_size_t page_index;
+    mecs_entity_size_t page_offset;
+    void* component_page;
+    void* component;
+    mecs_assert(i_component_store != NULL);
+
+    page_index = i_index / MECS_PAGE_LEN_DENSE;
+    page_offset = i_index % MECS_PAGE_LEN_DENSE;
+    component_page = i_component_store->components[page_index];
+    component = (void*)(((char*)component_page) + (page_offset * i_component_store->type->size));
+    return component;
+}
+
+MECS_ACCESSOR mecs_bool_t mecs_component_has_sparse_element(mecs_component_store_t const* i_component_store, mecs_entity_t i_entity)
+{
+    mecs_entity_size_t page_index;
+    mecs_entity_size_t page_offset;
+    mecs_sparse_t sparse_elem;
+    mecs_assert(i_component_store != NULL);
+
+    page_index = mecs_entity_get_id(i_entity) / MECS_PAGE_LEN_SPARSE;
+    if (page_index >= i_component_store->sparse_len)
+    {
+        return MECS_FALSE;
+    }
+
+    /* If there is no entity sparse_elem will have MECS_ENTITY_GENERATION_INVALID, else make sure the entity stored here has the same generation. 
+       Prevents accessing the dense array to check. */ 
+    if (i_component_store->sparse[page_index] == NULL)
+    {
+        return MECS_FALSE;
+    }
+
+    page_offset = mecs_entity_get_id(i_entity) % MECS_PAGE_LEN_SPARSE;
+    sparse_elem = i_component_store->sparse[page_index]->block[page_offset];
+    if (mecs_entity_get_generation(sparse_elem) != mecs_entity_get_generation(i_entity)) 
+    {
+        return MECS_FALSE;
+    }
+
+    return MECS_TRUE;
+}
+
+MECS_ACCESSOR mecs_entity_t mecs_query_entity_get(mecs_query_it_t* io_query_it)
+{
+    return *(io_query_it->current - 1);
+}
+
+MECS_ACCESSOR mecs_bool_t mecs_query_component_has_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type, mecs_size_t i_index)
+{
+    mecs_assert(io_query_it->args[i_index].component_type->id == i_type->id);
+    return io_query_it->sparse_elements[i_index] != MECS_SPARSE_INVALID;
+}
+
+MECS_ACCESSOR void* mecs_query_component_get_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type, mecs_size_t i_index)
+{
+    mecs_assert(io_query_it->args[i_index].component_type->id == i_type->id);
+    return mecs_component_get_component_element(&io_query_it->component_stores[i_type->id], mecs_entity_get_id(io_query_it->sparse_elements[i_index]));
+}
+
+#if defined(MECS_THREAD_SAFE)
+MECS_ACCESSOR void mecs_rwlock_lock_read(mecs_rwlock_t* io_lock)
+{
+    /* Readers only wait while a writer holds the lock, so read locks can nest. Back out and spin until the writer is done. */
+    mecs_bool_t contended;
+    contended = MECS_FALSE;
+    while ((mecs_atomic_add(&io_lock->state, 1) & MECS_RWLOCK_WRITER) != 0)
+    {
+        mecs_atomic_add(&io_lock->state, (mecs_uint32_t)-1);
+        if (!contended)
+        {
+            contended = MECS_TRUE;
+            mecs_atomic_add(&io_lock->read_contentions, 1);
+        }
+        while ((mecs_atomic_load(&io_lock->state) & MECS_RWLOCK_WRITER) != 0)
+        {
+            mecs_pause();
+        }
+    }
+}
+
+MECS_ACCESSOR void mecs_rwlock_unlock_read(mecs_rwlock_t* io_lock)
+{
+    mecs_atomic_add(&io_lock->state, (mecs_uint32_t)-1);
+}
+
+MECS_ACCESSOR void mecs_rwlock_lock_write(mecs_rwlock_t* io_lock)
+{
+    mecs_bool_t contended;
+    contended = MECS_FALSE;
+    while (!mecs_atomic_cas(&io_lock->state, 0, MECS_RWLOCK_WRITER))
+    {
+        if (!contended)
+        {
+            contended = MECS_TRUE;
+            mecs_atomic_add(&io_lock->write_contentions, 1);
+        }
+        while (mecs_atomic_load(&io_lock->state) != 0)
+        {
+            mecs_pause();
+        }
+    }
+}
+
+MECS_ACCESSOR void mecs_rwlock_unlock_write(mecs_rwlock_t* io_lock)
+{
+    /* Readers backing out may briefly hold counts of their own, so only clear the writer bit by adding it once more. */
+    mecs_atomic_add(&io_lock->state, MECS_RWLOCK_WRITER);
+}
+#endif
+
+#endif /* MECS_ACCESSORS_DEFINED */
+
+#ifdef MECS_IMPLEMENTATION
+
+/* --------------------------------------------------
+Implementaton of compiler and platform agnostic standard library types/functions.
+-------------------------------------------------- */
+
+/* Provide custom or default implementation for profiling hot paths. Compiles to nothing by default. */
+#if defined(mecs_profile_begin) && !defined(mecs_profile_end) || !defined(mecs_profile_begin) && defined(mecs_profile_end)
+    #error "You must define both mecs_profile_begin and mecs_profile_end."
+#endif
+#if !defined(mecs_profile_begin)
+    #define mecs_profile_begin(i_name)
+    #define mecs_profile_end(i_name)
+#endif
+
+/* Provide custom or default implementation for memset. */
+#if !defined(mecs_memset)
+    #if defined(__cplusplus)
+        #include <cstring>
+        #define mecs_memset(i_ptr, i_value, i_size)     std::memset((i_ptr), (i_value), (i_size))
+    #else
+        #include <string.h>
+        #define mecs_memset(i_ptr, i_value, i_size)     memset((i_ptr), (i_value), (i_size))
+    #endif
+#endif
+
+/* Memory management. Provide custom allocator implementation or default implementation build on the C standard library. */
+#if defined(mecs_realloc) && !defined(mecs_free) || !defined(mecs_realloc) && defined(mecs_free)
+    #error "You must define both mecs_realloc and mecs_free."
+#endif
+#if defined(mecs_realloc_aligned) && !defined(mecs_free_aligned) || !defined(mecs_realloc_aligned) && defined(mecs_free_aligned)
+    #error "You must define both mecs_realloc_aligned and mecs_free_aligned."
+#endif
+
+#if !defined(mecs_realloc) && !defined(mecs_free)
+    #if defined(__cplusplus)
+        #include <cstdlib>
+    #else
+        #include <stdlib.h>
+    #endif
+    #define mecs_realloc(io_data, i_size)                       realloc((io_data), (i_size))
+    #define mecs_free(io_data)                                  free(io_data)
 #endif
 
 #if !defined(mecs_realloc_aligned) && !defined(mecs_free_aligned)
@@ -726,33 +1872,34 @@ Implementaton of compiler and platform agnostic standard library types/functions
     {
         T* dst = (T*)io_dst_to_destruct; 
         T* src = (T*)io_src_to_move; 
+    #if __cplusplus >= 201103L /* C++11 */
         *dst = static_cast<T&&>(*src);
+    #else
+        *dst = *src;
+    #endif
         src->~T();
     }
+
+    template<typename T>
+    inline void mecs_copy_cpp_impl(void* o_dst, void const* i_src)
+    {
+        ::new(o_dst) T(*(T const*)i_src);
+    }
+
+    template<typename T>
+    inline void mecs_copy_cpp_deleted(void* o_dst, void const* i_src)
+    {
+        /* Component has no copy constructor and can't be cloned. */
+        (void)o_dst;
+        (void)i_src;
+        mecs_assert(MECS_FALSE);
+    }
 #endif
 
 /* --------------------------------------------------
 Implementation of the core library.
 -------------------------------------------------- */
 
-mecs_entity_t mecs_entity_compose(mecs_entity_gen_t i_generation, mecs_entity_id_t i_id)
-{
-    mecs_assert(i_id == mecs_entity_get_id(i_id));
-    return ((mecs_entity_t)(i_generation << MECS_ENTITY_ID_BITCOUNT)) | ((mecs_entity_t)i_id);
-}
-
-mecs_entity_id_t mecs_entity_get_id(mecs_entity_t i_entity)
-{
-    /* Convert bitcount into a mask to prevent needing a second constant that can get out of sync. Should get optimized into a compile time constant by the compiler. */
-    mecs_entity_t const mask = ((mecs_entity_t)-1) >> ((sizeof(mecs_entity_t) * MECS_CHAR_BIT) - MECS_ENTITY_ID_BITCOUNT);
-    return (mecs_entity_id_t)(i_entity & mask);
-}
-
-mecs_entity_gen_t mecs_entity_get_generation(mecs_entity_t i_entity)
-{
-    return (mecs_entity_gen_t)(i_entity >> MECS_ENTITY_ID_BITCOUNT);
-}
-
 mecs_registry_t* mecs_registry_create(mecs_component_size_t i_component_count_reserve) 
 {
     mecs_registry_t* registry;
@@ -766,6 +1913,8 @@ mecs_registry_t* mecs_registry_create(mecs_component_size_t i_component_count_re
     registry->components_len = i_component_count_reserve;
     registry->valid_components_count = 0;
     registry->components = NULL;
+    registry->components_lookup = NULL;
+    registry->components_lookup_cap = 0;
     if (registry->components_len != 0)
     {
         registry->components = mecs_malloc_arr(mecs_component_store_t, registry->components_len);
@@ -780,7 +1929,12 @@ mecs_registry_t* mecs_registry_create(mecs_component_size_t i_component_count_re
 
     /* Reserve space for entities to prevent frequent growing of the array when the first entities get added. */
     registry->next_free_entity = 0;
+    registry->hierarchy_sorted = MECS_TRUE;
+    #if defined(MECS_THREAD_SAFE)
+        mecs_memset(&registry->entities_lock, 0x00, sizeof(mecs_rwlock_t));
+    #endif
     registry->entities_len = 0;
+    registry->entities_used = 0;
     registry->entities_cap = 8; 
     registry->entities = mecs_malloc_arr(mecs_entity_t, registry->entities_cap);
     if (registry->entities == NULL)
@@ -818,6 +1972,11 @@ void mecs_registry_destroy(mecs_registry_t* io_registry)
             continue;
         }
 
+        while (component_store->indexes != NULL)
+        {
+            mecs_index_destroy(component_store->indexes);
+        }
+
         /* Free sparse */
         for (block_idx = 0; block_idx < component_store->sparse_len; ++block_idx)
         {
@@ -831,20 +1990,23 @@ void mecs_registry_destroy(mecs_registry_t* io_registry)
             mecs_free(component_store->sparse);
         }
 
-        /* Free components */
+        /* Free components, only visiting each of them when they need to be destructed. */
         component_idx = 0;
         for (block_idx = 0; block_idx < component_store->components_len; ++block_idx)
         {
-            block_offset = 0;
-            while (component_idx < component_store->entities_count && block_offset < MECS_PAGE_LEN_DENSE)
+            if (component_store->type->dtor_func != NULL)
             {
-                if (component_store->type->dtor_func != NULL)
+                block_offset = 0;
+                while (component_idx < component_store->entities_count && block_offset < MECS_PAGE_LEN_DENSE)
                 {
                     component = (void*)(((char*)component_store->components[block_idx]) + (block_offset * component_store->type->size));
-                    component_store->type->dtor_func(component);
+                    if (mecs_entity_get_id(component_store->dense[component_idx]) != MECS_ENTITY_ID_INVALID) /* Tombstones were destructed already. */
+                    {
+                        component_store->type->dtor_func(component);
+                    }
+                    component_idx += 1;
+                    block_offset += 1;
                 }
-                component_idx += 1;
-                block_offset += 1;
             }
             mecs_free_aligned(component_store->components[block_idx]);
         }
@@ -866,6 +2028,11 @@ void mecs_registry_destroy(mecs_registry_t* io_registry)
         mecs_free(io_registry->components);
     }
 
+    if (io_registry->components_lookup != NULL)
+    {
+        mecs_free(io_registry->components_lookup);
+    }
+
     if (io_registry->entities_cap != 0)
     {
         mecs_memset(io_registry->entities, 0xCC, sizeof(mecs_entity_t) * io_registry->entities_cap);
@@ -876,75 +2043,239 @@ void mecs_registry_destroy(mecs_registry_t* io_registry)
     mecs_free(io_registry);
 }
 
-void mecs_component_register_impl(mecs_registry_t* io_registry, mecs_component_type_t* io_type, char const* name, mecs_size_t size, mecs_size_t alignment, mecs_ctor_func_t i_ctor /*= NULL */, mecs_dtor_func_t i_dtor /*= NULL */, mecs_move_and_dtor_func_t i_move_and_dtor /*= NULL */)
+void mecs_registry_reserve_entities(mecs_registry_t* io_registry, mecs_entity_size_t i_count)
 {
-    mecs_component_id_t component_id;
-    mecs_component_size_t components_grown_size;
-    mecs_component_store_t* components_grown;
+    mecs_profile_begin("mecs_registry_reserve_entities");
     mecs_assert(io_registry != NULL);
-    mecs_assert(io_type != NULL);
 
-    /* If this type has not been registered with any registry yet, it will be 0 initialised according to the C/C++ standard. 
-       Use this to indicate we need to assign an id and register type info. */
-    if (io_type->name == NULL && io_type->size == 0 && io_type->alignment == 0)
+    mecs_lock_write(&io_registry->entities_lock);
+    if (io_registry->entities_cap - io_registry->entities_len < i_count)
     {
-        for (component_id = 0; component_id < io_registry->components_len; ++component_id)
-        {
-            if (io_registry->components[component_id].type == NULL)
-            {
-                break;
-            }
-        }
-        io_type->id = component_id;
-        io_type->name = name;
-        io_type->size = size;
-        io_type->alignment = alignment;
-
-        if (io_type->ctor_func == NULL) io_type->ctor_func = i_ctor;
-        if (io_type->dtor_func == NULL) io_type->dtor_func = i_dtor;
-        if (io_type->move_and_dtor_func == NULL) io_type->move_and_dtor_func = i_move_and_dtor;
+        mecs_entity_grow(io_registry, (mecs_entity_size_t)(i_count - (io_registry->entities_cap - io_registry->entities_len)));
     }
+    mecs_unlock_write(&io_registry->entities_lock);
+    mecs_profile_end("mecs_registry_reserve_entities");
+}
 
-    if (io_type->id >= io_registry->components_len)
+void mecs_registry_clear(mecs_registry_t* io_registry)
+{
+    mecs_component_size_t component_idx;
+    mecs_size_t entity_idx;
+    mecs_profile_begin("mecs_registry_clear");
+    mecs_assert(io_registry != NULL);
+
+    for (component_idx = 0; component_idx < io_registry->components_len; ++component_idx)
     {
-        /* Grow array to minimal memory needed to register this type. */
-        components_grown_size = io_type->id + 1;
-        components_grown = mecs_realloc_arr(mecs_component_store_t, io_registry->components, components_grown_size);
-        if (components_grown == NULL)
+        if (io_registry->components[component_idx].type != NULL)
         {
-            mecs_assert(MECS_FALSE);
-            return;
+            mecs_lock_write(&io_registry->components[component_idx].lock);
+            mecs_component_store_clear(io_registry, &io_registry->components[component_idx]);
+            mecs_unlock_write(&io_registry->components[component_idx].lock);
         }
-        mecs_memset(components_grown + io_registry->components_len, 0x00, sizeof(mecs_component_store_t));
-        io_registry->components = components_grown;
-        io_registry->components_len = components_grown_size;
     }
 
-    /* Type already registered with this registry. */
-    if (io_registry->components[io_type->id].type != NULL)
+    /* Forget all entities but keep their generations bumped in place, so handles from before the clear stay invalid.
+       Ids are handed out again from the start, with the generation stored for them. */
+    mecs_lock_write(&io_registry->entities_lock);
+    for (entity_idx = 0; entity_idx < io_registry->entities_len; ++entity_idx)
     {
-        if (io_registry->components[io_type->id].type != io_type) 
-        {
-            /* A type with this id has already been registered. Types shared between registries must be registered first. */
-            mecs_assert(MECS_FALSE);
-            return;
-        }
-        return;
+        io_registry->entities[entity_idx] = mecs_entity_compose((mecs_entity_gen_t)(mecs_entity_get_generation(io_registry->entities[entity_idx]) + 1), (mecs_entity_id_t)entity_idx);
     }
-
-    io_registry->valid_components_count += 1;
-    io_registry->components[io_type->id].type = io_type;
-
-    io_registry->components[io_type->id].sparse = NULL;
-    io_registry->components[io_type->id].sparse_len = 0;
-    io_registry->components[io_type->id].dense = NULL;
-    io_registry->components[io_type->id].entities_count = 0;
-    io_registry->components[io_type->id].components = NULL;
-    io_registry->components[io_type->id].components_len = 0;
-
+    if (io_registry->entities_len > io_registry->entities_used)
+    {
+        io_registry->entities_used = (mecs_entity_size_t)io_registry->entities_len;
+    }
+    io_registry->entities_len = 0;
+    #if defined(MECS_THREAD_SAFE)
+        io_registry->next_free_entity = mecs_entity_compose((mecs_entity_gen_t)(mecs_entity_get_generation(io_registry->next_free_entity) + 1), MECS_ENTITY_ID_INVALID);
+    #else
+        io_registry->next_free_entity = MECS_ENTITY_ID_INVALID;
+    #endif
+    io_registry->hierarchy_sorted = MECS_TRUE;
+    mecs_unlock_write(&io_registry->entities_lock);
+    mecs_profile_end("mecs_registry_clear");
 }
 
-void mecs_component_register_life_time_hooks_impl(mecs_component_type_t* o_type, mecs_ctor_func_t i_ctor /*= NULL */, mecs_dtor_func_t i_dtor /*= NULL */, mecs_move_and_dtor_func_t i_move_and_dtor /*= NULL */)
+void mecs_registry_get_stats(mecs_registry_t const* i_registry, mecs_registry_stats_t* o_stats, mecs_component_store_stats_t* o_component_stats)
+{
+    mecs_component_size_t i;
+    mecs_entity_id_t free_entity_id;
+    mecs_component_store_stats_t component_stats;
+    mecs_assert(i_registry != NULL);
+    mecs_assert(o_stats != NULL);
+
+    mecs_memset(o_stats, 0x00, sizeof(mecs_registry_stats_t));
+    o_stats->bytes = sizeof(mecs_registry_t);
+    o_stats->bytes += i_registry->components_len * sizeof(mecs_component_store_t);
+    o_stats->bytes += i_registry->components_lookup_cap * sizeof(mecs_component_id_t);
+    o_stats->bytes += i_registry->entities_cap * sizeof(mecs_entity_t);
+    o_stats->entities_len = i_registry->entities_len;
+    o_stats->entities_cap = i_registry->entities_cap;
+
+    /* Walk the implicit list of destroyed entities. Never walk further than the number of entities in case the list is corrupt. */
+    free_entity_id = mecs_entity_get_id(i_registry->next_free_entity);
+    while (free_entity_id != MECS_ENTITY_ID_INVALID && o_stats->free_entities_len < i_registry->entities_len)
+    {
+        o_stats->free_entities_len += 1;
+        free_entity_id = mecs_entity_get_id(i_registry->entities[free_entity_id]);
+    }
+    o_stats->entities_alive = i_registry->entities_len - o_stats->free_entities_len;
+    #if defined(MECS_THREAD_SAFE)
+        o_stats->lock_read_contentions = i_registry->entities_lock.read_contentions;
+        o_stats->lock_write_contentions = i_registry->entities_lock.write_contentions;
+    #endif
+
+    for (i = 0; i < i_registry->components_len; ++i)
+    {
+        mecs_component_store_get_stats(&i_registry->components[i], &component_stats);
+        if (o_component_stats != NULL)
+        {
+            o_component_stats[i] = component_stats;
+        }
+        if (component_stats.type == NULL)
+        {
+            continue;
+        }
+
+        o_stats->component_stores_count += 1;
+        o_stats->component_stores_bytes += component_stats.sparse_bytes + component_stats.dense_bytes + component_stats.component_bytes;
+        o_stats->component_waste_bytes += component_stats.component_waste_bytes;
+        o_stats->lock_read_contentions += component_stats.lock_read_contentions;
+        o_stats->lock_write_contentions += component_stats.lock_write_contentions;
+    }
+    o_stats->bytes += o_stats->component_stores_bytes;
+}
+
+void mecs_component_store_get_stats(mecs_component_store_t const* i_component_store, mecs_component_store_stats_t* o_stats)
+{
+    mecs_entity_size_t block_idx;
+    mecs_size_t block_offset;
+    mecs_sparse_block_t const* block;
+    mecs_assert(i_component_store != NULL);
+    mecs_assert(o_stats != NULL);
+
+    mecs_memset(o_stats, 0x00, sizeof(mecs_component_store_stats_t));
+    if (i_component_store->type == NULL)
+    {
+        return;
+    }
+    o_stats->type = i_component_store->type;
+
+    o_stats->sparse_blocks_len = i_component_store->sparse_len;
+    o_stats->sparse_bytes = i_component_store->sparse_len * sizeof(mecs_sparse_block_t*);
+    for (block_idx = 0; block_idx < i_component_store->sparse_len; ++block_idx)
+    {
+        block = i_component_store->sparse[block_idx];
+        if (block == NULL)
+        {
+            continue;
+        }
+
+        o_stats->sparse_blocks_allocated += 1;
+        o_stats->sparse_bytes += sizeof(mecs_sparse_block_t);
+        for (block_offset = 0; block_offset < MECS_PAGE_LEN_SPARSE; ++block_offset)
+        {
+            if (block->block[block_offset] != MECS_SPARSE_INVALID)
+            {
+                o_stats->sparse_blocks_used += 1;
+                break;
+            }
+        }
+    }
+
+    /* The dense array and component pages always grow together. */
+    o_stats->entities_count = i_component_store->entities_count - i_component_store->tombstones_count;
+    o_stats->tombstones_count = i_component_store->tombstones_count;
+    o_stats->dense_capacity = (mecs_size_t)i_component_store->components_len * MECS_PAGE_LEN_DENSE;
+    o_stats->dense_bytes = (mecs_size_t)i_component_store->components_len * MECS_PAGE_LEN_DENSE * sizeof(mecs_dense_t);
+    o_stats->component_pages = i_component_store->components_len;
+    o_stats->component_bytes = (mecs_size_t)i_component_store->components_len * MECS_PAGE_LEN_DENSE * i_component_store->type->size;
+    o_stats->component_waste_bytes = o_stats->component_bytes - (mecs_size_t)o_stats->entities_count * i_component_store->type->size;
+    #if defined(MECS_THREAD_SAFE)
+        o_stats->lock_read_contentions = i_component_store->lock.read_contentions;
+        o_stats->lock_write_contentions = i_component_store->lock.write_contentions;
+    #endif
+}
+
+void mecs_component_register_impl(mecs_registry_t* io_registry, mecs_component_type_t* io_type, char const* name, mecs_size_t size, mecs_size_t alignment, mecs_ctor_func_t i_ctor /*= NULL */, mecs_dtor_func_t i_dtor /*= NULL */, mecs_move_and_dtor_func_t i_move_and_dtor /*= NULL */, mecs_copy_func_t i_copy /*= NULL */)
+{
+    mecs_component_id_t component_id;
+    mecs_component_size_t components_grown_size;
+    mecs_component_store_t* components_grown;
+    mecs_assert(io_registry != NULL);
+    mecs_assert(io_type != NULL);
+
+    /* If this type has not been registered with any registry yet, it will be 0 initialised according to the C/C++ standard. 
+       Use this to indicate we need to assign an id and register type info. */
+    if (io_type->name == NULL && io_type->size == 0 && io_type->alignment == 0)
+    {
+        for (component_id = 0; component_id < io_registry->components_len; ++component_id)
+        {
+            if (io_registry->components[component_id].type == NULL)
+            {
+                break;
+            }
+        }
+        io_type->id = component_id;
+        io_type->name = name;
+        io_type->name_hash = mecs_component_name_hash(name);
+        io_type->size = size;
+        io_type->alignment = alignment;
+
+        if (io_type->ctor_func == NULL) io_type->ctor_func = i_ctor;
+        if (io_type->dtor_func == NULL) io_type->dtor_func = i_dtor;
+        if (io_type->move_and_dtor_func == NULL) io_type->move_and_dtor_func = i_move_and_dtor;
+        if (io_type->copy_func == NULL) io_type->copy_func = i_copy;
+    }
+
+    if (io_type->id >= io_registry->components_len)
+    {
+        /* Grow array to minimal memory needed to register this type. */
+        components_grown_size = io_type->id + 1;
+        components_grown = mecs_realloc_arr(mecs_component_store_t, io_registry->components, components_grown_size);
+        if (components_grown == NULL)
+        {
+            mecs_assert(MECS_FALSE);
+            return;
+        }
+        mecs_memset(components_grown + io_registry->components_len, 0x00, (components_grown_size - io_registry->components_len) * sizeof(mecs_component_store_t)); /* Components with a lower id may not be registered with this registry. */
+        io_registry->components = components_grown;
+        io_registry->components_len = components_grown_size;
+    }
+
+    /* Type already registered with this registry. */
+    if (io_registry->components[io_type->id].type != NULL)
+    {
+        if (io_registry->components[io_type->id].type != io_type) 
+        {
+            /* A type with this id has already been registered. Types shared between registries must be registered first. */
+            mecs_assert(MECS_FALSE);
+            return;
+        }
+        return;
+    }
+
+    if (!mecs_component_lookup_insert(io_registry, io_type))
+    {
+        return;
+    }
+
+    io_registry->valid_components_count += 1;
+    io_registry->components[io_type->id].type = io_type;
+
+    io_registry->components[io_type->id].sparse = NULL;
+    io_registry->components[io_type->id].sparse_len = 0;
+    io_registry->components[io_type->id].dense = NULL;
+    io_registry->components[io_type->id].entities_count = 0;
+    io_registry->components[io_type->id].components = NULL;
+    io_registry->components[io_type->id].components_len = 0;
+    io_registry->components[io_type->id].free_slot = MECS_ENTITY_ID_INVALID;
+    io_registry->components[io_type->id].tombstones_count = 0;
+    io_registry->components[io_type->id].indexes = NULL;
+
+}
+
+void mecs_component_register_life_time_hooks_impl(mecs_component_type_t* o_type, mecs_ctor_func_t i_ctor /*= NULL */, mecs_dtor_func_t i_dtor /*= NULL */, mecs_move_and_dtor_func_t i_move_and_dtor /*= NULL */)
 {
     mecs_assert(o_type);
     o_type->ctor_func = i_ctor;
@@ -952,32 +2283,258 @@ void mecs_component_register_life_time_hooks_impl(mecs_component_type_t* o_type,
     o_type->move_and_dtor_func = i_move_and_dtor;
 }
 
+void mecs_component_register_copy_hook_impl(mecs_component_type_t* o_type, mecs_copy_func_t i_copy /*= NULL */)
+{
+    mecs_assert(o_type);
+    o_type->copy_func = i_copy;
+}
+
+void mecs_component_register_storage_impl(mecs_component_type_t* o_type, mecs_storage_t i_storage)
+{
+    mecs_assert(o_type);
+    mecs_assert(o_type != mecs_component_get_type_ptr(mecs_hierarchy_t) || i_storage == MECS_STORAGE_PACKED); /* The hierarchy walks its dense array. */
+    o_type->storage = i_storage;
+}
+
+void mecs_component_check_static_id(mecs_component_type_t const* i_type, mecs_component_id_t i_id)
+{
+    mecs_assert(i_type != NULL);
+    mecs_assert(i_type->id == i_id);
+    (void)i_type;
+    (void)i_id;
+}
+
+mecs_uint32_t mecs_component_name_hash(char const* i_name)
+{
+    /* 32 bit FNV-1a. */
+    mecs_uint32_t hash;
+    mecs_assert(i_name != NULL);
+
+    hash = 2166136261u;
+    while (*i_name != '\0')
+    {
+        hash ^= (mecs_uint32_t)(unsigned char)*i_name;
+        hash = (mecs_uint32_t)(hash * 16777619u);
+        i_name += 1;
+    }
+    return hash;
+}
+
+mecs_component_type_t* mecs_component_find_by_name_hash(mecs_registry_t const* i_registry, mecs_uint32_t i_name_hash)
+{
+    mecs_component_size_t mask;
+    mecs_component_size_t slot;
+    mecs_component_id_t component_id;
+    mecs_component_type_t* type;
+    mecs_assert(i_registry != NULL);
+
+    if (i_registry->components_lookup_cap == 0)
+    {
+        return NULL;
+    }
+
+    /* Linear probe until an empty slot, the table is never full so this always terminates. 
+       Types with the same hash share a probe sequence, a second match means the hash is ambiguous. */
+    type = NULL;
+    mask = i_registry->components_lookup_cap - 1;
+    for (slot = i_name_hash & mask; ; slot = (slot + 1) & mask)
+    {
+        component_id = i_registry->components_lookup[slot];
+        if (component_id == MECS_COMPONENT_ID_INVALID)
+        {
+            return type;
+        }
+        if (i_registry->components[component_id].type->name_hash == i_name_hash)
+        {
+            if (type != NULL)
+            {
+                return NULL;
+            }
+            type = i_registry->components[component_id].type;
+        }
+    }
+}
+
+mecs_bool_t mecs_component_lookup_insert(mecs_registry_t* io_registry, mecs_component_type_t* i_type)
+{
+    mecs_component_size_t lookup_grown_cap;
+    mecs_component_id_t* lookup_grown;
+    mecs_component_size_t mask;
+    mecs_component_size_t slot;
+    mecs_component_size_t i;
+    mecs_assert(io_registry != NULL);
+    mecs_assert(i_type != NULL);
+
+    /* Keep the load factor at or below 50%. Grow by rehashing all valid components into a new table. */
+    if ((io_registry->valid_components_count + 1) * 2 > io_registry->components_lookup_cap)
+    {
+        lookup_grown_cap = io_registry->components_lookup_cap == 0 ? 8 : io_registry->components_lookup_cap * 2;
+        lookup_grown = mecs_malloc_arr(mecs_component_id_t, lookup_grown_cap);
+        if (lookup_grown == NULL)
+        {
+            mecs_assert(MECS_FALSE);
+            return MECS_FALSE;
+        }
+        mecs_memset(lookup_grown, 0xFF, lookup_grown_cap * sizeof(mecs_component_id_t)); /* Initialise all slots to MECS_COMPONENT_ID_INVALID. */
+
+        mask = lookup_grown_cap - 1;
+        for (i = 0; i < io_registry->components_len; ++i)
+        {
+            if (io_registry->components[i].type == NULL)
+            {
+                continue;
+            }
+            for (slot = io_registry->components[i].type->name_hash & mask; lookup_grown[slot] != MECS_COMPONENT_ID_INVALID; slot = (slot + 1) & mask);
+            lookup_grown[slot] = i;
+        }
+
+        if (io_registry->components_lookup != NULL)
+        {
+            mecs_free(io_registry->components_lookup);
+        }
+        io_registry->components_lookup = lookup_grown;
+        io_registry->components_lookup_cap = lookup_grown_cap;
+    }
+
+    mask = io_registry->components_lookup_cap - 1;
+    for (slot = i_type->name_hash & mask; io_registry->components_lookup[slot] != MECS_COMPONENT_ID_INVALID; slot = (slot + 1) & mask);
+    io_registry->components_lookup[slot] = i_type->id;
+    return MECS_TRUE;
+}
+
 void* mecs_component_add_impl(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type)
 {
     mecs_component_store_t* component_store; 
     mecs_sparse_t* sparse_elem;
+    mecs_entity_size_t dense_index;
     mecs_dense_t* dense_elem; 
     void* component_elem;
+    mecs_index_t* index;
+    mecs_profile_begin("mecs_component_add");
     mecs_assert(io_registry != NULL);
     mecs_assert(i_type != NULL);
 
     component_store = &io_registry->components[i_type->id];
+    mecs_lock_write(&component_store->lock);
     sparse_elem = mecs_component_add_sparse_element(component_store, i_entity);
-    component_elem = mecs_component_add_dense_elements(component_store, 1); /* Allocating a new dense elements will grow both the components array and dense array to match. */
-    dense_elem = mecs_component_get_dense_element(component_store, component_store->entities_count - 1);
+    if (component_store->free_slot != MECS_ENTITY_ID_INVALID)
+    {
+        /* Fill the most recent tombstone, only stable components leave them. */
+        dense_index = component_store->free_slot;
+        dense_elem = mecs_component_get_dense_element(component_store, dense_index);
+        component_store->free_slot = mecs_entity_get_generation(*dense_elem);
+        component_store->tombstones_count -= 1;
+        component_elem = mecs_component_get_component_element(component_store, dense_index);
+    }
+    else
+    {
+        component_elem = mecs_component_add_dense_elements(component_store, 1); /* Allocating a new dense elements will grow both the components array and dense array to match. */
+        dense_index = component_store->entities_count - 1;
+        dense_elem = mecs_component_get_dense_element(component_store, dense_index);
+    }
 
     if (component_store->type->ctor_func != NULL)
     {
         component_store->type->ctor_func(component_elem);
     }
     
-    *sparse_elem = mecs_entity_compose(mecs_entity_get_generation(i_entity), component_store->entities_count - 1); /* Build sparse element out of version and dense index. */
+    *sparse_elem = mecs_entity_compose(mecs_entity_get_generation(i_entity), dense_index); /* Build sparse element out of version and dense index. */
     *dense_elem  = i_entity;
+
+    for (index = component_store->indexes; index != NULL; index = index->next)
+    {
+        mecs_index_add_pending(index, i_entity);
+    }
+
+    if (i_type == mecs_component_get_type_ptr(mecs_hierarchy_t))
+    {
+        mecs_memset(component_elem, 0xFF, sizeof(mecs_hierarchy_t)); /* Initialise all links to MECS_ENTITY_INVALID. */
+        io_registry->hierarchy_sorted = MECS_FALSE;
+    }
+    mecs_unlock_write(&component_store->lock);
+    mecs_profile_end("mecs_component_add");
     return component_elem;
 }
 
 void mecs_component_remove_impl(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type)
 {
+    mecs_profile_begin("mecs_component_remove");
+    mecs_assert(io_registry != NULL);
+    mecs_assert(i_type != NULL);
+    mecs_lock_write(&io_registry->components[i_type->id].lock);
+    mecs_component_remove_element(io_registry, i_entity, i_type, MECS_FALSE);
+    mecs_unlock_write(&io_registry->components[i_type->id].lock);
+    mecs_profile_end("mecs_component_remove");
+}
+
+void mecs_component_reserve_impl(mecs_registry_t* io_registry, mecs_component_type_t* i_type, mecs_entity_size_t i_count)
+{
+    mecs_component_store_t* component_store;
+    mecs_size_t components_len;
+    mecs_profile_begin("mecs_component_reserve");
+    mecs_assert(io_registry != NULL);
+    mecs_assert(i_type != NULL);
+
+    component_store = &io_registry->components[i_type->id];
+    mecs_lock_write(&component_store->lock);
+    components_len = ((mecs_size_t)component_store->entities_count + i_count + MECS_PAGE_LEN_DENSE - 1) / MECS_PAGE_LEN_DENSE;
+    mecs_assert(components_len <= (mecs_entity_size_t)-1);
+    if (components_len > component_store->components_len)
+    {
+        mecs_component_grow_pages(component_store, (mecs_entity_size_t)components_len);
+    }
+    mecs_unlock_write(&component_store->lock);
+    mecs_profile_end("mecs_component_reserve");
+}
+
+void mecs_component_reserve_ids_impl(mecs_registry_t* io_registry, mecs_component_type_t* i_type, mecs_entity_id_t i_first_id, mecs_entity_size_t i_count)
+{
+    mecs_component_store_t* component_store;
+    mecs_size_t page_index;
+    mecs_size_t last_page_index;
+    mecs_sparse_block_t* sparse_page;
+    mecs_profile_begin("mecs_component_reserve_ids");
+    mecs_assert(io_registry != NULL);
+    mecs_assert(i_type != NULL);
+
+    if (i_count == 0)
+    {
+        mecs_profile_end("mecs_component_reserve_ids");
+        return;
+    }
+
+    component_store = &io_registry->components[i_type->id];
+    mecs_lock_write(&component_store->lock);
+    last_page_index = ((mecs_size_t)i_first_id + i_count - 1) / MECS_PAGE_LEN_SPARSE;
+    if (last_page_index >= component_store->sparse_len && !mecs_component_grow_sparse(component_store, (mecs_entity_size_t)(last_page_index + 1)))
+    {
+        mecs_unlock_write(&component_store->lock);
+        mecs_profile_end("mecs_component_reserve_ids");
+        return;
+    }
+
+    for (page_index = i_first_id / MECS_PAGE_LEN_SPARSE; page_index <= last_page_index; ++page_index)
+    {
+        if (component_store->sparse[page_index] != NULL)
+        {
+            continue;
+        }
+        sparse_page = mecs_malloc_type(mecs_sparse_block_t);
+        if (sparse_page == NULL)
+        {
+            mecs_assert(MECS_FALSE);
+            break;
+        }
+        mecs_memset(sparse_page, 0xFF, sizeof(mecs_sparse_block_t)); /* Initialise all entires MECS_SPARSE_INVALID, indicates there is no component for this entity. */
+        component_store->sparse[page_index] = sparse_page;
+    }
+    mecs_unlock_write(&component_store->lock);
+    mecs_profile_end("mecs_component_reserve_ids");
+}
+
+void mecs_component_remove_element(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type, mecs_bool_t i_relocated)
+{
+    /* Removes a component, when i_relocated it was moved elsewhere already and must not be destructed. */
     mecs_component_store_t* component_store; 
 
     mecs_sparse_t* entity_sparse_elem; 
@@ -988,24 +2545,64 @@ void mecs_component_remove_impl(mecs_registry_t* io_registry, mecs_entity_t i_en
     mecs_sparse_t* last_entity_sparse_elem; 
     mecs_dense_t* last_entity_dense_elem; 
     void* last_entity_component_elem;
+    mecs_index_t* index;
     mecs_assert(io_registry != NULL);
     mecs_assert(i_type != NULL);
 
     component_store = &io_registry->components[i_type->id];
+    for (index = component_store->indexes; index != NULL; index = index->next)
+    {
+        mecs_index_erase_entity(index, i_entity);
+    }
+
+    if (i_type == mecs_component_get_type_ptr(mecs_hierarchy_t))
+    {
+        mecs_hierarchy_unlink(io_registry, i_entity);
+    }
 
     entity_sparse_elem = mecs_component_get_sparse_element(component_store, i_entity);
     entity_dense_index = mecs_entity_get_id(*entity_sparse_elem); /* Get the dense index from the entity version - dense index pair. */
     entity_dense_elem = mecs_component_get_dense_element(component_store, entity_dense_index);
     entity_component_elem = mecs_component_get_component_element(component_store, entity_dense_index);
 
-    if (component_store->entities_count != 1)
+    if (component_store->type->storage == MECS_STORAGE_STABLE && entity_dense_index != component_store->entities_count - 1)
+    {
+        /* Leave a tombstone pointing to the next free slot, no other component moves. */
+        if (component_store->type->dtor_func != NULL && !i_relocated)
+        {
+            component_store->type->dtor_func(entity_component_elem);
+        }
+        *entity_dense_elem = mecs_entity_compose((mecs_entity_gen_t)component_store->free_slot, MECS_ENTITY_ID_INVALID);
+        *entity_sparse_elem = MECS_SPARSE_INVALID;
+        component_store->free_slot = entity_dense_index;
+        component_store->tombstones_count += 1;
+        return;
+    }
+
+    if (component_store->type->storage == MECS_STORAGE_STABLE)
+    {
+        /* The last slot is simply dropped. */
+        if (component_store->type->dtor_func != NULL && !i_relocated)
+        {
+            component_store->type->dtor_func(entity_component_elem);
+        }
+        *entity_dense_elem = MECS_ENTITY_INVALID;
+    }
+    else if (component_store->entities_count != 1)
     {
         /* Move the last component in place of the component we want to remove. */
         last_entity_dense_elem = mecs_component_get_dense_element(component_store, component_store->entities_count - 1);
         last_entity_sparse_elem = mecs_component_get_sparse_element(component_store, *last_entity_dense_elem);
         last_entity_component_elem = mecs_component_get_last_component_element(component_store);
 
-        if (component_store->type->move_and_dtor_func != NULL)
+        if (i_relocated)
+        {
+            if (last_entity_component_elem != entity_component_elem)
+            {
+                mecs_component_relocate(component_store->type, entity_component_elem, last_entity_component_elem);
+            }
+        }
+        else if (component_store->type->move_and_dtor_func != NULL)
         {
             component_store->type->move_and_dtor_func(last_entity_component_elem, entity_component_elem);
         }
@@ -1023,7 +2620,7 @@ void mecs_component_remove_impl(mecs_registry_t* io_registry, mecs_entity_t i_en
     }
     else 
     {
-        if (component_store->type->dtor_func != NULL)
+        if (component_store->type->dtor_func != NULL && !i_relocated)
         {
             component_store->type->dtor_func(entity_component_elem);
         }
@@ -1034,123 +2631,296 @@ void mecs_component_remove_impl(mecs_registry_t* io_registry, mecs_entity_t i_en
     component_store->entities_count -= 1;
 }
 
-mecs_bool_t mecs_component_has_impl(mecs_registry_t const* i_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type)
+void mecs_component_compact_impl(mecs_registry_t* io_registry, mecs_component_type_t* i_type)
 {
-    mecs_assert(i_registry != NULL);
-    return mecs_component_has_sparse_element(&i_registry->components[i_type->id], i_entity);
+    mecs_component_store_t* component_store;
+    mecs_profile_begin("mecs_component_compact");
+    mecs_assert(io_registry != NULL);
+    mecs_assert(i_type != NULL);
+
+    component_store = &io_registry->components[i_type->id];
+    mecs_lock_write(&component_store->lock);
+    mecs_component_store_compact(component_store);
+    mecs_unlock_write(&component_store->lock);
+    mecs_profile_end("mecs_component_compact");
 }
 
-void* mecs_component_get_impl(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type)
+void mecs_component_clear_impl(mecs_registry_t* io_registry, mecs_component_type_t* i_type)
 {
-    mecs_component_store_t* component_store; 
-    mecs_sparse_t* sparse_elem;
-    mecs_entity_size_t dense_index;
+    mecs_component_store_t* component_store;
+    mecs_profile_begin("mecs_component_clear");
     mecs_assert(io_registry != NULL);
+    mecs_assert(i_type != NULL);
 
     component_store = &io_registry->components[i_type->id];
-    sparse_elem = mecs_component_get_sparse_element(component_store, i_entity);
-    dense_index = mecs_entity_get_id(*sparse_elem);
-    return mecs_component_get_component_element(component_store, dense_index);
+    mecs_lock_write(&component_store->lock);
+    mecs_component_store_clear(io_registry, component_store);
+    mecs_unlock_write(&component_store->lock);
+    mecs_profile_end("mecs_component_clear");
 }
 
-mecs_sparse_t* mecs_component_get_sparse_element(mecs_component_store_t* i_component_store, mecs_entity_t i_entity)
+void mecs_component_store_clear(mecs_registry_t* io_registry, mecs_component_store_t* io_component_store)
 {
-    mecs_entity_size_t page_index;
-    mecs_entity_size_t page_offset;
-    mecs_assert(i_component_store != NULL);
+    /* Remove all components without moving any of them, keeping all pages allocated. */
+    mecs_entity_size_t i;
+    mecs_entity_size_t block_idx;
+    mecs_index_t* index;
+    mecs_assert(io_registry != NULL);
+    mecs_assert(io_component_store != NULL);
 
-    page_index = mecs_entity_get_id(i_entity) / MECS_PAGE_LEN_SPARSE;
-    page_offset = mecs_entity_get_id(i_entity) % MECS_PAGE_LEN_SPARSE;
-    return &i_component_store->sparse[page_index]->block[page_offset];
+    if (io_component_store->type->dtor_func != NULL)
+    {
+        for (i = 0; i < io_component_store->entities_count; ++i)
+        {
+            if (mecs_entity_get_id(io_component_store->dense[i]) != MECS_ENTITY_ID_INVALID) /* Tombstones were destructed already. */
+            {
+                io_component_store->type->dtor_func(mecs_component_get_component_element(io_component_store, i));
+            }
+        }
+    }
+
+    for (block_idx = 0; block_idx < io_component_store->sparse_len; ++block_idx)
+    {
+        if (io_component_store->sparse[block_idx] != NULL)
+        {
+            mecs_memset(io_component_store->sparse[block_idx], 0xFF, sizeof(mecs_sparse_block_t)); /* Initialise all entires MECS_SPARSE_INVALID, indicates there is no component for this entity. */
+        }
+    }
+    if (io_component_store->entities_count != 0)
+    {
+        mecs_memset(io_component_store->dense, 0xFF, io_component_store->entities_count * sizeof(mecs_dense_t)); /* Initialise all entiries to invalid entity. */
+    }
+    io_component_store->entities_count = 0;
+    io_component_store->free_slot = MECS_ENTITY_ID_INVALID;
+    io_component_store->tombstones_count = 0;
+
+    for (index = io_component_store->indexes; index != NULL; index = index->next)
+    {
+        mecs_index_rebuild(index);
+    }
+    if (io_component_store->type == mecs_component_get_type_ptr(mecs_hierarchy_t))
+    {
+        io_registry->hierarchy_sorted = MECS_TRUE;
+    }
 }
 
-mecs_dense_t* mecs_component_get_dense_element(mecs_component_store_t* i_component_store, mecs_entity_size_t i_index)
+void mecs_component_store_compact(mecs_component_store_t* io_component_store)
 {
-    mecs_assert(i_component_store != NULL);
-    return &i_component_store->dense[i_index];
+    /* Fill the tombstones front to back with the components at the back of the dense array. */
+    mecs_entity_size_t hole;
+    mecs_entity_size_t last;
+    mecs_sparse_t* sparse_elem;
+    mecs_assert(io_component_store != NULL);
+
+    if (io_component_store->tombstones_count == 0)
+    {
+        return;
+    }
+
+    hole = 0;
+    last = io_component_store->entities_count;
+    for (;;)
+    {
+        while (hole < last && mecs_entity_get_id(io_component_store->dense[hole]) != MECS_ENTITY_ID_INVALID)
+        {
+            hole += 1;
+        }
+        while (last > hole && mecs_entity_get_id(io_component_store->dense[last - 1]) == MECS_ENTITY_ID_INVALID)
+        {
+            last -= 1;
+        }
+        if (hole >= last)
+        {
+            break;
+        }
+
+        last -= 1;
+        mecs_component_relocate(io_component_store->type, mecs_component_get_component_element(io_component_store, hole), mecs_component_get_component_element(io_component_store, last));
+        io_component_store->dense[hole] = io_component_store->dense[last];
+        io_component_store->dense[last] = MECS_ENTITY_INVALID;
+        sparse_elem = mecs_component_get_sparse_element(io_component_store, io_component_store->dense[hole]);
+        *sparse_elem = mecs_entity_compose(mecs_entity_get_generation(*sparse_elem), hole);
+    }
+
+    /* Everything past the live components is a tombstone now. */
+    io_component_store->entities_count -= io_component_store->tombstones_count;
+    mecs_assert(io_component_store->entities_count == hole);
+    mecs_memset(io_component_store->dense + io_component_store->entities_count, 0xFF, io_component_store->tombstones_count * sizeof(mecs_dense_t)); /* Initialise all entiries to invalid entity. */
+    io_component_store->free_slot = MECS_ENTITY_ID_INVALID;
+    io_component_store->tombstones_count = 0;
 }
 
-void* mecs_component_get_component_element(mecs_component_store_t* i_component_store, mecs_entity_size_t i_index)
+void mecs_component_store_sweep(mecs_component_store_t* io_component_store, mecs_uint8_t const* i_destroyed)
 {
-    mecs_entity_size_t page_index;
-    mecs_entity_size_t page_offset;
-    void* component_page;
-    void* component;
-    mecs_assert(i_component_store != NULL);
+    /* Remove the components of all entities whose id is marked in i_destroyed in a single pass. Each removed component leaves a 
+       tombstone, packed stores are compacted afterwards which moves at most one component per tombstone. */
+    mecs_entity_size_t i;
+    mecs_dense_t entity;
+    mecs_entity_id_t entity_id;
+    mecs_index_t* index;
+    mecs_assert(io_component_store != NULL);
+    mecs_assert(i_destroyed != NULL);
 
-    page_index = i_index / MECS_PAGE_LEN_DENSE;
-    page_offset = i_index % MECS_PAGE_LEN_DENSE;
-    component_page = i_component_store->components[page_index];
-    component = (void*)(((char*)component_page) + (page_offset * i_component_store->type->size));
-    return component;
+    for (i = 0; i < io_component_store->entities_count; ++i)
+    {
+        entity = io_component_store->dense[i];
+        entity_id = mecs_entity_get_id(entity);
+        if (entity_id == MECS_ENTITY_ID_INVALID || (i_destroyed[entity_id / 8] & (1 << (entity_id % 8))) == 0)
+        {
+            continue;
+        }
+
+        for (index = io_component_store->indexes; index != NULL; index = index->next)
+        {
+            mecs_index_erase_entity(index, entity);
+        }
+        if (io_component_store->type->dtor_func != NULL)
+        {
+            io_component_store->type->dtor_func(mecs_component_get_component_element(io_component_store, i));
+        }
+        *mecs_component_get_sparse_element(io_component_store, entity) = MECS_SPARSE_INVALID;
+        io_component_store->dense[i] = mecs_entity_compose((mecs_entity_gen_t)io_component_store->free_slot, MECS_ENTITY_ID_INVALID);
+        io_component_store->free_slot = i;
+        io_component_store->tombstones_count += 1;
+    }
+
+    if (io_component_store->type->storage == MECS_STORAGE_PACKED)
+    {
+        mecs_component_store_compact(io_component_store);
+    }
 }
 
-void* mecs_component_get_last_component_element(mecs_component_store_t* i_component_store)
+void mecs_component_relocate(mecs_component_type_t* i_type, void* o_dst, void* io_src)
 {
-    mecs_entity_size_t page_index;
-    mecs_entity_size_t page_offset;
-    void* component_page;
-    void* component;
-    mecs_assert(i_component_store != NULL);
+    /* Move a component into uninitialised memory, leaving the source destructed. */
+    mecs_assert(i_type != NULL);
 
-    page_index = i_component_store->components_len - 1;
-    page_offset = (i_component_store->entities_count - 1) % MECS_PAGE_LEN_SPARSE;
-    component_page = i_component_store->components[page_index];
-    component = (void*)(((char*)component_page) + (page_offset * i_component_store->type->size));
-    return component;
+    if (i_type->move_and_dtor_func != NULL)
+    {
+        if (i_type->ctor_func != NULL)
+        {
+            i_type->ctor_func(o_dst);
+        }
+        i_type->move_and_dtor_func(io_src, o_dst);
+    }
+    else
+    {
+        memcpy(o_dst, io_src, i_type->size);
+    }
 }
 
-mecs_bool_t mecs_component_has_sparse_element(mecs_component_store_t const* i_component_store, mecs_entity_t i_entity)
+void mecs_component_store_merge(mecs_component_store_t* io_dst_store, mecs_component_store_t* io_src_store, mecs_entity_t const* i_remap)
 {
-    mecs_entity_size_t page_index;
-    mecs_entity_size_t page_offset;
-    mecs_sparse_t sparse_elem;
-    mecs_assert(i_component_store != NULL);
+    /* Move all components of io_src_store to the end of io_dst_store, renaming their entities through i_remap. 
+       Leaves io_src_store empty, the caller maps the new dense entries into the sparse set of io_dst_store. */
+    mecs_entity_size_t first_index;
+    mecs_entity_size_t first_page_index;
+    mecs_entity_size_t components_grown_size;
+    mecs_entity_size_t i;
+    mecs_entity_size_t block_idx;
+    void** components_grown;
+    mecs_dense_t* dense_grown;
+    mecs_assert(io_dst_store != NULL);
+    mecs_assert(io_src_store != NULL);
+    mecs_assert(io_dst_store->type == io_src_store->type);
 
-    page_index = mecs_entity_get_id(i_entity) / MECS_PAGE_LEN_SPARSE;
-    if (page_index >= i_component_store->sparse_len)
+    mecs_component_store_compact(io_src_store);
+    first_index = io_dst_store->entities_count;
+    if (io_src_store->entities_count == 0)
     {
-        return MECS_FALSE;
+        return;
     }
 
-    /* If there is no entity sparse_elem will have MECS_ENTITY_GENERATION_INVALID, else make sure the entity stored here has the same generation. 
-       Prevents accessing the dense array to check. */ 
-    page_offset = mecs_entity_get_id(i_entity) % MECS_PAGE_LEN_SPARSE;
-    sparse_elem = i_component_store->sparse[page_index]->block[page_offset];
-    if (mecs_entity_get_generation(sparse_elem) != mecs_entity_get_generation(i_entity)) 
+    if (first_index % MECS_PAGE_LEN_DENSE == 0)
     {
-        return MECS_FALSE;
+        /* The destination ends on a page boundary, so splice in the pages of the source in front of any unused pages.
+           Components never move, this is the common case when merging into an empty component store. */
+        first_page_index = first_index / MECS_PAGE_LEN_DENSE;
+        components_grown_size = io_dst_store->components_len + io_src_store->components_len;
+
+        /* Grow both arrays before touching the pages, a dense array larger than the pages need is harmless if growing the pages fails. */
+        dense_grown = mecs_realloc_arr(mecs_dense_t, io_dst_store->dense, components_grown_size * MECS_PAGE_LEN_DENSE);
+        if (dense_grown == NULL)
+        {
+            mecs_assert(MECS_FALSE);
+            return;
+        }
+        mecs_memset(dense_grown + first_index, 0xFF, ((components_grown_size * MECS_PAGE_LEN_DENSE) - first_index) * sizeof(mecs_dense_t)); /* Initialise all entiries to invalid entity. */
+        io_dst_store->dense = dense_grown;
+        components_grown = mecs_realloc_arr(void*, io_dst_store->components, components_grown_size);
+        if (components_grown == NULL)
+        {
+            mecs_assert(MECS_FALSE);
+            return;
+        }
+        io_dst_store->components = components_grown;
+
+        memmove(components_grown + first_page_index + io_src_store->components_len, components_grown + first_page_index, (io_dst_store->components_len - first_page_index) * sizeof(void*));
+        memcpy(components_grown + first_page_index, io_src_store->components, io_src_store->components_len * sizeof(void*));
+        io_dst_store->components_len = components_grown_size;
+        io_dst_store->entities_count += io_src_store->entities_count;
+
+        mecs_free(io_src_store->components);
+        io_src_store->components = NULL;
+        io_src_store->components_len = 0;
+    }
+    else
+    {
+        mecs_component_add_dense_elements(io_dst_store, io_src_store->entities_count);
+        for (i = 0; i < io_src_store->entities_count; ++i)
+        {
+            mecs_component_relocate(io_dst_store->type, mecs_component_get_component_element(io_dst_store, first_index + i), mecs_component_get_component_element(io_src_store, i));
+        }
     }
 
-    return MECS_TRUE;
+    for (i = 0; i < io_src_store->entities_count; ++i)
+    {
+        io_dst_store->dense[first_index + i] = i_remap[mecs_entity_get_id(io_src_store->dense[i])];
+    }
+
+    /* Forget all entities of the source, any remaining pages are kept to be reused. */
+    if (io_src_store->components_len != 0)
+    {
+        mecs_memset(io_src_store->dense, 0xFF, io_src_store->entities_count * sizeof(mecs_dense_t));
+    }
+    else if (io_src_store->dense != NULL)
+    {
+        mecs_free(io_src_store->dense);
+        io_src_store->dense = NULL;
+    }
+    for (block_idx = 0; block_idx < io_src_store->sparse_len; ++block_idx)
+    {
+        if (io_src_store->sparse[block_idx] != NULL)
+        {
+            mecs_memset(io_src_store->sparse[block_idx], 0xFF, sizeof(mecs_sparse_block_t));
+        }
+    }
+    io_src_store->entities_count = 0;
+}
+
+void* mecs_component_get_last_component_element(mecs_component_store_t* i_component_store)
+{
+    mecs_assert(i_component_store != NULL);
+    mecs_assert(i_component_store->entities_count > 0);
+
+    /* The components array may hold more pages than are in use, so locate the last component by its index. */
+    return mecs_component_get_component_element(i_component_store, i_component_store->entities_count - 1);
 }
 
 mecs_sparse_t* mecs_component_add_sparse_element(mecs_component_store_t* i_component_store, mecs_entity_t i_entity)
 {
     mecs_entity_size_t page_index;
     mecs_entity_size_t page_offset;
-    mecs_sparse_block_t** sparse_grown;
-    mecs_entity_size_t sparse_grown_count;
     mecs_sparse_block_t* sparse_page;
     mecs_assert(i_component_store != NULL);
 
     page_index = mecs_entity_get_id(i_entity) / MECS_PAGE_LEN_SPARSE;
     page_offset = mecs_entity_get_id(i_entity) % MECS_PAGE_LEN_SPARSE;
     
-    /* Get the page in the array of sparse pages that holds this entity. */
-    if (page_index >= i_component_store->sparse_len)
+    /* Get the page in the array of sparse pages that holds this entity. Don't allocate the page for this entity yet. */
+    if (page_index >= i_component_store->sparse_len && !mecs_component_grow_sparse(i_component_store, page_index + 1))
     {
-        /* Grow the array of sparse pages so we can hold the page for this entity. Don't allocate the page for this entity yet. */
-        sparse_grown = mecs_realloc_arr(mecs_sparse_block_t*, i_component_store->sparse, page_index + 1);
-        if (sparse_grown == NULL)
-        {
-            mecs_assert(MECS_FALSE);
-            return NULL;
-        }
-        sparse_grown_count = (page_index  - i_component_store->sparse_len) + 1;
-        mecs_memset(sparse_grown + i_component_store->sparse_len, 0x00, sparse_grown_count  * sizeof(mecs_sparse_block_t*)); /* Initialise all entires to NULL, an empty page. */
-        i_component_store->sparse = sparse_grown;
-        i_component_store->sparse_len = page_index + 1;
+        return NULL;
     }
     sparse_page = i_component_store->sparse[page_index];
 
@@ -1175,80 +2945,199 @@ void* mecs_component_add_dense_elements(mecs_component_store_t* i_component_stor
     mecs_entity_size_t first_page_index;
     mecs_entity_size_t first_page_offset;
     mecs_entity_size_t last_page_index;
-    mecs_entity_size_t last_page_offset;
+    void* components_page;
+    void* component;
+    mecs_assert(i_component_store != NULL);
+    mecs_assert(i_count > 0);
+
+    first_page_index = i_component_store->entities_count / MECS_PAGE_LEN_DENSE;
+    first_page_offset = i_component_store->entities_count % MECS_PAGE_LEN_DENSE;
+    last_page_index = (i_component_store->entities_count + i_count - 1) / MECS_PAGE_LEN_DENSE;
 
+    /* Allocate a new pages for the components if required. */
+    if (last_page_index >= i_component_store->components_len && !mecs_component_grow_pages(i_component_store, last_page_index + 1))
+    {
+        return NULL;
+    }
+
+    components_page = i_component_store->components[first_page_index];
+    component = (void*)(((char*)components_page) + (first_page_offset * i_component_store->type->size));
+    i_component_store->entities_count += i_count;
+    return component;
+}
+
+mecs_bool_t mecs_component_grow_sparse(mecs_component_store_t* io_component_store, mecs_entity_size_t i_sparse_len)
+{
+    /* Grow the array of sparse pages to hold i_sparse_len pages, the new pages are empty and allocated on first use. */
+    mecs_sparse_block_t** sparse_grown;
+    mecs_assert(io_component_store != NULL);
+    mecs_assert(i_sparse_len > io_component_store->sparse_len);
+
+    sparse_grown = mecs_realloc_arr(mecs_sparse_block_t*, io_component_store->sparse, i_sparse_len);
+    if (sparse_grown == NULL)
+    {
+        mecs_assert(MECS_FALSE);
+        return MECS_FALSE;
+    }
+    mecs_memset(sparse_grown + io_component_store->sparse_len, 0x00, (i_sparse_len - io_component_store->sparse_len) * sizeof(mecs_sparse_block_t*)); /* Initialise all entires to NULL, an empty page. */
+    io_component_store->sparse = sparse_grown;
+    io_component_store->sparse_len = i_sparse_len;
+    return MECS_TRUE;
+}
+
+mecs_bool_t mecs_component_grow_pages(mecs_component_store_t* io_component_store, mecs_entity_size_t i_components_len)
+{
+    /* Grow the array of component pages to i_components_len pages, allocating each page and growing the dense array to match. */
     mecs_entity_size_t components_grown_offset;
-    mecs_entity_size_t components_grown_size;
     void** components_grown;
     void* components_page;
     mecs_entity_size_t i;
-    mecs_entity_size_t dense_grown_offset;
-    mecs_entity_size_t dense_grown_size;
+    mecs_size_t dense_grown_offset;
+    mecs_size_t dense_grown_size;
     mecs_dense_t* dense_grown;
+    mecs_assert(io_component_store != NULL);
+    mecs_assert(i_components_len > io_component_store->components_len);
 
-    void* component;
-    mecs_assert(i_component_store != NULL);
-    mecs_assert(i_count > 0);
-
-    first_page_index = i_component_store->entities_count / MECS_PAGE_LEN_SPARSE;
-    first_page_offset = i_component_store->entities_count % MECS_PAGE_LEN_SPARSE;
-    last_page_index = (i_component_store->entities_count + i_count - 1) / MECS_PAGE_LEN_SPARSE;
-    last_page_offset = (i_component_store->entities_count + i_count - 1) % MECS_PAGE_LEN_SPARSE;
+    components_grown_offset = io_component_store->components_len;
+    components_grown = mecs_realloc_arr(void*, io_component_store->components, i_components_len);
+    if (components_grown == NULL)
+    {
+        mecs_assert(MECS_FALSE);
+        return MECS_FALSE;
+    }
+    io_component_store->components = components_grown;
+    io_component_store->components_len = i_components_len;
+    mecs_memset(components_grown + components_grown_offset, 0x00, (i_components_len - components_grown_offset) * sizeof(void*)); /* Initialise all pages to NULL. */
 
-    /* Allocate a new pages for the components if required. */
-    if (last_page_index >= i_component_store->components_len)
+    /* Allocate new component pages. */
+    for (i = components_grown_offset; i < i_components_len; ++i)
     {
-        /* Grow the array of component pages so we can hold the new pages. */
-        components_grown_offset = i_component_store->components_len;
-        components_grown_size = last_page_index + 1;
-        components_grown = mecs_realloc_arr(void*, i_component_store->components, components_grown_size);
-        if (components_grown == NULL)
+        components_page = mecs_realloc_aligned(io_component_store->components[i], MECS_PAGE_LEN_DENSE * io_component_store->type->size, io_component_store->type->alignment);
+        if (components_page == NULL)
         {
             mecs_assert(MECS_FALSE);
-            return NULL;
+            return MECS_FALSE;
         }
-        i_component_store->components = components_grown;
-        i_component_store->components_len = components_grown_size;
-        mecs_memset(components_grown + components_grown_offset, 0x00, (components_grown_size - components_grown_offset) * sizeof(void*)); /* Initialise all pages to NULL. */
+        io_component_store->components[i] = components_page;
+    }
+
+    /* Grow the dense array to match the entries in the components array. */
+    dense_grown_offset = (mecs_size_t)components_grown_offset * MECS_PAGE_LEN_DENSE;
+    dense_grown_size = (mecs_size_t)i_components_len * MECS_PAGE_LEN_DENSE;
+    dense_grown = mecs_realloc_arr(mecs_dense_t, io_component_store->dense, dense_grown_size);
+    if (dense_grown == NULL)
+    {
+        mecs_assert(MECS_FALSE);
+        return MECS_FALSE;
+    }
+    mecs_memset(dense_grown + dense_grown_offset, 0xFF, (dense_grown_size - dense_grown_offset) * sizeof(mecs_dense_t)); /* Initialise all entiries to invalid entity. */
+    io_component_store->dense = dense_grown;
+    return MECS_TRUE;
+}
+
+void mecs_component_add_sparse_elements(mecs_component_store_t* i_component_store, mecs_entity_size_t i_first_index, mecs_entity_size_t i_count)
+{
+    /* Bulk version of mecs_component_add_sparse_element for a range of the dense array which is already filled in. 
+       Grows the array of sparse pages and allocates all sparse pages up front so the entries can be scattered without any checks. */
+    mecs_dense_t* dense;
+    mecs_entity_size_t i;
+    mecs_entity_id_t entity_id;
+    mecs_entity_size_t page_index;
+    mecs_entity_size_t max_page_index;
+    mecs_sparse_block_t* sparse_page;
+    mecs_assert(i_component_store != NULL);
+    mecs_assert((mecs_size_t)i_first_index + i_count <= i_component_store->entities_count);
+
+    if (i_count == 0)
+    {
+        return;
+    }
+    dense = i_component_store->dense + i_first_index;
+
+    /* Grow the array of sparse pages once to hold the largest entity id. */
+    max_page_index = 0;
+    for (i = 0; i < i_count; ++i)
+    {
+        page_index = mecs_entity_get_id(dense[i]) / MECS_PAGE_LEN_SPARSE;
+        max_page_index = page_index > max_page_index ? page_index : max_page_index;
+    }
+    if (max_page_index >= i_component_store->sparse_len && !mecs_component_grow_sparse(i_component_store, max_page_index + 1))
+    {
+        return;
+    }
 
-        /* Allocate new component pages. */
-        for (i = components_grown_offset; i < components_grown_size; ++i)
+    /* Allocate all sparse pages we are going to write to. */
+    for (i = 0; i < i_count; ++i)
+    {
+        page_index = mecs_entity_get_id(dense[i]) / MECS_PAGE_LEN_SPARSE;
+        if (i_component_store->sparse[page_index] == NULL)
         {
-            components_page = mecs_realloc_aligned(i_component_store->components[i], MECS_PAGE_LEN_DENSE * i_component_store->type->size, i_component_store->type->alignment);
-            if (components_page == NULL)
+            sparse_page = mecs_malloc_type(mecs_sparse_block_t);
+            if (sparse_page == NULL)
             {
                 mecs_assert(MECS_FALSE);
-                return NULL;
+                return;
             }
-            i_component_store->components[i] = components_page;
-        }
-
-        /* Grow the dense array to match the entries in the components array. */
-        dense_grown_offset = components_grown_offset * MECS_PAGE_LEN_DENSE;
-        dense_grown_size = components_grown_size * MECS_PAGE_LEN_DENSE;
-        dense_grown = mecs_realloc_arr(mecs_dense_t, i_component_store->dense, dense_grown_size);
-        if (dense_grown == NULL)
-        {
-            mecs_assert(MECS_FALSE);
-            return NULL;
+            mecs_memset(sparse_page, 0xFF, sizeof(mecs_sparse_block_t)); /* Initialise all entires MECS_SPARSE_INVALID, indicates there is no component for this entity. */
+            i_component_store->sparse[page_index] = sparse_page;
         }
-        mecs_memset(dense_grown + dense_grown_offset, 0xFF, (dense_grown_size - dense_grown_offset) * sizeof(mecs_dense_t)); /* Initialise all entiries to invalid entity. */
-        i_component_store->dense = dense_grown;
     }
 
-    components_page = i_component_store->components[first_page_index];
-    component = (void*)(((char*)components_page) + (first_page_offset * i_component_store->type->size));
-    i_component_store->entities_count += i_count;
-    return component;
+    /* Scatter the generation and dense index of each entity into the sparse pages. */
+    for (i = 0; i < i_count; ++i)
+    {
+        entity_id = mecs_entity_get_id(dense[i]);
+        i_component_store->sparse[entity_id / MECS_PAGE_LEN_SPARSE]->block[entity_id % MECS_PAGE_LEN_SPARSE] = mecs_entity_compose(mecs_entity_get_generation(dense[i]), (mecs_entity_id_t)(i_first_index + i));
+    }
 }
 
 mecs_entity_t* mecs_entity_create_array(mecs_registry_t* io_registry, mecs_entity_size_t i_count)
+{
+    #if defined(MECS_THREAD_SAFE)
+        mecs_entity_t* entities;
+        mecs_assert(io_registry != NULL);
+        mecs_assert(i_count != 0);
+
+        /* The read lock only keeps the array in place, threads creating entities don't wait for each other. */
+        mecs_lock_read(&io_registry->entities_lock);
+        while ((entities = mecs_entity_create_array_atomic(io_registry, i_count)) == NULL && mecs_entity_grow_shared(io_registry, i_count)) {}
+        mecs_unlock_read(&io_registry->entities_lock);
+        return entities;
+    #else
+        return mecs_entity_create_array_unlocked(io_registry, i_count);
+    #endif
+}
+
+mecs_bool_t mecs_entity_create_array_copy(mecs_registry_t* io_registry, mecs_entity_size_t i_count, mecs_entity_t* o_entities)
+{
+    mecs_entity_t* entities;
+    mecs_assert(io_registry != NULL);
+    mecs_assert(o_entities != NULL);
+
+    #if defined(MECS_THREAD_SAFE)
+        /* Copy before releasing the read lock, another thread growing the entities may move the array right after. */
+        mecs_assert(i_count != 0);
+        mecs_lock_read(&io_registry->entities_lock);
+        while ((entities = mecs_entity_create_array_atomic(io_registry, i_count)) == NULL && mecs_entity_grow_shared(io_registry, i_count)) {}
+        if (entities != NULL)
+        {
+            memcpy(o_entities, entities, i_count * sizeof(mecs_entity_t));
+        }
+        mecs_unlock_read(&io_registry->entities_lock);
+    #else
+        entities = mecs_entity_create_array_unlocked(io_registry, i_count);
+        if (entities != NULL)
+        {
+            memcpy(o_entities, entities, i_count * sizeof(mecs_entity_t));
+        }
+    #endif
+    return entities != NULL;
+}
+
+mecs_entity_t* mecs_entity_create_array_unlocked(mecs_registry_t* io_registry, mecs_entity_size_t i_count)
 {
     mecs_entity_id_t free_entity_id;
     mecs_entity_gen_t free_entity_gen;
-
-    mecs_entity_size_t new_capacity;
-    mecs_entity_t* entities_grown;
     mecs_entity_size_t entities_grown_offset;
     mecs_entity_size_t i;
     mecs_entity_t entity;
@@ -1269,120 +3158,1599 @@ mecs_entity_t* mecs_entity_create_array(mecs_registry_t* io_registry, mecs_entit
     }
     else
     {
-        if (io_registry->entities_cap - io_registry->entities_len < i_count)
+        if (io_registry->entities_cap - io_registry->entities_len < i_count && !mecs_entity_grow(io_registry, i_count))
         {
-            /* Double array capcity to guarantee O(1) amortized. 
-               Ensure we don't overflow and utalise the full range of available ids. */
-            new_capacity = io_registry->entities_cap;
-            while (new_capacity - io_registry->entities_cap < i_count)
-            {
-                if (new_capacity <= ((mecs_entity_size_t)-1) - new_capacity)
-                {
-                    new_capacity = new_capacity * 2;
-                }
-                else
+            return NULL;
+        }
+
+        entities_grown_offset = io_registry->entities_len;
+        for (i = 0; i < i_count; ++i)
+        {
+            io_registry->entities[io_registry->entities_len] = mecs_entity_fresh(io_registry, (mecs_entity_id_t)io_registry->entities_len);
+            io_registry->entities_len += 1;
+        }
+
+        return &io_registry->entities[entities_grown_offset];
+    }
+}
+
+mecs_entity_t* mecs_entity_create_array_atomic(mecs_registry_t* io_registry, mecs_entity_size_t i_count)
+{
+    /* Creates entities alongside other threads, the caller holds the read lock of the entities. Returns NULL if the array is full. */
+    #if defined(MECS_THREAD_SAFE)
+        mecs_entity_t head;
+        mecs_entity_id_t free_entity_id;
+        mecs_entity_t free_entity;
+        mecs_uint32_t entities_len;
+        mecs_entity_size_t i;
+
+        if (i_count == 1)
+        {
+            /* Pop the head of the list of destroyed entities. If another thread changed the head since it was loaded, its count
+               differs and the swap fails, even when the same id got pushed back. */
+            for (head = mecs_atomic_load(&io_registry->next_free_entity); mecs_entity_get_id(head) != MECS_ENTITY_ID_INVALID; head = mecs_atomic_load(&io_registry->next_free_entity))
+            {
+                free_entity_id = mecs_entity_get_id(head);
+                free_entity = mecs_atomic_load(&io_registry->entities[free_entity_id]);
+                if (mecs_atomic_cas(&io_registry->next_free_entity, head, mecs_entity_compose((mecs_entity_gen_t)(mecs_entity_get_generation(head) + 1), mecs_entity_get_id(free_entity))))
+                {
+                    mecs_atomic_store(&io_registry->entities[free_entity_id], mecs_entity_compose(mecs_entity_get_generation(free_entity), free_entity_id));
+                    return &io_registry->entities[free_entity_id];
+                }
+            }
+        }
+
+        /* Claim ids at the end of the array, the capacity only changes under the write lock. */
+        do
+        {
+            entities_len = mecs_atomic_load(&io_registry->entities_len);
+            if (io_registry->entities_cap - entities_len < i_count)
+            {
+                return NULL;
+            }
+        } while (!mecs_atomic_cas(&io_registry->entities_len, entities_len, entities_len + i_count));
+
+        for (i = 0; i < i_count; ++i)
+        {
+            io_registry->entities[entities_len + i] = mecs_entity_fresh(io_registry, (mecs_entity_id_t)(entities_len + i));
+        }
+        return &io_registry->entities[entities_len];
+    #else
+        (void)io_registry;
+        (void)i_count;
+        return NULL;
+    #endif
+}
+
+mecs_entity_t mecs_entity_fresh(mecs_registry_t const* i_registry, mecs_entity_id_t i_id)
+{
+    /* Entity for an id at the end of the array, generation 0 unless the id was used before registry_clear. */
+    return i_id < i_registry->entities_used ? i_registry->entities[i_id] : (mecs_entity_t)i_id;
+}
+
+mecs_bool_t mecs_entity_grow_shared(mecs_registry_t* io_registry, mecs_entity_size_t i_count)
+{
+    /* Trades the read lock of the entities for the write lock while growing, another thread may have grown the array meanwhile. */
+    mecs_bool_t grown;
+
+    mecs_unlock_read(&io_registry->entities_lock);
+    mecs_lock_write(&io_registry->entities_lock);
+    grown = io_registry->entities_cap - io_registry->entities_len >= i_count || mecs_entity_grow(io_registry, i_count);
+    mecs_unlock_write(&io_registry->entities_lock);
+    mecs_lock_read(&io_registry->entities_lock);
+    return grown;
+}
+
+mecs_bool_t mecs_entity_grow(mecs_registry_t* io_registry, mecs_entity_size_t i_count)
+{
+    mecs_entity_size_t new_capacity;
+    mecs_entity_t* entities_grown;
+
+    /* Double array capcity to guarantee O(1) amortized. 
+       Ensure we don't overflow and utalise the full range of available ids. */
+    new_capacity = io_registry->entities_cap;
+    while (new_capacity - io_registry->entities_cap < i_count)
+    {
+        if (new_capacity <= ((mecs_entity_size_t)-1) - new_capacity)
+        {
+            new_capacity = new_capacity * 2;
+        }
+        else
+        {
+            new_capacity = (mecs_entity_size_t)-1;
+            break;
+        }
+    }
+
+    /* If we were unable to allocate enough capacity, abort. */
+    if (new_capacity - io_registry->entities_cap < i_count)
+    {
+        mecs_assert(MECS_FALSE);
+        return MECS_FALSE;
+    }
+
+    entities_grown = mecs_realloc_arr(mecs_entity_t, io_registry->entities, new_capacity);
+    if (entities_grown == NULL)
+    {
+        mecs_assert(MECS_FALSE);
+        return MECS_FALSE;
+    }
+
+    mecs_memset(entities_grown + io_registry->entities_cap, 0x00, sizeof(mecs_entity_t));
+    io_registry->entities = entities_grown;
+    io_registry->entities_cap = new_capacity;
+    return MECS_TRUE;
+}
+
+mecs_entity_t mecs_entity_create(mecs_registry_t* io_registry)
+{
+    mecs_entity_t* entity;
+    mecs_entity_t created;
+    mecs_assert(io_registry != NULL);
+
+    /* Read the entity before unlocking, other threads creating entities may move the array. */
+    #if defined(MECS_THREAD_SAFE)
+        mecs_lock_read(&io_registry->entities_lock);
+        while ((entity = mecs_entity_create_array_atomic(io_registry, 1)) == NULL && mecs_entity_grow_shared(io_registry, 1)) {}
+        created = entity != NULL ? *entity : MECS_ENTITY_INVALID;
+        mecs_unlock_read(&io_registry->entities_lock);
+    #else
+        entity = mecs_entity_create_array_unlocked(io_registry, 1);
+        created = entity != NULL ? *entity : MECS_ENTITY_INVALID;
+    #endif
+    mecs_assert(created != MECS_ENTITY_INVALID);
+    return created;
+}
+
+mecs_bool_t mecs_entity_destroy(mecs_registry_t* io_registry, mecs_entity_t i_entity)
+{
+    mecs_component_size_t i;
+    mecs_entity_id_t destroyed_id;
+    mecs_entity_gen_t destroyed_gen;
+    #if defined(MECS_THREAD_SAFE)
+        mecs_entity_t head;
+    #else
+        mecs_entity_id_t next_free_entity_id;
+    #endif
+    mecs_profile_begin("mecs_entity_destroy");
+    mecs_assert(io_registry != NULL);
+
+    if (mecs_entity_is_destroyed(io_registry, i_entity)) 
+    {
+        mecs_assert(MECS_FALSE);
+        mecs_profile_end("mecs_entity_destroy");
+        return MECS_FALSE;
+    }
+
+    /* Remove all components. Store locks are never taken while holding the entities lock, a thread creating entities 
+       within a query holds the read locks of its stores first. */
+    for (i = 0; i < io_registry->components_len; ++i)
+    {
+        if (io_registry->components[i].type == NULL)
+        {
+            continue;
+        }
+        mecs_lock_write(&io_registry->components[i].lock);
+        if (mecs_component_has_sparse_element(&io_registry->components[i], i_entity))
+        {
+            mecs_component_remove_element(io_registry, i_entity, io_registry->components[i].type, MECS_FALSE);
+        }
+        mecs_unlock_write(&io_registry->components[i].lock);
+    }
+
+    destroyed_id = mecs_entity_get_id(i_entity);
+    destroyed_gen = mecs_entity_get_generation(i_entity);
+
+    /* Increase generation so any entities still using this id become invalid as the generation won't match. */
+    destroyed_gen += 1;
+
+    /* Have the entity we're destroying point to the next free entity and update the head of our list to point to the entity we're destroying. */
+    mecs_lock_read(&io_registry->entities_lock);
+    #if defined(MECS_THREAD_SAFE)
+        do
+        {
+            head = mecs_atomic_load(&io_registry->next_free_entity);
+            mecs_atomic_store(&io_registry->entities[destroyed_id], mecs_entity_compose(destroyed_gen, mecs_entity_get_id(head)));
+        } while (!mecs_atomic_cas(&io_registry->next_free_entity, head, mecs_entity_compose((mecs_entity_gen_t)(mecs_entity_get_generation(head) + 1), destroyed_id)));
+    #else
+        next_free_entity_id = mecs_entity_get_id(io_registry->next_free_entity);
+        io_registry->entities[destroyed_id] = mecs_entity_compose(destroyed_gen, next_free_entity_id);
+        io_registry->next_free_entity = destroyed_id;
+    #endif
+    mecs_unlock_read(&io_registry->entities_lock);
+    mecs_profile_end("mecs_entity_destroy");
+    return MECS_TRUE;
+}
+
+mecs_size_t mecs_entity_destroy_array(mecs_registry_t* io_registry, mecs_entity_t const* i_entities, mecs_entity_size_t i_count)
+{
+    mecs_uint8_t* destroyed;
+    mecs_size_t destroyed_count;
+    mecs_component_store_t* component_store;
+    mecs_component_size_t component_idx;
+    mecs_entity_size_t i;
+    mecs_entity_id_t entity_id;
+    mecs_entity_id_t next_free_entity_id;
+    mecs_profile_begin("mecs_entity_destroy_array");
+    mecs_assert(io_registry != NULL);
+    mecs_assert(i_entities != NULL || i_count == 0);
+
+    /* Mark the ids of all entities to destroy, a bit per id. */
+    mecs_lock_write(&io_registry->entities_lock);
+    destroyed = mecs_malloc_arr(mecs_uint8_t, (io_registry->entities_len + 7) / 8 + 1);
+    if (destroyed == NULL)
+    {
+        mecs_unlock_write(&io_registry->entities_lock);
+        mecs_assert(MECS_FALSE);
+        mecs_profile_end("mecs_entity_destroy_array");
+        return 0;
+    }
+    mecs_memset(destroyed, 0x00, (io_registry->entities_len + 7) / 8 + 1);
+    destroyed_count = 0;
+    for (i = 0; i < i_count; ++i)
+    {
+        entity_id = mecs_entity_get_id(i_entities[i]);
+        if (mecs_entity_is_destroyed_unlocked(io_registry, i_entities[i]) || (destroyed[entity_id / 8] & (1 << (entity_id % 8))) != 0)
+        {
+            continue;
+        }
+        destroyed[entity_id / 8] |= (mecs_uint8_t)(1 << (entity_id % 8));
+        destroyed_count += 1;
+    }
+    mecs_unlock_write(&io_registry->entities_lock); /* Store locks are never taken while holding the entities lock. */
+
+    for (component_idx = 0; component_idx < io_registry->components_len && destroyed_count != 0; ++component_idx)
+    {
+        component_store = &io_registry->components[component_idx];
+        if (component_store->type == NULL || component_store->entities_count == 0)
+        {
+            continue;
+        }
+
+        /* Sweeping visits every component of the store, when only a few of them are destroyed probing per entity is cheaper. 
+           Removing hierarchy components updates the links of other entities, so they are always removed one by one. */
+        mecs_lock_write(&component_store->lock);
+        if (component_store->entities_count / 8 > destroyed_count || component_store->type == mecs_component_get_type_ptr(mecs_hierarchy_t))
+        {
+            for (i = 0; i < i_count; ++i)
+            {
+                entity_id = mecs_entity_get_id(i_entities[i]);
+                if ((destroyed[entity_id / 8] & (1 << (entity_id % 8))) != 0 && mecs_component_has_sparse_element(component_store, i_entities[i]))
+                {
+                    mecs_component_remove_element(io_registry, i_entities[i], component_store->type, MECS_FALSE);
+                }
+            }
+        }
+        else
+        {
+            mecs_component_store_sweep(component_store, destroyed);
+        }
+        mecs_unlock_write(&component_store->lock);
+    }
+
+    /* Chain the destroyed ids, bumping their generation, and put the chain in front of the list of destroyed entities. */
+    mecs_lock_write(&io_registry->entities_lock);
+    next_free_entity_id = mecs_entity_get_id(io_registry->next_free_entity);
+    for (i = 0; i < i_count; ++i)
+    {
+        entity_id = mecs_entity_get_id(i_entities[i]);
+        if ((destroyed[entity_id / 8] & (1 << (entity_id % 8))) == 0)
+        {
+            continue;
+        }
+        destroyed[entity_id / 8] &= (mecs_uint8_t)~(1 << (entity_id % 8)); /* Unmark so duplicates are only pushed once. */
+        io_registry->entities[entity_id] = mecs_entity_compose((mecs_entity_gen_t)(mecs_entity_get_generation(i_entities[i]) + 1), next_free_entity_id);
+        next_free_entity_id = entity_id;
+    }
+    #if defined(MECS_THREAD_SAFE)
+        io_registry->next_free_entity = mecs_entity_compose((mecs_entity_gen_t)(mecs_entity_get_generation(io_registry->next_free_entity) + 1), next_free_entity_id);
+    #else
+        io_registry->next_free_entity = next_free_entity_id;
+    #endif
+    mecs_unlock_write(&io_registry->entities_lock);
+
+    mecs_free(destroyed);
+    mecs_profile_end("mecs_entity_destroy_array");
+    return destroyed_count;
+}
+
+mecs_bool_t mecs_entity_is_destroyed(mecs_registry_t* io_registry, mecs_entity_t i_entity)
+{
+    mecs_bool_t is_destroyed;
+    mecs_assert(io_registry != NULL);
+
+    mecs_lock_read(&io_registry->entities_lock);
+    is_destroyed = mecs_entity_is_destroyed_unlocked(io_registry, i_entity);
+    mecs_unlock_read(&io_registry->entities_lock);
+    return is_destroyed;
+}
+
+mecs_bool_t mecs_entity_is_destroyed_unlocked(mecs_registry_t* io_registry, mecs_entity_t i_entity)
+{
+    mecs_entity_id_t entity_id;
+    mecs_entity_gen_t entity_gen;
+    mecs_entity_gen_t current_gen;
+    mecs_assert(io_registry != NULL);
+
+    entity_id = mecs_entity_get_id(i_entity);
+    entity_gen = mecs_entity_get_generation(i_entity);
+    /* Ids from before registry_clear not handed out again yet hold their bumped generation as well. */
+    #if defined(MECS_THREAD_SAFE)
+        /* Other threads may be reusing the id of a destroyed entity. */
+        mecs_assert(entity_id < mecs_atomic_load(&io_registry->entities_len) || entity_id < io_registry->entities_used);
+        current_gen = mecs_entity_get_generation(mecs_atomic_load(&io_registry->entities[entity_id]));
+    #else
+        mecs_assert(entity_id < io_registry->entities_len || entity_id < io_registry->entities_used);
+        current_gen = mecs_entity_get_generation(io_registry->entities[entity_id]);
+    #endif
+    if (entity_gen != current_gen)
+    {
+        return MECS_TRUE;
+    }
+    return MECS_FALSE;
+}
+
+mecs_index_t* mecs_index_create_impl(mecs_registry_t* io_registry, mecs_component_type_t* i_type, mecs_index_kind_t i_kind, mecs_index_key_func_t i_key_func)
+{
+    mecs_component_store_t* component_store;
+    mecs_index_t* index;
+    mecs_assert(io_registry != NULL);
+    mecs_assert(i_type != NULL);
+    mecs_assert(i_key_func != NULL);
+    mecs_assert(i_kind == MECS_INDEX_KIND_HASH_UNIQUE || i_kind == MECS_INDEX_KIND_HASH_MULTI || i_kind == MECS_INDEX_KIND_ORDERED);
+
+    if (i_type->id >= io_registry->components_len || io_registry->components[i_type->id].type != i_type)
+    {
+        /* Component must be registered with this registry. */
+        mecs_assert(MECS_FALSE);
+        return NULL;
+    }
+
+    index = mecs_malloc_type(mecs_index_t);
+    if (index == NULL)
+    {
+        mecs_assert(MECS_FALSE);
+        return NULL;
+    }
+    mecs_memset(index, 0x00, sizeof(mecs_index_t));
+    index->registry = io_registry;
+    index->type = i_type;
+    index->key_func = i_key_func;
+    index->kind = i_kind;
+
+    component_store = &io_registry->components[i_type->id];
+    index->next = component_store->indexes;
+    component_store->indexes = index;
+
+    /* Index all components the store already holds. */
+    mecs_index_rebuild(index);
+    return index;
+}
+
+void mecs_index_destroy(mecs_index_t* io_index)
+{
+    mecs_index_t** link;
+    mecs_assert(io_index != NULL);
+
+    /* Unlink from the component store. */
+    for (link = &io_index->registry->components[io_index->type->id].indexes; *link != io_index; link = &(*link)->next)
+    {
+        mecs_assert(*link != NULL);
+    }
+    *link = io_index->next;
+
+    if (io_index->entries != NULL)
+    {
+        mecs_free(io_index->entries);
+    }
+    if (io_index->keys != NULL)
+    {
+        mecs_free(io_index->keys);
+        mecs_free(io_index->states);
+    }
+    if (io_index->pending != NULL)
+    {
+        mecs_free(io_index->pending);
+    }
+    mecs_free(io_index);
+}
+
+void mecs_index_update_impl(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_component_type_t* i_type)
+{
+    mecs_index_t* index;
+    mecs_size_t sorted_len;
+    mecs_assert(io_registry != NULL);
+    mecs_assert(i_type != NULL);
+    mecs_assert(mecs_component_has_impl(io_registry, i_entity, i_type));
+
+    mecs_lock_write(&io_registry->components[i_type->id].lock);
+    for (index = io_registry->components[i_type->id].indexes; index != NULL; index = index->next)
+    {
+        mecs_index_erase_entity(index, i_entity);
+        sorted_len = index->entries_len;
+        mecs_index_insert_entity(index, i_entity);
+        if (index->kind == MECS_INDEX_KIND_ORDERED)
+        {
+            mecs_index_sort_entries(index, sorted_len);
+        }
+    }
+    mecs_unlock_write(&io_registry->components[i_type->id].lock);
+}
+
+void mecs_index_rebuild(mecs_index_t* io_index)
+{
+    mecs_component_store_t* component_store;
+    mecs_entity_size_t i;
+    mecs_assert(io_index != NULL);
+
+    /* Forget everything and index all components by their current key. */
+    if (io_index->kind != MECS_INDEX_KIND_ORDERED && io_index->entries_cap != 0)
+    {
+        mecs_memset(io_index->entries, 0xFF, io_index->entries_cap * sizeof(mecs_index_entry_t)); /* Initialise all entries to MECS_ENTITY_INVALID. */
+    }
+    io_index->entries_len = 0;
+    if (io_index->keys_cap != 0)
+    {
+        mecs_memset(io_index->states, MECS_INDEX_STATE_NONE, io_index->keys_cap * sizeof(mecs_uint8_t));
+    }
+    io_index->pending_len = 0;
+
+    component_store = &io_index->registry->components[io_index->type->id];
+    for (i = 0; i < component_store->entities_count; ++i)
+    {
+        if (mecs_entity_get_id(component_store->dense[i]) != MECS_ENTITY_ID_INVALID) /* Skip tombstones. */
+        {
+            mecs_index_insert_entity(io_index, component_store->dense[i]);
+        }
+    }
+    if (io_index->kind == MECS_INDEX_KIND_ORDERED)
+    {
+        mecs_index_sort_entries(io_index, 0);
+    }
+}
+
+mecs_entity_t mecs_index_find(mecs_index_t* io_index, mecs_uint64_t i_key)
+{
+    mecs_entity_t entity;
+    mecs_index_find_all(io_index, i_key, &entity, 1);
+    return entity;
+}
+
+mecs_size_t mecs_index_find_all(mecs_index_t* io_index, mecs_uint64_t i_key, mecs_entity_t* o_entities, mecs_size_t i_capacity)
+{
+    mecs_size_t count;
+    mecs_size_t mask;
+    mecs_size_t slot;
+    mecs_size_t i;
+    mecs_assert(io_index != NULL);
+    mecs_assert(o_entities != NULL || i_capacity == 0);
+
+    /* Lookups flush pending entries into the index, so they write lock its component store. */
+    mecs_lock_write(&io_index->registry->components[io_index->type->id].lock);
+    mecs_index_flush(io_index);
+    if (i_capacity != 0)
+    {
+        o_entities[0] = MECS_ENTITY_INVALID;
+    }
+
+    count = 0;
+    if (io_index->kind == MECS_INDEX_KIND_ORDERED)
+    {
+        for (i = mecs_index_lower_bound(io_index, i_key, 0); i < io_index->entries_len && io_index->entries[i].key == i_key; ++i)
+        {
+            if (count < i_capacity)
+            {
+                o_entities[count] = io_index->entries[i].entity;
+            }
+            count += 1;
+        }
+    }
+    else if (io_index->entries_cap != 0)
+    {
+        /* Linear probe until an empty entry, the table is never full so this always terminates. */
+        mask = io_index->entries_cap - 1;
+        for (slot = mecs_index_hash(i_key) & mask; io_index->entries[slot].entity != MECS_ENTITY_INVALID; slot = (slot + 1) & mask)
+        {
+            if (io_index->entries[slot].key == i_key)
+            {
+                if (count < i_capacity)
                 {
-                    new_capacity = (mecs_entity_size_t)-1;
-                    break;
+                    o_entities[count] = io_index->entries[slot].entity;
                 }
+                count += 1;
+            }
+        }
+    }
+    mecs_unlock_write(&io_index->registry->components[io_index->type->id].lock);
+    return count;
+}
+
+mecs_size_t mecs_index_find_range(mecs_index_t* io_index, mecs_uint64_t i_min, mecs_uint64_t i_max, mecs_entity_t* o_entities, mecs_size_t i_capacity)
+{
+    mecs_size_t count;
+    mecs_size_t i;
+    mecs_assert(io_index != NULL);
+    mecs_assert(o_entities != NULL || i_capacity == 0);
+
+    if (io_index->kind != MECS_INDEX_KIND_ORDERED)
+    {
+        /* Hash indexes don't keep their keys in order. */
+        mecs_assert(MECS_FALSE);
+        return 0;
+    }
+
+    mecs_lock_write(&io_index->registry->components[io_index->type->id].lock);
+    mecs_index_flush(io_index);
+    count = 0;
+    for (i = mecs_index_lower_bound(io_index, i_min, 0); i < io_index->entries_len && io_index->entries[i].key <= i_max; ++i)
+    {
+        if (count < i_capacity)
+        {
+            o_entities[count] = io_index->entries[i].entity;
+        }
+        count += 1;
+    }
+    mecs_unlock_write(&io_index->registry->components[io_index->type->id].lock);
+    return count;
+}
+
+mecs_uint32_t mecs_index_hash(mecs_uint64_t i_key)
+{
+    /* Fold into 32 bits and finalise with the murmur3 mixer, so keys which only differ in a few bits spread over the table. */
+    mecs_uint32_t hash;
+
+    hash = (mecs_uint32_t)(i_key ^ (i_key >> 32));
+    hash ^= hash >> 16;
+    hash = (mecs_uint32_t)(hash * 0x85ebca6bu);
+    hash ^= hash >> 13;
+    hash = (mecs_uint32_t)(hash * 0xc2b2ae35u);
+    hash ^= hash >> 16;
+    return hash;
+}
+
+mecs_size_t mecs_index_lower_bound(mecs_index_t const* i_index, mecs_uint64_t i_key, mecs_entity_t i_entity)
+{
+    /* First entry of an ordered index which does not compare less than the key and entity pair. */
+    mecs_size_t first;
+    mecs_size_t count;
+    mecs_size_t step;
+    mecs_index_entry_t const* entry;
+    mecs_assert(i_index != NULL);
+
+    first = 0;
+    count = i_index->entries_len;
+    while (count > 0)
+    {
+        step = count / 2;
+        entry = &i_index->entries[first + step];
+        if (entry->key < i_key || (entry->key == i_key && entry->entity < i_entity))
+        {
+            first += step + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+    return first;
+}
+
+mecs_bool_t mecs_index_insert_entry(mecs_index_t* io_index, mecs_uint64_t i_key, mecs_entity_t i_entity)
+{
+    mecs_index_entry_t* entries_grown;
+    mecs_size_t entries_grown_cap;
+    mecs_size_t mask;
+    mecs_size_t slot;
+    mecs_size_t i;
+    mecs_assert(io_index != NULL);
+
+    if (io_index->kind == MECS_INDEX_KIND_ORDERED)
+    {
+        if (io_index->entries_len == io_index->entries_cap)
+        {
+            entries_grown_cap = io_index->entries_cap == 0 ? 16 : io_index->entries_cap * 2;
+            entries_grown = mecs_realloc_arr(mecs_index_entry_t, io_index->entries, entries_grown_cap);
+            if (entries_grown == NULL)
+            {
+                mecs_assert(MECS_FALSE);
+                return MECS_FALSE;
+            }
+            io_index->entries = entries_grown;
+            io_index->entries_cap = entries_grown_cap;
+        }
+
+        /* Append only, the caller sorts all appended entries in one go. */
+        io_index->entries[io_index->entries_len].key = i_key;
+        io_index->entries[io_index->entries_len].entity = i_entity;
+        io_index->entries_len += 1;
+        return MECS_TRUE;
+    }
+
+    if (io_index->kind == MECS_INDEX_KIND_HASH_UNIQUE && io_index->entries_cap != 0)
+    {
+        mask = io_index->entries_cap - 1;
+        for (slot = mecs_index_hash(i_key) & mask; io_index->entries[slot].entity != MECS_ENTITY_INVALID; slot = (slot + 1) & mask)
+        {
+            if (io_index->entries[slot].key == i_key)
+            {
+                /* Another entity is already indexed with this key. */
+                mecs_assert(MECS_FALSE);
+                return MECS_FALSE;
+            }
+        }
+    }
+
+    /* Keep the load factor at or below 50%. Grow by rehashing all entries into a new table. */
+    if ((io_index->entries_len + 1) * 2 > io_index->entries_cap)
+    {
+        entries_grown_cap = io_index->entries_cap == 0 ? 16 : io_index->entries_cap * 2;
+        entries_grown = mecs_malloc_arr(mecs_index_entry_t, entries_grown_cap);
+        if (entries_grown == NULL)
+        {
+            mecs_assert(MECS_FALSE);
+            return MECS_FALSE;
+        }
+        mecs_memset(entries_grown, 0xFF, entries_grown_cap * sizeof(mecs_index_entry_t)); /* Initialise all entries to MECS_ENTITY_INVALID. */
+
+        mask = entries_grown_cap - 1;
+        for (i = 0; i < io_index->entries_cap; ++i)
+        {
+            if (io_index->entries[i].entity == MECS_ENTITY_INVALID)
+            {
+                continue;
+            }
+            for (slot = mecs_index_hash(io_index->entries[i].key) & mask; entries_grown[slot].entity != MECS_ENTITY_INVALID; slot = (slot + 1) & mask);
+            entries_grown[slot] = io_index->entries[i];
+        }
+
+        if (io_index->entries != NULL)
+        {
+            mecs_free(io_index->entries);
+        }
+        io_index->entries = entries_grown;
+        io_index->entries_cap = entries_grown_cap;
+    }
+
+    mask = io_index->entries_cap - 1;
+    for (slot = mecs_index_hash(i_key) & mask; io_index->entries[slot].entity != MECS_ENTITY_INVALID; slot = (slot + 1) & mask);
+    io_index->entries[slot].key = i_key;
+    io_index->entries[slot].entity = i_entity;
+    io_index->entries_len += 1;
+    return MECS_TRUE;
+}
+
+void mecs_index_sort_entries(mecs_index_t* io_index, mecs_size_t i_sorted_len)
+{
+    /* Sort the entries of an ordered index appended after i_sorted_len with a bottom up merge sort,
+       then merge them into the sorted front in a single pass from the back. */
+    mecs_index_entry_t* entries;
+    mecs_index_entry_t* scratch;
+    mecs_index_entry_t* src;
+    mecs_index_entry_t* dst;
+    mecs_index_entry_t* swap;
+    mecs_index_entry_t entry;
+    mecs_size_t tail_len;
+    mecs_size_t width;
+    mecs_size_t lo;
+    mecs_size_t mid;
+    mecs_size_t hi;
+    mecs_size_t a;
+    mecs_size_t b;
+    mecs_size_t i;
+    mecs_size_t j;
+    mecs_assert(io_index != NULL);
+    mecs_assert(io_index->kind == MECS_INDEX_KIND_ORDERED);
+    mecs_assert(i_sorted_len <= io_index->entries_len);
+
+    entries = io_index->entries;
+    tail_len = io_index->entries_len - i_sorted_len;
+    scratch = tail_len > 1 ? mecs_malloc_arr(mecs_index_entry_t, tail_len) : NULL;
+    if (scratch == NULL)
+    {
+        /* A single entry or out of memory, insert the appended entries one at a time. */
+        mecs_assert(tail_len <= 1);
+        for (i = i_sorted_len; i < io_index->entries_len; ++i)
+        {
+            entry = entries[i];
+            for (j = i; j > 0 && (entry.key < entries[j - 1].key || (entry.key == entries[j - 1].key && entry.entity < entries[j - 1].entity)); --j)
+            {
+                entries[j] = entries[j - 1];
+            }
+            entries[j] = entry;
+        }
+        return;
+    }
+
+    src = entries + i_sorted_len;
+    dst = scratch;
+    for (width = 1; width < tail_len; width *= 2)
+    {
+        for (lo = 0; lo < tail_len; lo = hi)
+        {
+            mid = lo + width < tail_len ? lo + width : tail_len;
+            hi = mid + width < tail_len ? mid + width : tail_len;
+            for (a = lo, b = mid, i = lo; i < hi; ++i)
+            {
+                if (b == hi || (a < mid && (src[a].key < src[b].key || (src[a].key == src[b].key && src[a].entity < src[b].entity))))
+                {
+                    dst[i] = src[a++];
+                }
+                else
+                {
+                    dst[i] = src[b++];
+                }
+            }
+        }
+        swap = src;
+        src = dst;
+        dst = swap;
+    }
+    if (src != scratch)
+    {
+        memmove(scratch, src, tail_len * sizeof(mecs_index_entry_t));
+    }
+
+    /* Merge from the back so entries of the front only move once, into space already taken by the tail. */
+    a = i_sorted_len;
+    b = tail_len;
+    for (i = io_index->entries_len; b > 0; --i)
+    {
+        if (a > 0 && (scratch[b - 1].key < entries[a - 1].key || (scratch[b - 1].key == entries[a - 1].key && scratch[b - 1].entity < entries[a - 1].entity)))
+        {
+            entries[i - 1] = entries[--a];
+        }
+        else
+        {
+            entries[i - 1] = scratch[--b];
+        }
+    }
+    mecs_free(scratch);
+}
+
+void mecs_index_erase_entry(mecs_index_t* io_index, mecs_uint64_t i_key, mecs_entity_t i_entity)
+{
+    mecs_size_t mask;
+    mecs_size_t slot;
+    mecs_size_t next;
+    mecs_size_t home;
+    mecs_size_t i;
+    mecs_assert(io_index != NULL);
+
+    if (io_index->kind == MECS_INDEX_KIND_ORDERED)
+    {
+        i = mecs_index_lower_bound(io_index, i_key, i_entity);
+        mecs_assert(i < io_index->entries_len && io_index->entries[i].key == i_key && io_index->entries[i].entity == i_entity);
+        memmove(&io_index->entries[i], &io_index->entries[i + 1], (io_index->entries_len - i - 1) * sizeof(mecs_index_entry_t));
+        io_index->entries_len -= 1;
+        return;
+    }
+
+    mask = io_index->entries_cap - 1;
+    for (slot = mecs_index_hash(i_key) & mask; io_index->entries[slot].entity != i_entity || io_index->entries[slot].key != i_key; slot = (slot + 1) & mask)
+    {
+        mecs_assert(io_index->entries[slot].entity != MECS_ENTITY_INVALID); /* Entry must be in the index. */
+    }
+
+    /* Shift back following entries which would no longer be reachable through the emptied entry, instead of leaving a tombstone. */
+    for (next = (slot + 1) & mask; io_index->entries[next].entity != MECS_ENTITY_INVALID; next = (next + 1) & mask)
+    {
+        home = mecs_index_hash(io_index->entries[next].key) & mask;
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            io_index->entries[slot] = io_index->entries[next];
+            slot = next;
+        }
+    }
+    io_index->entries[slot].entity = MECS_ENTITY_INVALID;
+    io_index->entries_len -= 1;
+}
+
+void mecs_index_insert_entity(mecs_index_t* io_index, mecs_entity_t i_entity)
+{
+    mecs_entity_id_t entity_id;
+    mecs_uint64_t key;
+    mecs_assert(io_index != NULL);
+
+    entity_id = mecs_entity_get_id(i_entity);
+    if (!mecs_index_reserve_keys(io_index, entity_id))
+    {
+        return;
+    }
+
+    key = io_index->key_func(mecs_component_store_get(&io_index->registry->components[io_index->type->id], i_entity));
+    if (mecs_index_insert_entry(io_index, key, i_entity))
+    {
+        io_index->keys[entity_id] = key;
+        io_index->states[entity_id] = MECS_INDEX_STATE_INDEXED;
+    }
+    else
+    {
+        io_index->states[entity_id] = MECS_INDEX_STATE_NONE;
+    }
+}
+
+void mecs_index_erase_entity(mecs_index_t* io_index, mecs_entity_t i_entity)
+{
+    mecs_entity_id_t entity_id;
+    mecs_assert(io_index != NULL);
+
+    entity_id = mecs_entity_get_id(i_entity);
+    if (entity_id >= io_index->keys_cap)
+    {
+        return;
+    }
+    if (io_index->states[entity_id] == MECS_INDEX_STATE_INDEXED)
+    {
+        mecs_index_erase_entry(io_index, io_index->keys[entity_id], i_entity);
+    }
+    io_index->states[entity_id] = MECS_INDEX_STATE_NONE; /* Any pending entry is skipped once its state is gone. */
+}
+
+mecs_bool_t mecs_index_reserve_keys(mecs_index_t* io_index, mecs_entity_id_t i_entity_id)
+{
+    mecs_size_t keys_grown_cap;
+    mecs_uint64_t* keys_grown;
+    mecs_uint8_t* states_grown;
+    mecs_assert(io_index != NULL);
+
+    if (i_entity_id < io_index->keys_cap)
+    {
+        return MECS_TRUE;
+    }
+
+    keys_grown_cap = io_index->keys_cap == 0 ? 64 : io_index->keys_cap;
+    while (keys_grown_cap <= i_entity_id)
+    {
+        keys_grown_cap *= 2;
+    }
+    keys_grown = mecs_realloc_arr(mecs_uint64_t, io_index->keys, keys_grown_cap);
+    if (keys_grown == NULL)
+    {
+        mecs_assert(MECS_FALSE);
+        return MECS_FALSE;
+    }
+    io_index->keys = keys_grown;
+    states_grown = mecs_realloc_arr(mecs_uint8_t, io_index->states, keys_grown_cap);
+    if (states_grown == NULL)
+    {
+        mecs_assert(MECS_FALSE);
+        return MECS_FALSE;
+    }
+    mecs_memset(states_grown + io_index->keys_cap, MECS_INDEX_STATE_NONE, (keys_grown_cap - io_index->keys_cap) * sizeof(mecs_uint8_t));
+    io_index->states = states_grown;
+    io_index->keys_cap = keys_grown_cap;
+    return MECS_TRUE;
+}
+
+void mecs_index_add_pending(mecs_index_t* io_index, mecs_entity_t i_entity)
+{
+    mecs_component_store_t* component_store;
+    mecs_entity_id_t entity_id;
+    mecs_size_t pending_grown_cap;
+    mecs_entity_t* pending_grown;
+    mecs_size_t pending_len;
+    mecs_size_t i;
+    mecs_assert(io_index != NULL);
+
+    entity_id = mecs_entity_get_id(i_entity);
+    if (!mecs_index_reserve_keys(io_index, entity_id))
+    {
+        return;
+    }
+
+    if (io_index->pending_len == io_index->pending_cap)
+    {
+        /* Drop entities which have been removed again before growing. */
+        component_store = &io_index->registry->components[io_index->type->id];
+        pending_len = 0;
+        for (i = 0; i < io_index->pending_len; ++i)
+        {
+            if (io_index->states[mecs_entity_get_id(io_index->pending[i])] == MECS_INDEX_STATE_PENDING && mecs_component_has_sparse_element(component_store, io_index->pending[i]))
+            {
+                io_index->pending[pending_len++] = io_index->pending[i];
+            }
+        }
+        io_index->pending_len = pending_len;
+
+        if (io_index->pending_len * 2 >= io_index->pending_cap)
+        {
+            pending_grown_cap = io_index->pending_cap == 0 ? 16 : io_index->pending_cap * 2;
+            pending_grown = mecs_realloc_arr(mecs_entity_t, io_index->pending, pending_grown_cap);
+            if (pending_grown == NULL)
+            {
+                mecs_assert(MECS_FALSE);
+                return;
+            }
+            io_index->pending = pending_grown;
+            io_index->pending_cap = pending_grown_cap;
+        }
+    }
+
+    io_index->pending[io_index->pending_len++] = i_entity;
+    io_index->states[entity_id] = MECS_INDEX_STATE_PENDING;
+}
+
+void mecs_index_flush(mecs_index_t* io_index)
+{
+    mecs_component_store_t* component_store;
+    mecs_size_t pending_len;
+    mecs_size_t sorted_len;
+    mecs_size_t i;
+    mecs_entity_t entity;
+    mecs_assert(io_index != NULL);
+
+    component_store = &io_index->registry->components[io_index->type->id];
+    sorted_len = io_index->entries_len;
+    pending_len = io_index->pending_len;
+    io_index->pending_len = 0;
+    for (i = 0; i < pending_len; ++i)
+    {
+        entity = io_index->pending[i];
+        if (io_index->states[mecs_entity_get_id(entity)] == MECS_INDEX_STATE_PENDING && mecs_component_has_sparse_element(component_store, entity))
+        {
+            mecs_index_insert_entity(io_index, entity);
+        }
+    }
+    if (io_index->kind == MECS_INDEX_KIND_ORDERED)
+    {
+        mecs_index_sort_entries(io_index, sorted_len);
+    }
+}
+
+#if !defined(__cplusplus)
+    mecs_component_type_t mecs_component_type_mecs_hierarchy_t;
+#endif
+
+mecs_bool_t mecs_hierarchy_is_registered(mecs_registry_t const* i_registry)
+{
+    mecs_component_type_t* type;
+    mecs_assert(i_registry != NULL);
+
+    type = mecs_component_get_type_ptr(mecs_hierarchy_t);
+    return type->id < i_registry->components_len && i_registry->components[type->id].type == type;
+}
+
+void mecs_hierarchy_set_parent(mecs_registry_t* io_registry, mecs_entity_t i_child, mecs_entity_t i_parent)
+{
+    mecs_component_type_t* type;
+    mecs_hierarchy_t* child;
+    mecs_hierarchy_t* parent;
+    mecs_entity_t ancestor;
+    mecs_assert(io_registry != NULL);
+    mecs_assert(i_child != i_parent);
+
+    type = mecs_component_get_type_ptr(mecs_hierarchy_t);
+    mecs_assert(mecs_hierarchy_is_registered(io_registry));
+
+    if (!mecs_component_has_impl(io_registry, i_child, type))
+    {
+        mecs_component_add_impl(io_registry, i_child, type);
+    }
+    mecs_hierarchy_detach(io_registry, i_child);
+    if (i_parent == MECS_ENTITY_INVALID)
+    {
+        return;
+    }
+
+    if (!mecs_component_has_impl(io_registry, i_parent, type))
+    {
+        mecs_component_add_impl(io_registry, i_parent, type);
+    }
+    for (ancestor = i_parent; ancestor != MECS_ENTITY_INVALID; ancestor = ((mecs_hierarchy_t*)mecs_component_get_impl(io_registry, ancestor, type))->parent)
+    {
+        if (ancestor == i_child)
+        {
+            /* An entity can't become a child of one of its own descendants. */
+            mecs_assert(MECS_FALSE);
+            return;
+        }
+    }
+
+    /* Component pages never move when adding components, so these stay valid. */
+    child = (mecs_hierarchy_t*)mecs_component_get_impl(io_registry, i_child, type);
+    parent = (mecs_hierarchy_t*)mecs_component_get_impl(io_registry, i_parent, type);
+    child->parent = i_parent;
+    child->next_sibling = parent->first_child;
+    child->prev_sibling = MECS_ENTITY_INVALID;
+    if (parent->first_child != MECS_ENTITY_INVALID)
+    {
+        ((mecs_hierarchy_t*)mecs_component_get_impl(io_registry, parent->first_child, type))->prev_sibling = i_child;
+    }
+    parent->first_child = i_child;
+    io_registry->hierarchy_sorted = MECS_FALSE;
+}
+
+mecs_entity_t mecs_hierarchy_get_parent(mecs_registry_t* io_registry, mecs_entity_t i_entity)
+{
+    mecs_component_type_t* type;
+    mecs_assert(io_registry != NULL);
+
+    type = mecs_component_get_type_ptr(mecs_hierarchy_t);
+    if (!mecs_hierarchy_is_registered(io_registry) || !mecs_component_has_impl(io_registry, i_entity, type))
+    {
+        return MECS_ENTITY_INVALID;
+    }
+    return ((mecs_hierarchy_t*)mecs_component_get_impl(io_registry, i_entity, type))->parent;
+}
+
+void mecs_hierarchy_begin(mecs_registry_t* io_registry, mecs_hierarchy_it_t* o_hierarchy_it)
+{
+    mecs_component_type_t* type;
+    mecs_assert(io_registry != NULL);
+    mecs_assert(o_hierarchy_it != NULL);
+
+    type = mecs_component_get_type_ptr(mecs_hierarchy_t);
+    mecs_assert(mecs_hierarchy_is_registered(io_registry));
+
+    mecs_hierarchy_sort(io_registry);
+    o_hierarchy_it->component_store = &io_registry->components[type->id];
+    o_hierarchy_it->index = 0;
+    o_hierarchy_it->entity = MECS_ENTITY_INVALID;
+    o_hierarchy_it->hierarchy = NULL;
+}
+
+mecs_bool_t mecs_hierarchy_next(mecs_hierarchy_it_t* io_hierarchy_it)
+{
+    mecs_assert(io_hierarchy_it != NULL);
+
+    if (io_hierarchy_it->index >= io_hierarchy_it->component_store->entities_count)
+    {
+        return MECS_FALSE;
+    }
+    io_hierarchy_it->entity = io_hierarchy_it->component_store->dense[io_hierarchy_it->index];
+    io_hierarchy_it->hierarchy = (mecs_hierarchy_t*)mecs_component_get_component_element(io_hierarchy_it->component_store, io_hierarchy_it->index);
+    io_hierarchy_it->index += 1;
+    return MECS_TRUE;
+}
+
+void mecs_hierarchy_destroy_recursive(mecs_registry_t* io_registry, mecs_entity_t i_entity)
+{
+    mecs_component_type_t* type;
+    mecs_component_store_t* component_store;
+    mecs_entity_t* subtree;
+    mecs_size_t subtree_len;
+    mecs_size_t i;
+    mecs_hierarchy_t* hierarchy;
+    mecs_entity_t child;
+    mecs_assert(io_registry != NULL);
+
+    type = mecs_component_get_type_ptr(mecs_hierarchy_t);
+    if (!mecs_hierarchy_is_registered(io_registry) || !mecs_component_has_impl(io_registry, i_entity, type))
+    {
+        mecs_entity_destroy(io_registry, i_entity);
+        return;
+    }
+
+    /* Gather the subtree breadth first, the list itself serves as the queue. */
+    component_store = &io_registry->components[type->id];
+    subtree = mecs_malloc_arr(mecs_entity_t, component_store->entities_count);
+    if (subtree == NULL)
+    {
+        mecs_assert(MECS_FALSE);
+        return;
+    }
+    mecs_hierarchy_detach(io_registry, i_entity);
+    subtree[0] = i_entity;
+    subtree_len = 1;
+    for (i = 0; i < subtree_len; ++i)
+    {
+        hierarchy = (mecs_hierarchy_t*)mecs_component_get_impl(io_registry, subtree[i], type);
+        for (child = hierarchy->first_child; child != MECS_ENTITY_INVALID; child = ((mecs_hierarchy_t*)mecs_component_get_impl(io_registry, child, type))->next_sibling)
+        {
+            subtree[subtree_len++] = child;
+        }
+    }
+
+    /* Cut all links so removing the hierarchy components doesn't need to touch any other entity. */
+    for (i = 0; i < subtree_len; ++i)
+    {
+        mecs_memset(mecs_component_get_impl(io_registry, subtree[i], type), 0xFF, sizeof(mecs_hierarchy_t));
+    }
+    mecs_entity_destroy_array(io_registry, subtree, (mecs_entity_size_t)subtree_len);
+    mecs_free(subtree);
+}
+
+void mecs_hierarchy_sort(mecs_registry_t* io_registry)
+{
+    mecs_component_type_t* type;
+    mecs_component_store_t* component_store;
+    mecs_entity_t* order;
+    mecs_hierarchy_t* sorted;
+    mecs_size_t order_len;
+    mecs_entity_size_t i;
+    mecs_entity_t root;
+    mecs_entity_t node;
+    mecs_hierarchy_t* hierarchy;
+    mecs_assert(io_registry != NULL);
+
+    if (io_registry->hierarchy_sorted)
+    {
+        return;
+    }
+
+    type = mecs_component_get_type_ptr(mecs_hierarchy_t);
+    component_store = &io_registry->components[type->id];
+    if (component_store->entities_count == 0)
+    {
+        io_registry->hierarchy_sorted = MECS_TRUE;
+        return;
+    }
+
+    order = mecs_malloc_arr(mecs_entity_t, component_store->entities_count);
+    sorted = mecs_malloc_arr(mecs_hierarchy_t, component_store->entities_count);
+    if (order == NULL || sorted == NULL)
+    {
+        mecs_assert(MECS_FALSE);
+        if (order != NULL)
+        {
+            mecs_free(order);
+        }
+        if (sorted != NULL)
+        {
+            mecs_free(sorted);
+        }
+        return;
+    }
+
+    /* Walk each tree depth first, without a stack by climbing back up through the parent links. */
+    order_len = 0;
+    for (i = 0; i < component_store->entities_count; ++i)
+    {
+        root = component_store->dense[i];
+        if (((mecs_hierarchy_t*)mecs_component_get_component_element(component_store, i))->parent != MECS_ENTITY_INVALID)
+        {
+            continue;
+        }
+
+        node = root;
+        for (;;)
+        {
+            hierarchy = (mecs_hierarchy_t*)mecs_component_get_impl(io_registry, node, type);
+            order[order_len] = node;
+            sorted[order_len] = *hierarchy;
+            order_len += 1;
+            if (hierarchy->first_child != MECS_ENTITY_INVALID)
+            {
+                node = hierarchy->first_child;
+                continue;
+            }
+            while (node != root && hierarchy->next_sibling == MECS_ENTITY_INVALID)
+            {
+                node = hierarchy->parent;
+                hierarchy = (mecs_hierarchy_t*)mecs_component_get_impl(io_registry, node, type);
+            }
+            if (node == root)
+            {
+                break;
+            }
+            node = hierarchy->next_sibling;
+        }
+    }
+    mecs_assert(order_len == component_store->entities_count);
+
+    /* Write back in the new order and point the sparse set to the new dense indices. */
+    for (i = 0; i < component_store->entities_count; ++i)
+    {
+        component_store->dense[i] = order[i];
+        *(mecs_hierarchy_t*)mecs_component_get_component_element(component_store, i) = sorted[i];
+    }
+    mecs_component_add_sparse_elements(component_store, 0, component_store->entities_count);
+
+    mecs_free(order);
+    mecs_free(sorted);
+    io_registry->hierarchy_sorted = MECS_TRUE;
+}
+
+void mecs_hierarchy_detach(mecs_registry_t* io_registry, mecs_entity_t i_entity)
+{
+    /* Remove an entity from the children of its parent. */
+    mecs_component_store_t* component_store;
+    mecs_hierarchy_t* hierarchy;
+    mecs_assert(io_registry != NULL);
+
+    /* Called by removing the hierarchy component, which holds the lock of its store already. */
+    component_store = &io_registry->components[mecs_component_get_type_ptr(mecs_hierarchy_t)->id];
+    hierarchy = (mecs_hierarchy_t*)mecs_component_store_get(component_store, i_entity);
+    if (hierarchy->parent == MECS_ENTITY_INVALID)
+    {
+        return;
+    }
+
+    if (hierarchy->prev_sibling != MECS_ENTITY_INVALID)
+    {
+        ((mecs_hierarchy_t*)mecs_component_store_get(component_store, hierarchy->prev_sibling))->next_sibling = hierarchy->next_sibling;
+    }
+    else
+    {
+        ((mecs_hierarchy_t*)mecs_component_store_get(component_store, hierarchy->parent))->first_child = hierarchy->next_sibling;
+    }
+    if (hierarchy->next_sibling != MECS_ENTITY_INVALID)
+    {
+        ((mecs_hierarchy_t*)mecs_component_store_get(component_store, hierarchy->next_sibling))->prev_sibling = hierarchy->prev_sibling;
+    }
+    hierarchy->parent = MECS_ENTITY_INVALID;
+    hierarchy->next_sibling = MECS_ENTITY_INVALID;
+    hierarchy->prev_sibling = MECS_ENTITY_INVALID;
+    io_registry->hierarchy_sorted = MECS_FALSE;
+}
+
+void mecs_hierarchy_unlink(mecs_registry_t* io_registry, mecs_entity_t i_entity)
+{
+    /* Detach an entity from its parent and turn its children into roots. */
+    mecs_component_store_t* component_store;
+    mecs_hierarchy_t* hierarchy;
+    mecs_hierarchy_t* child;
+    mecs_entity_t child_entity;
+    mecs_assert(io_registry != NULL);
+
+    component_store = &io_registry->components[mecs_component_get_type_ptr(mecs_hierarchy_t)->id];
+    mecs_hierarchy_detach(io_registry, i_entity);
+    hierarchy = (mecs_hierarchy_t*)mecs_component_store_get(component_store, i_entity);
+    child_entity = hierarchy->first_child;
+    while (child_entity != MECS_ENTITY_INVALID)
+    {
+        child = (mecs_hierarchy_t*)mecs_component_store_get(component_store, child_entity);
+        child_entity = child->next_sibling;
+        child->parent = MECS_ENTITY_INVALID;
+        child->next_sibling = MECS_ENTITY_INVALID;
+        child->prev_sibling = MECS_ENTITY_INVALID;
+    }
+    hierarchy->first_child = MECS_ENTITY_INVALID;
+    io_registry->hierarchy_sorted = MECS_FALSE;
+}
+
+void mecs_registry_merge(mecs_registry_t* io_dst, mecs_registry_t* io_src, mecs_entity_t* o_remap /*= NULL */)
+{
+    mecs_entity_t* remap;
+    mecs_bool_t created;
+    mecs_entity_size_t alive_count;
+    mecs_entity_size_t i;
+    mecs_entity_size_t j;
+    mecs_entity_size_t first_index;
+    mecs_component_size_t component_idx;
+    mecs_component_store_t* src_store;
+    mecs_component_store_t* dst_store;
+    mecs_component_type_t* type;
+    mecs_hierarchy_t* hierarchy;
+    mecs_index_t* index;
+    mecs_profile_begin("mecs_registry_merge");
+    mecs_assert(io_dst != NULL);
+    mecs_assert(io_src != NULL);
+    mecs_assert(io_dst != io_src);
+
+    if (io_src->entities_len == 0)
+    {
+        mecs_profile_end("mecs_registry_merge");
+        return;
+    }
+    remap = o_remap != NULL ? o_remap : mecs_malloc_arr(mecs_entity_t, io_src->entities_len);
+    if (remap == NULL)
+    {
+        mecs_assert(MECS_FALSE);
+        mecs_profile_end("mecs_registry_merge");
+        return;
+    }
+
+    /* Allocate new ids in one go, handed out in order of the ids they replace. */
+    alive_count = 0;
+    for (i = 0; i < io_src->entities_len; ++i)
+    {
+        alive_count += mecs_entity_get_id(io_src->entities[i]) == i ? 1 : 0;
+    }
+    /* Created into the front of the remap and spread out from the back, an alive id never comes before its new entity. */
+    created = alive_count != 0 && mecs_entity_create_array_copy(io_dst, alive_count, remap);
+    j = alive_count;
+    for (i = io_src->entities_len; i > 0; --i)
+    {
+        remap[i - 1] = mecs_entity_get_id(io_src->entities[i - 1]) == i - 1 && created ? remap[--j] : MECS_ENTITY_INVALID;
+    }
+
+    for (component_idx = 0; component_idx < io_src->components_len; ++component_idx)
+    {
+        src_store = &io_src->components[component_idx];
+        type = src_store->type;
+        if (type == NULL || src_store->entities_count == 0)
+        {
+            continue;
+        }
+        if (type->id >= io_dst->components_len || io_dst->components[type->id].type != type)
+        {
+            /* Component must be registered with both registries. */
+            mecs_assert(MECS_FALSE);
+            continue;
+        }
+
+        dst_store = &io_dst->components[type->id];
+        first_index = dst_store->entities_count;
+        mecs_component_store_merge(dst_store, src_store, remap);
+        mecs_component_add_sparse_elements(dst_store, first_index, dst_store->entities_count - first_index);
+
+        if (type == mecs_component_get_type_ptr(mecs_hierarchy_t))
+        {
+            /* Every linked entity moved along, so links only need to be renamed. */
+            for (i = first_index; i < dst_store->entities_count; ++i)
+            {
+                hierarchy = (mecs_hierarchy_t*)mecs_component_get_component_element(dst_store, i);
+                hierarchy->parent = hierarchy->parent != MECS_ENTITY_INVALID ? remap[mecs_entity_get_id(hierarchy->parent)] : MECS_ENTITY_INVALID;
+                hierarchy->first_child = hierarchy->first_child != MECS_ENTITY_INVALID ? remap[mecs_entity_get_id(hierarchy->first_child)] : MECS_ENTITY_INVALID;
+                hierarchy->next_sibling = hierarchy->next_sibling != MECS_ENTITY_INVALID ? remap[mecs_entity_get_id(hierarchy->next_sibling)] : MECS_ENTITY_INVALID;
+                hierarchy->prev_sibling = hierarchy->prev_sibling != MECS_ENTITY_INVALID ? remap[mecs_entity_get_id(hierarchy->prev_sibling)] : MECS_ENTITY_INVALID;
+            }
+            io_dst->hierarchy_sorted = MECS_FALSE;
+        }
+        for (index = dst_store->indexes; index != NULL; index = index->next)
+        {
+            for (i = first_index; i < dst_store->entities_count; ++i)
+            {
+                mecs_index_add_pending(index, dst_store->dense[i]);
+            }
+        }
+        for (index = src_store->indexes; index != NULL; index = index->next)
+        {
+            mecs_index_rebuild(index);
+        }
+    }
+
+    /* Destroying an entity without components only recycles its id. */
+    for (i = 0; i < io_src->entities_len; ++i)
+    {
+        if (remap[i] != MECS_ENTITY_INVALID)
+        {
+            mecs_entity_destroy(io_src, io_src->entities[i]);
+        }
+    }
+
+    if (o_remap == NULL)
+    {
+        mecs_free(remap);
+    }
+    mecs_profile_end("mecs_registry_merge");
+}
+
+void mecs_registry_merge_entities(mecs_registry_t* io_dst, mecs_registry_t* io_src, mecs_entity_t const* i_entities, mecs_entity_size_t i_count, mecs_entity_t* o_entities)
+{
+    mecs_entity_t* remap;
+    mecs_entity_size_t count;
+    mecs_entity_size_t i;
+    mecs_entity_size_t first_index;
+    mecs_entity_size_t end_index;
+    mecs_component_size_t component_idx;
+    mecs_component_store_t* src_store;
+    mecs_component_store_t* dst_store;
+    mecs_component_type_t* type;
+    mecs_hierarchy_t* hierarchy;
+    mecs_entity_t parent;
+    mecs_index_t* index;
+    mecs_profile_begin("mecs_registry_merge_entities");
+    mecs_assert(io_dst != NULL);
+    mecs_assert(io_src != NULL);
+    mecs_assert(io_dst != io_src);
+    mecs_assert(i_entities != NULL || i_count == 0);
+    mecs_assert(o_entities != NULL || i_count == 0);
+
+    if (i_count == 0)
+    {
+        mecs_profile_end("mecs_registry_merge_entities");
+        return;
+    }
+    remap = mecs_malloc_arr(mecs_entity_t, io_src->entities_len);
+    if (remap == NULL || !mecs_entity_create_array_copy(io_dst, i_count, o_entities))
+    {
+        mecs_assert(MECS_FALSE);
+        if (remap != NULL)
+        {
+            mecs_free(remap);
+        }
+        mecs_profile_end("mecs_registry_merge_entities");
+        return;
+    }
+    mecs_memset(remap, 0xFF, io_src->entities_len * sizeof(mecs_entity_t)); /* Initialise all entries to MECS_ENTITY_INVALID. */
+    for (i = 0; i < i_count; ++i)
+    {
+        mecs_assert(!mecs_entity_is_destroyed(io_src, i_entities[i]));
+        remap[mecs_entity_get_id(i_entities[i])] = o_entities[i];
+    }
+
+    for (component_idx = 0; component_idx < io_src->components_len; ++component_idx)
+    {
+        src_store = &io_src->components[component_idx];
+        type = src_store->type;
+        if (type == NULL)
+        {
+            continue;
+        }
+
+        count = 0;
+        for (i = 0; i < i_count; ++i)
+        {
+            count += mecs_component_has_sparse_element(src_store, i_entities[i]) ? 1 : 0;
+        }
+        if (count == 0)
+        {
+            continue;
+        }
+        if (type->id >= io_dst->components_len || io_dst->components[type->id].type != type)
+        {
+            /* Component must be registered with both registries, entity_destroy removes it from io_src below. */
+            mecs_assert(MECS_FALSE);
+            continue;
+        }
+
+        /* Grow the destination once, then move each component and drop it from the source without destructing it. */
+        dst_store = &io_dst->components[type->id];
+        first_index = dst_store->entities_count;
+        mecs_component_add_dense_elements(dst_store, count);
+        end_index = first_index;
+        for (i = 0; i < i_count; ++i)
+        {
+            if (mecs_component_has_sparse_element(src_store, i_entities[i]))
+            {
+                mecs_component_relocate(type, mecs_component_get_component_element(dst_store, end_index), mecs_component_get_impl(io_src, i_entities[i], type));
+                dst_store->dense[end_index] = o_entities[i];
+                end_index += 1;
+            }
+        }
+        mecs_component_add_sparse_elements(dst_store, first_index, count);
+        for (i = 0; i < i_count; ++i)
+        {
+            if (mecs_component_has_sparse_element(src_store, i_entities[i]))
+            {
+                mecs_component_remove_element(io_src, i_entities[i], type, MECS_TRUE);
             }
+        }
 
-            /* If we were unable to allocate enough capacity, abort. */
-            if (new_capacity - io_registry->entities_cap < i_count)
+        if (type == mecs_component_get_type_ptr(mecs_hierarchy_t))
+        {
+            /* Link each entity to its parent again if that moved along, children are relinked through set_parent. */
+            for (i = first_index; i < end_index; ++i)
             {
-                mecs_assert(MECS_FALSE);
-                return NULL;
+                hierarchy = (mecs_hierarchy_t*)mecs_component_get_component_element(dst_store, i);
+                parent = hierarchy->parent != MECS_ENTITY_INVALID ? remap[mecs_entity_get_id(hierarchy->parent)] : MECS_ENTITY_INVALID;
+                mecs_memset(hierarchy, 0xFF, sizeof(mecs_hierarchy_t));
+                hierarchy->parent = parent;
             }
-
-            entities_grown = mecs_realloc_arr(mecs_entity_t, io_registry->entities, new_capacity);
-            if (entities_grown == NULL)
+            for (i = first_index; i < end_index; ++i)
             {
-                mecs_assert(MECS_FALSE);
-                return NULL;
+                hierarchy = (mecs_hierarchy_t*)mecs_component_get_component_element(dst_store, i);
+                parent = hierarchy->parent;
+                if (parent != MECS_ENTITY_INVALID)
+                {
+                    hierarchy->parent = MECS_ENTITY_INVALID;
+                    mecs_hierarchy_set_parent(io_dst, dst_store->dense[i], parent);
+                }
             }
-
-            mecs_memset(entities_grown + io_registry->entities_cap, 0x00, sizeof(mecs_entity_t));
-            io_registry->entities = entities_grown;
-            io_registry->entities_cap = new_capacity;
+            io_dst->hierarchy_sorted = MECS_FALSE;
         }
-
-        entities_grown_offset = io_registry->entities_len;
-        for (i = 0; i < i_count; ++i)
+        for (index = dst_store->indexes; index != NULL; index = index->next)
         {
-            entity = (mecs_entity_t)io_registry->entities_len;
-            io_registry->entities[(mecs_entity_id_t)entity] = entity; /* Genaration is 0 so can use as index directly. */
-            io_registry->entities_len += 1;
+            for (i = first_index; i < end_index; ++i)
+            {
+                mecs_index_add_pending(index, dst_store->dense[i]);
+            }
         }
+    }
 
-        return &io_registry->entities[entities_grown_offset];
+    for (i = 0; i < i_count; ++i)
+    {
+        mecs_entity_destroy(io_src, i_entities[i]);
     }
+    mecs_free(remap);
+    mecs_profile_end("mecs_registry_merge_entities");
 }
 
-mecs_entity_t mecs_entity_create(mecs_registry_t* io_registry)
+void mecs_entity_clone(mecs_registry_t* io_registry, mecs_entity_t i_entity, mecs_entity_size_t i_count, mecs_entity_t* o_entities)
 {
-    mecs_entity_t* entity;
-    entity = mecs_entity_create_array(io_registry, 1);
-    if (entity == NULL)
-    {
-        mecs_assert(MECS_FALSE);
-        return MECS_ENTITY_INVALID;
-    }
-    return *entity;
+    mecs_entity_instantiate(io_registry, io_registry, i_entity, i_count, o_entities);
 }
 
-mecs_bool_t mecs_entity_destroy(mecs_registry_t* io_registry, mecs_entity_t i_entity)
+void mecs_entity_instantiate(mecs_registry_t* io_registry, mecs_registry_t* i_prefab_registry, mecs_entity_t i_prefab, mecs_entity_size_t i_count, mecs_entity_t* o_entities)
 {
     mecs_component_size_t i;
-    mecs_entity_id_t destroyed_id;
-    mecs_entity_gen_t destroyed_gen;
-    mecs_entity_id_t next_free_entity_id;
+    mecs_component_store_t* prefab_store;
+    mecs_component_store_t* component_store;
+    mecs_component_type_t* type;
+    mecs_entity_size_t first_index;
+    mecs_entity_size_t j;
+    void* prefab_component;
+    void* component;
+    mecs_index_t* index;
+    mecs_profile_begin("mecs_entity_instantiate");
     mecs_assert(io_registry != NULL);
+    mecs_assert(i_prefab_registry != NULL);
+    mecs_assert(o_entities != NULL || i_count == 0);
+    mecs_assert(!mecs_entity_is_destroyed(i_prefab_registry, i_prefab));
 
-    if (mecs_entity_is_destroyed(io_registry, i_entity)) 
+    if (i_count == 0)
+    {
+        mecs_profile_end("mecs_entity_instantiate");
+        return;
+    }
+
+    if (!mecs_entity_create_array_copy(io_registry, i_count, o_entities))
     {
         mecs_assert(MECS_FALSE);
-        return MECS_FALSE;
+        mecs_profile_end("mecs_entity_instantiate");
+        return;
     }
 
-    /* Remove all components. */
-    for (i = 0; i < io_registry->components_len; ++i)
+    for (i = 0; i < i_prefab_registry->components_len; ++i)
     {
-        if (io_registry->components[i].type != NULL && mecs_component_has_impl(io_registry, i_entity, io_registry->components[i].type))
+        prefab_store = &i_prefab_registry->components[i];
+        type = prefab_store->type;
+        if (type == NULL || !mecs_component_has_by_id(i_prefab_registry, i_prefab, type->id))
         {
-            mecs_component_remove_impl(io_registry, i_entity, io_registry->components[i].type);
+            continue;
+        }
+        if (type->id >= io_registry->components_len || io_registry->components[type->id].type != type)
+        {
+            /* Component must be registered with both registries. */
+            mecs_assert(MECS_FALSE);
+            continue;
         }
-    }
-
-    destroyed_id = mecs_entity_get_id(i_entity);
-    destroyed_gen = mecs_entity_get_generation(i_entity);
-    next_free_entity_id = mecs_entity_get_id(io_registry->next_free_entity);
 
-    /* Increase generation so any entities still using this id become invalid as the generation won't match. */
-    destroyed_gen += 1;
+        /* Lock a prefab store of another registry as well, both in address order so instantiating back and forth between two registries can't deadlock. */
+        component_store = &io_registry->components[type->id];
+        if (prefab_store != component_store && prefab_store < component_store)
+        {
+            mecs_lock_read(&prefab_store->lock);
+        }
+        mecs_lock_write(&component_store->lock);
+        if (prefab_store != component_store && prefab_store > component_store)
+        {
+            mecs_lock_read(&prefab_store->lock);
+        }
+        if (!mecs_component_has_sparse_element(prefab_store, i_prefab))
+        {
+            /* Removed by another thread in the meantime. */
+            mecs_unlock_write(&component_store->lock);
+            if (prefab_store != component_store)
+            {
+                mecs_unlock_read(&prefab_store->lock);
+            }
+            continue;
+        }
 
-    /* Have the entity we're destroying point to the next free entity and update the head of our list to point to the entity we're destroying. */
-    io_registry->entities[destroyed_id] = mecs_entity_compose(destroyed_gen, next_free_entity_id);
-    io_registry->next_free_entity = destroyed_id;
-    return MECS_TRUE;
-}
+        /* Grow the store once for all copies and map them in bulk. */
+        prefab_component = mecs_component_store_get(prefab_store, i_prefab);
+        first_index = component_store->entities_count;
+        mecs_component_add_dense_elements(component_store, i_count);
+        memcpy(component_store->dense + first_index, o_entities, i_count * sizeof(mecs_dense_t));
+        mecs_component_add_sparse_elements(component_store, first_index, i_count);
 
-mecs_bool_t mecs_entity_is_destroyed(mecs_registry_t* io_registry, mecs_entity_t i_entity)
-{
-    mecs_entity_id_t entity_id;
-    mecs_entity_gen_t entity_gen;
-    mecs_entity_gen_t current_gen;
-    mecs_assert(io_registry != NULL);
+        for (j = 0; j < i_count; ++j)
+        {
+            component = mecs_component_get_component_element(component_store, first_index + j);
+            if (type == mecs_component_get_type_ptr(mecs_hierarchy_t))
+            {
+                mecs_memset(component, 0xFF, sizeof(mecs_hierarchy_t)); /* Copies start out as roots without children. */
+                io_registry->hierarchy_sorted = MECS_FALSE;
+            }
+            else if (type->copy_func != NULL)
+            {
+                type->copy_func(component, prefab_component);
+            }
+            else
+            {
+                memcpy(component, prefab_component, type->size);
+            }
+        }
 
-    entity_id = mecs_entity_get_id(i_entity);
-    mecs_assert(entity_id < io_registry->entities_len);
+        for (index = component_store->indexes; index != NULL; index = index->next)
+        {
+            for (j = 0; j < i_count; ++j)
+            {
+                mecs_index_add_pending(index, o_entities[j]);
+            }
+        }
 
-    entity_gen = mecs_entity_get_generation(i_entity);
-    current_gen = mecs_entity_get_generation(io_registry->entities[entity_id]);
-    if (entity_gen != current_gen)
-    {
-        return MECS_TRUE;
+        mecs_unlock_write(&component_store->lock);
+        if (prefab_store != component_store)
+        {
+            mecs_unlock_read(&prefab_store->lock);
+        }
     }
-    return MECS_FALSE;
+    mecs_profile_end("mecs_entity_instantiate");
 }
 
 mecs_query_it_t mecs_query_create(void)
@@ -1391,35 +4759,97 @@ mecs_query_it_t mecs_query_create(void)
     query.current = NULL;
     query.end = NULL;
     query.component_stores = NULL;
+    query.sparse_elements = NULL;
+    query.args = NULL;
     query.args_len = 0;
+    query.base_arg = 0;
+    query.any_of_groups = 0;
+    query.sparse_elements_heap = NULL;
+    query.args_heap = NULL;
+    query.args_heap_cap = 0;
+    #if defined(MECS_THREAD_SAFE)
+        query.locked = MECS_FALSE;
+    #endif
     return query;
 }
 
-void mecs_query_with_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type)
+void mecs_query_destroy(mecs_query_it_t* io_query_it)
 {
     mecs_assert(io_query_it != NULL);
-    mecs_assert(io_query_it->args_len != MECS_QUERY_MAX_LEN);
-    io_query_it->args[io_query_it->args_len].type = MECS_QUERY_TYPE_WITH;
-    io_query_it->args[io_query_it->args_len].component_type = i_type;
-    io_query_it->args_len += 1;
+
+    #if defined(MECS_THREAD_SAFE)
+        mecs_query_end(io_query_it);
+    #endif
+    if (io_query_it->args_heap != NULL)
+    {
+        mecs_free(io_query_it->args_heap);
+        mecs_free(io_query_it->sparse_elements_heap);
+    }
+    *io_query_it = mecs_query_create();
 }
 
-void mecs_query_without_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type)
+void mecs_query_add_arg(mecs_query_it_t* io_query_it, mecs_query_type_t i_type, mecs_component_type_t* i_component_type, mecs_uint32_t i_group)
 {
+    mecs_query_arg_t* args;
+    mecs_query_arg_t* args_grown;
+    mecs_sparse_t* sparse_elements_grown;
+    mecs_size_t capacity;
+    mecs_size_t new_capacity;
     mecs_assert(io_query_it != NULL);
-    mecs_assert(io_query_it->args_len != MECS_QUERY_MAX_LEN);
-    io_query_it->args[io_query_it->args_len].type = MECS_QUERY_TYPE_WITHOUT;
-    io_query_it->args[io_query_it->args_len].component_type = i_type;
+    mecs_assert(i_component_type != NULL);
+    mecs_assert(i_group < MECS_QUERY_MAX_GROUPS);
+
+    capacity = io_query_it->args_heap != NULL ? io_query_it->args_heap_cap : MECS_QUERY_LOCAL_LEN;
+    if (io_query_it->args_len == capacity)
+    {
+        /* Move all arguments to the heap once they no longer fit inline, doubling the capacity from there on. */
+        new_capacity = capacity * 2;
+        args_grown = mecs_realloc_arr(mecs_query_arg_t, io_query_it->args_heap, new_capacity);
+        if (args_grown == NULL)
+        {
+            mecs_assert(MECS_FALSE);
+            return;
+        }
+        io_query_it->args_heap = args_grown;
+        sparse_elements_grown = mecs_realloc_arr(mecs_sparse_t, io_query_it->sparse_elements_heap, new_capacity);
+        if (sparse_elements_grown == NULL)
+        {
+            mecs_assert(MECS_FALSE);
+            return;
+        }
+        io_query_it->sparse_elements_heap = sparse_elements_grown;
+        if (io_query_it->args_heap_cap == 0)
+        {
+            memcpy(io_query_it->args_heap, io_query_it->args_local, MECS_QUERY_LOCAL_LEN * sizeof(mecs_query_arg_t));
+        }
+        io_query_it->args_heap_cap = new_capacity;
+    }
+
+    args = io_query_it->args_heap != NULL ? io_query_it->args_heap : io_query_it->args_local;
+    args[io_query_it->args_len].type = i_type;
+    args[io_query_it->args_len].group = (mecs_uint8_t)i_group;
+    args[io_query_it->args_len].component_type = i_component_type;
     io_query_it->args_len += 1;
 }
 
+void mecs_query_with_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type)
+{
+    mecs_query_add_arg(io_query_it, MECS_QUERY_TYPE_WITH, i_type, 0);
+}
+
+void mecs_query_without_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type)
+{
+    mecs_query_add_arg(io_query_it, MECS_QUERY_TYPE_WITHOUT, i_type, 0);
+}
+
 void mecs_query_optional_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type)
 {
-    mecs_assert(io_query_it != NULL);
-    mecs_assert(io_query_it->args_len != MECS_QUERY_MAX_LEN);
-    io_query_it->args[io_query_it->args_len].type = MECS_QUERY_TYPE_OPTIONAL;
-    io_query_it->args[io_query_it->args_len].component_type = i_type;
-    io_query_it->args_len += 1;
+    mecs_query_add_arg(io_query_it, MECS_QUERY_TYPE_OPTIONAL, i_type, 0);
+}
+
+void mecs_query_any_of_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type, mecs_uint32_t i_group)
+{
+    mecs_query_add_arg(io_query_it, MECS_QUERY_TYPE_ANY_OF, i_type, i_group);
 }
 
 void mecs_query_begin(mecs_registry_t* io_registry, mecs_query_it_t* io_query_it)
@@ -1427,16 +4857,37 @@ void mecs_query_begin(mecs_registry_t* io_registry, mecs_query_it_t* io_query_it
     mecs_size_t arg_idx;
     mecs_query_type_t type;
     mecs_component_id_t component_id;
-    mecs_entity_size_t entities_count;
+    mecs_size_t entities_count;
+    mecs_size_t group_entities_count[MECS_QUERY_MAX_GROUPS]; /* Sums several stores, so wider than a single store count. */
+    mecs_size_t group_first_arg[MECS_QUERY_MAX_GROUPS];
+    mecs_uint32_t group;
 
-    mecs_entity_size_t smallest_entities_count;
+    mecs_size_t smallest_entities_count;
     mecs_component_store_t* smallest_component_store;
+    mecs_profile_begin("mecs_query_begin");
     mecs_assert(io_registry != NULL);
     mecs_assert(io_query_it != NULL);
 
+    #if defined(MECS_THREAD_SAFE)
+        mecs_query_end(io_query_it); /* Release the locks of a previous iteration left early. */
+    #endif
+    io_query_it->args = io_query_it->args_heap != NULL ? io_query_it->args_heap : io_query_it->args_local;
+    io_query_it->sparse_elements = io_query_it->args_heap != NULL ? io_query_it->sparse_elements_heap : io_query_it->sparse_elements_local;
+    io_query_it->component_stores = io_registry->components;
+
+    #if defined(MECS_THREAD_SAFE)
+        /* Hold read locks on every argument until the iteration ends, as the base dense array is walked in place. */
+        for (arg_idx = 0; arg_idx < io_query_it->args_len; ++arg_idx)
+        {
+            mecs_lock_read(&io_registry->components[io_query_it->args[arg_idx].component_type->id].lock);
+        }
+        io_query_it->locked = MECS_TRUE;
+    #endif
+
     /* Find the component store with the smallest number of entities to become the iterator base. */
-    smallest_entities_count = (mecs_entity_size_t)-1;
+    smallest_entities_count = (mecs_size_t)-1;
     smallest_component_store = NULL;
+    io_query_it->any_of_groups = 0;
     for (arg_idx = 0; arg_idx < io_query_it->args_len; ++arg_idx)
     {
         /* Only with query arguments can form the base for the iterator as they are the only type that narrows down the set entities we have it iterate to a single array. */
@@ -1449,47 +4900,269 @@ void mecs_query_begin(mecs_registry_t* io_registry, mecs_query_it_t* io_query_it
             {
                 smallest_entities_count = entities_count;
                 smallest_component_store = &io_registry->components[component_id];
+                io_query_it->base_arg = arg_idx;
+            }
+        }
+        else if (type == MECS_QUERY_TYPE_ANY_OF)
+        {
+            /* Sum up the entities of each any of group, the union of their dense arrays is at most this large. */
+            group = io_query_it->args[arg_idx].group;
+            if ((io_query_it->any_of_groups & ((mecs_uint32_t)1 << group)) == 0)
+            {
+                io_query_it->any_of_groups |= (mecs_uint32_t)1 << group;
+                group_entities_count[group] = 0;
+                group_first_arg[group] = arg_idx;
             }
+            group_entities_count[group] += io_registry->components[component_id].entities_count;
+        }
+    }
+
+    for (group = 0; group < MECS_QUERY_MAX_GROUPS; ++group)
+    {
+        if ((io_query_it->any_of_groups & ((mecs_uint32_t)1 << group)) != 0 && group_entities_count[group] < smallest_entities_count)
+        {
+            smallest_entities_count = group_entities_count[group];
+            smallest_component_store = &io_registry->components[io_query_it->args[group_first_arg[group]].component_type->id];
+            io_query_it->base_arg = group_first_arg[group];
         }
     }
 
     if (smallest_component_store == NULL)
     {
         /* This query matches all entities. We need at least 1 query arg to form the base of iteration. */
+        #if defined(MECS_THREAD_SAFE)
+            mecs_query_end(io_query_it);
+        #endif
         mecs_assert(MECS_FALSE);
+        mecs_profile_end("mecs_query_begin");
         return;
     }
 
     io_query_it->current = smallest_component_store->dense;
     io_query_it->end = smallest_component_store->dense + smallest_component_store->entities_count;
-    io_query_it->component_stores = io_registry->components;
+    io_query_it->batch_end = io_query_it->current;
+    io_query_it->batch_mask = 0;
+    #if defined(MECS_QUERY_STATS)
+        io_query_it->entities_scanned = 0;
+        io_query_it->entities_matched = 0;
+        io_query_it->sparse_probes = 0;
+    #endif
+    mecs_profile_end("mecs_query_begin");
+}
+
+mecs_bool_t mecs_query_next_base(mecs_query_it_t* io_query_it)
+{
+    /* Move on to the dense array of the next argument in the any of group forming the base. */
+    mecs_query_arg_t* base;
+    mecs_component_store_t* component_store;
+    mecs_size_t arg_idx;
+
+    base = &io_query_it->args[io_query_it->base_arg];
+    if (base->type != MECS_QUERY_TYPE_ANY_OF)
+    {
+        return MECS_FALSE;
+    }
+    for (arg_idx = io_query_it->base_arg + 1; arg_idx < io_query_it->args_len; ++arg_idx)
+    {
+        if (io_query_it->args[arg_idx].type == MECS_QUERY_TYPE_ANY_OF && io_query_it->args[arg_idx].group == base->group)
+        {
+            component_store = &io_query_it->component_stores[io_query_it->args[arg_idx].component_type->id];
+            io_query_it->base_arg = arg_idx;
+            io_query_it->current = component_store->dense;
+            io_query_it->end = component_store->dense + component_store->entities_count;
+            return MECS_TRUE;
+        }
+    }
+    return MECS_FALSE;
+}
+
+mecs_uint32_t mecs_query_match_batch(mecs_query_it_t* io_query_it, mecs_dense_t const* i_candidates, mecs_size_t i_count)
+{
+    /* Test the with and without arguments for all candidates, one argument at a time. The lanes don't branch on the 
+       sparse set so compilers can vectorise them, returns a bit for each candidate matching all of them. */
+    mecs_entity_size_t ids[MECS_QUERY_BATCH];
+    mecs_entity_gen_t generations[MECS_QUERY_BATCH];
+    mecs_uint32_t mask;
+    mecs_uint32_t has_component;
+    mecs_size_t lane;
+    mecs_size_t arg_idx;
+    mecs_query_type_t type;
+    mecs_component_store_t const* component_store;
+    mecs_sparse_block_t* const* sparse;
+    mecs_sparse_block_t const* sparse_block;
+    mecs_entity_size_t sparse_len;
+    mecs_entity_size_t page_index;
+    mecs_sparse_t sparse_elem;
+    mecs_assert(i_count > 0 && i_count <= MECS_QUERY_BATCH);
+
+    mask = 0;
+    for (lane = 0; lane < i_count; ++lane)
+    {
+        ids[lane] = mecs_entity_get_id(i_candidates[lane]);
+        generations[lane] = mecs_entity_get_generation(i_candidates[lane]);
+        mask |= (mecs_uint32_t)(ids[lane] != MECS_ENTITY_ID_INVALID) << lane; /* Tombstones of removed stable components never match. */
+    }
+
+    for (arg_idx = 0; arg_idx < io_query_it->args_len && mask != 0; ++arg_idx)
+    {
+        type = io_query_it->args[arg_idx].type;
+        if (type != MECS_QUERY_TYPE_WITH && type != MECS_QUERY_TYPE_WITHOUT)
+        {
+            continue;
+        }
+        component_store = &io_query_it->component_stores[io_query_it->args[arg_idx].component_type->id];
+        sparse = component_store->sparse;
+        sparse_len = component_store->sparse_len;
+        has_component = 0;
+        for (lane = 0; lane < i_count; ++lane)
+        {
+            page_index = ids[lane] / MECS_PAGE_LEN_SPARSE;
+            sparse_block = page_index < sparse_len ? sparse[page_index] : NULL;
+            sparse_elem = sparse_block != NULL ? sparse_block->block[ids[lane] % MECS_PAGE_LEN_SPARSE] : MECS_SPARSE_INVALID;
+            has_component |= (mecs_uint32_t)(mecs_entity_get_generation(sparse_elem) == generations[lane]) << lane;
+        }
+        mask &= type == MECS_QUERY_TYPE_WITH ? has_component : ~has_component;
+        #if defined(MECS_QUERY_STATS)
+            io_query_it->sparse_probes += i_count;
+        #endif
+    }
+    return mask;
+}
+
+mecs_bool_t mecs_query_next_batch(mecs_query_it_t* io_query_it)
+{
+    /* Return the next match of a query without any of arguments, matching the candidates a batch at a time. */
+    mecs_size_t arg_idx;
+    mecs_size_t count;
+    mecs_query_type_t type;
+    mecs_component_store_t* component_store;
+    mecs_bool_t has_component;
+    mecs_entity_t entity;
+
+    for (;;)
+    {
+        while (io_query_it->batch_mask != 0)
+        {
+            while ((io_query_it->batch_mask & 1) == 0)
+            {
+                io_query_it->batch_mask >>= 1;
+                io_query_it->current += 1;
+            }
+            io_query_it->batch_mask >>= 1;
+            entity = *io_query_it->current;
+            io_query_it->current += 1; /* Points past the entity, as mecs_query_entity_get expects. */
+            if (mecs_entity_get_id(entity) == MECS_ENTITY_ID_INVALID)
+            {
+                continue; /* Its stable component was removed after the batch was matched. */
+            }
+
+            /* Only matches read their dense indices. The loop body may have changed components since the batch was
+               matched, so check the arguments again while reading them. */
+            for (arg_idx = 0; arg_idx < io_query_it->args_len; ++arg_idx)
+            {
+                type = io_query_it->args[arg_idx].type;
+                component_store = &io_query_it->component_stores[io_query_it->args[arg_idx].component_type->id];
+                has_component = mecs_component_has_sparse_element(component_store, entity);
+                if (has_component)
+                {
+                    io_query_it->sparse_elements[arg_idx] = *mecs_component_get_sparse_element(component_store, entity);
+                }
+                else
+                {
+                    io_query_it->sparse_elements[arg_idx] = MECS_SPARSE_INVALID;
+                }
+                #if defined(MECS_QUERY_STATS)
+                    io_query_it->sparse_probes += type == MECS_QUERY_TYPE_OPTIONAL ? 1 : 0;
+                #endif
+                if ((type == MECS_QUERY_TYPE_WITH && !has_component) || (type == MECS_QUERY_TYPE_WITHOUT && has_component))
+                {
+                    goto l_next_lane;
+                }
+            }
+            #if defined(MECS_QUERY_STATS)
+                io_query_it->entities_matched += 1;
+            #endif
+            return MECS_TRUE;
+
+            l_next_lane:;
+        }
+
+        io_query_it->current = io_query_it->batch_end;
+        if (io_query_it->current >= io_query_it->end)
+        {
+            return MECS_FALSE;
+        }
+        count = (mecs_size_t)(io_query_it->end - io_query_it->current);
+        count = count < MECS_QUERY_BATCH ? count : MECS_QUERY_BATCH;
+        io_query_it->batch_end = io_query_it->current + count;
+        io_query_it->batch_mask = mecs_query_match_batch(io_query_it, io_query_it->current, count);
+        #if defined(MECS_QUERY_STATS)
+            io_query_it->entities_scanned += count;
+        #endif
+    }
 }
 
 mecs_bool_t mecs_query_next(mecs_query_it_t* io_query_it)
 {
     mecs_size_t arg_idx;
     mecs_query_type_t type;
-    mecs_component_id_t component_id;
     mecs_component_store_t* component_store;
     mecs_bool_t has_component;
+    mecs_uint32_t any_of_groups;
+    mecs_entity_t entity;
+
+    /* Keep the iterator state in locals, writes to the sparse elements may otherwise alias it. */
+    mecs_query_arg_t* args;
+    mecs_sparse_t* sparse_elements;
+    mecs_size_t args_len;
+    mecs_component_store_t* component_stores;
+    mecs_query_arg_t* base;
+    mecs_profile_begin("mecs_query_next");
 
-    while(io_query_it->current < io_query_it->end)
+    if (io_query_it->any_of_groups == 0 && mecs_query_next_batch(io_query_it))
     {
-        for (arg_idx = 0; arg_idx < io_query_it->args_len; ++arg_idx)
+        mecs_profile_end("mecs_query_next");
+        return MECS_TRUE;
+    }
+
+    /* Without any of arguments the batches consumed all candidates, so the loop below only finishes the query. */
+    args = io_query_it->args;
+    sparse_elements = io_query_it->sparse_elements;
+    args_len = io_query_it->args_len;
+    component_stores = io_query_it->component_stores;
+    while(io_query_it->current < io_query_it->end || mecs_query_next_base(io_query_it))
+    {
+        if (io_query_it->current == io_query_it->end)
+        {
+            continue; /* The next dense array of an any of group is empty. */
+        }
+        #if defined(MECS_QUERY_STATS)
+            io_query_it->entities_scanned += 1;
+        #endif
+        entity = *io_query_it->current;
+        io_query_it->current += 1;
+        if (mecs_entity_get_id(entity) == MECS_ENTITY_ID_INVALID)
+        {
+            continue; /* Tombstone of a removed stable component. */
+        }
+        any_of_groups = 0;
+        for (arg_idx = 0; arg_idx < args_len; ++arg_idx)
         {
             /* Check if the entity matches the query argument. */
-            type = io_query_it->args[arg_idx].type;
-            component_id = io_query_it->args[arg_idx].component_type->id;
-            component_store = &io_query_it->component_stores[component_id];
-            has_component = mecs_component_has_sparse_element(component_store, *io_query_it->current);
+            type = args[arg_idx].type;
+            component_store = &component_stores[args[arg_idx].component_type->id];
+            has_component = mecs_component_has_sparse_element(component_store, entity);
+            #if defined(MECS_QUERY_STATS)
+                io_query_it->sparse_probes += 1;
+            #endif
 
             if (has_component)
             {
-                io_query_it->sparse_elements[arg_idx] = *mecs_component_get_sparse_element(component_store, *io_query_it->current);
+                sparse_elements[arg_idx] = *mecs_component_get_sparse_element(component_store, entity);
             }
             else
             {
-                io_query_it->sparse_elements[arg_idx] = MECS_SPARSE_INVALID;
+                sparse_elements[arg_idx] = MECS_SPARSE_INVALID;
             }
 
             if((type == MECS_QUERY_TYPE_WITH && has_component) ||
@@ -1499,33 +5172,80 @@ mecs_bool_t mecs_query_next(mecs_query_it_t* io_query_it)
             {
                 continue;
             }
+            if (type == MECS_QUERY_TYPE_ANY_OF)
+            {
+                any_of_groups |= has_component ? (mecs_uint32_t)1 << args[arg_idx].group : 0;
+                continue;
+            }
             goto l_next_entity; /* Query arg does not match the current entity. Move on to the next entity. */ 
         }
 
-        io_query_it->current += 1;           
+        if (io_query_it->any_of_groups != 0)
+        {
+            if (any_of_groups != io_query_it->any_of_groups)
+            {
+                goto l_next_entity;
+            }
+
+            /* Entities of an any of group base were visited already if they have a component of the group iterated earlier. */
+            base = &args[io_query_it->base_arg];
+            if (base->type == MECS_QUERY_TYPE_ANY_OF)
+            {
+                for (arg_idx = 0; arg_idx < io_query_it->base_arg; ++arg_idx)
+                {
+                    if (args[arg_idx].type == MECS_QUERY_TYPE_ANY_OF && args[arg_idx].group == base->group && sparse_elements[arg_idx] != MECS_SPARSE_INVALID)
+                    {
+                        goto l_next_entity;
+                    }
+                }
+            }
+        }
+
+        #if defined(MECS_QUERY_STATS)
+            io_query_it->entities_matched += 1;
+        #endif
+        mecs_profile_end("mecs_query_next");
         return MECS_TRUE; /* All query args match the current entity. Return this entity to the caller. */
 
         l_next_entity:;
-        io_query_it->current += 1;           
     }
+    #if defined(MECS_THREAD_SAFE)
+        mecs_query_end(io_query_it);
+    #endif
+    mecs_profile_end("mecs_query_next");
     return MECS_FALSE;
 }
 
-mecs_entity_t mecs_query_entity_get(mecs_query_it_t* io_query_it)
+void mecs_query_end(mecs_query_it_t* io_query_it)
 {
-    return *(io_query_it->current - 1);
-}
+    #if defined(MECS_THREAD_SAFE)
+        mecs_size_t arg_idx;
+        mecs_assert(io_query_it != NULL);
 
-mecs_bool_t mecs_query_component_has_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type, mecs_size_t i_index)
-{
-    mecs_assert(io_query_it->args[i_index].component_type->id == i_type->id);
-    return io_query_it->sparse_elements[i_index] != MECS_SPARSE_INVALID;
+        if (!io_query_it->locked)
+        {
+            return;
+        }
+        for (arg_idx = 0; arg_idx < io_query_it->args_len; ++arg_idx)
+        {
+            mecs_unlock_read(&io_query_it->component_stores[io_query_it->args[arg_idx].component_type->id].lock);
+        }
+        io_query_it->locked = MECS_FALSE;
+    #else
+        (void)io_query_it;
+    #endif
 }
 
-void* mecs_query_component_get_impl(mecs_query_it_t* io_query_it, mecs_component_type_t* i_type, mecs_size_t i_index)
+void mecs_parallel_for_sequential(void* io_user_data, mecs_job_func_t i_job_func, void* io_job_data, mecs_size_t i_job_count)
 {
-    mecs_assert(io_query_it->args[i_index].component_type->id == i_type->id);
-    return mecs_component_get_component_element(&io_query_it->component_stores[i_type->id], mecs_entity_get_id(io_query_it->sparse_elements[i_index]));
+    mecs_size_t i;
+    mecs_assert(i_job_func != NULL);
+    (void)io_user_data;
+
+    for (i = 0; i < i_job_count; ++i)
+    {
+        i_job_func(io_job_data, i);
+    }
 }
 
 #endif /* MECS_IMPLEMENTATION */
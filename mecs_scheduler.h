@@ -0,0 +1,535 @@
+
+/*
+MECS - v1 - Menno Markus 2023 - public domain
+Scheduler addon for mecs entity component system compatible with C89/C++98 and higher.
+
+Usage:
+Include this file after including mecs.h to use it.
+Ensure to also add the following define in *one* C or C++ file to define the implementation.
+#define MECS_IMPLEMENTATION
+#include "mecs.h"
+#include "mecs_scheduler.h"
+
+--------------------------------------------------
+Documentation
+--------------------------------------------------
+Table:
+    1.) Functions
+    2.) Compile time options
+
+1.) FUNCTIONS
+
+    scheduler_create
+    scheduler_destroy
+        void scheduler_create(scheduler_t* o_scheduler, mecs_parallel_for_func_t i_parallel_for, void* io_user_data)
+        void scheduler_destroy(scheduler_t* io_scheduler)
+
+        Systems which can run at the same time are handed to the parallel for hook as one batch of jobs, which is
+        where a thread pool plugs in. Passing NULL as parallel for runs all systems on the calling thread.
+
+    scheduler_set_clock
+        void scheduler_set_clock(scheduler_t* io_scheduler, mecs_clock_func_t i_clock, void* io_user_data)
+        double mecs_clock_func_t(void* io_user_data)
+
+        Sets the clock used to time systems and frames, it must be safe to call from any thread running jobs. The
+        unit of the clock is used for all times reported by the scheduler. Without a clock no times are measured.
+
+    scheduler_add_system
+        system_id_t scheduler_add_system(scheduler_t* io_scheduler, char const* i_name, mecs_system_func_t i_func, void* io_user_data)
+        void mecs_system_func_t(registry_t* io_registry, void* io_user_data)
+
+    system_reads
+    system_writes
+        void system_reads(scheduler_t* io_scheduler, system_id_t i_system, T)
+        void system_writes(scheduler_t* io_scheduler, system_id_t i_system, T)
+
+        Declares the components a system accesses, by the same types used for queries. A system conflicts with an
+        earlier added system if one of them writes a component the other reads or writes, in which case it runs
+        after the earlier system finished. Systems without conflicts run concurrently. Looking up an index or
+        iterating the hierarchy may update it, so count those as writing their component.
+
+    system_set_structural
+        void system_set_structural(scheduler_t* io_scheduler, system_id_t i_system)
+
+        Marks a system which creates or destroys entities, or adds or removes components. Structural systems are
+        sync points, they run alone after all earlier systems finished and before any later system starts.
+
+    scheduler_build
+        void scheduler_build(scheduler_t* io_scheduler)
+
+        Builds the dependency graph from the declared accesses and sorts the systems into waves, where each wave
+        only depends on earlier waves. Called by scheduler_run after systems were added or changed.
+
+    scheduler_run
+        void scheduler_run(scheduler_t* io_scheduler, registry_t* io_registry)
+
+        Runs all systems once, wave after wave. Each wave is one batch for the parallel for hook, so a system also
+        waits for systems of the previous wave it doesn't depend on.
+
+    scheduler_get_stats
+        void scheduler_get_stats(scheduler_t const* i_scheduler, scheduler_stats_t* o_stats)
+
+        Times of the last run. The critical path time is the sum of the slowest system of each wave by their
+        measured times, the shortest a frame can take with unlimited threads. The systems time is the sum of all
+        systems.
+
+2.) COMPILE TIME OPTIONS
+
+    #define MECS_NO_SHORT_NAMES
+        Must be defined globally.
+
+        Short names remove the mecs_ prefix on common public api
+        types/functions. Allows to disable this behaviour. Default undefined.
+
+*/
+#ifndef MECS_SCHEDULER_H
+#define MECS_SCHEDULER_H
+
+#if !defined(MECS_NO_SHORT_NAMES)
+#define scheduler_t                             mecs_scheduler_t
+#define scheduler_stats_t                       mecs_scheduler_stats_t
+#define system_id_t                             mecs_system_id_t
+#define scheduler_create                        mecs_scheduler_create
+#define scheduler_destroy                       mecs_scheduler_destroy
+#define scheduler_set_clock                     mecs_scheduler_set_clock
+#define scheduler_add_system                    mecs_scheduler_add_system
+#define system_reads                            mecs_system_reads
+#define system_writes                           mecs_system_writes
+#define system_set_structural                   mecs_system_set_structural
+#define scheduler_build                         mecs_scheduler_build
+#define scheduler_run                           mecs_scheduler_run
+#define scheduler_get_stats                     mecs_scheduler_get_stats
+#endif /* !defined(MECS_NO_SHORT_NAMES) */
+
+typedef mecs_size_t mecs_system_id_t;
+typedef void(*mecs_system_func_t)(mecs_registry_t* io_registry, void* io_user_data);
+typedef double(*mecs_clock_func_t)(void* io_user_data);
+
+typedef struct mecs_system_access_t
+{
+    mecs_component_type_t* type;
+    mecs_bool_t write;
+} mecs_system_access_t;
+
+typedef struct mecs_system_t
+{
+    char const* name;
+    mecs_system_func_t func;
+    void* user_data;
+    mecs_system_access_t* accesses;
+    mecs_size_t accesses_len;
+    mecs_size_t accesses_cap;
+    mecs_bool_t structural;
+    double time;                            /* Time of the last run. */
+    double path_time;                       /* Time from the start of the run until this system finished, with unlimited threads. */
+} mecs_system_t;
+
+typedef struct mecs_scheduler_stats_t
+{
+    double frame_time;
+    double critical_path_time;
+    double systems_time;
+    mecs_size_t systems_count;
+    mecs_size_t waves_count;
+} mecs_scheduler_stats_t;
+
+typedef struct mecs_scheduler_t
+{
+    mecs_system_t* systems;
+    mecs_size_t systems_len;
+    mecs_size_t systems_cap;
+
+    /* Systems sorted by wave, wave i holds the systems in waves[wave_offsets[i]] up to waves[wave_offsets[i + 1]]. */
+    mecs_system_id_t* waves;
+    mecs_size_t* wave_offsets;
+    mecs_size_t waves_len;
+
+    /* Earlier systems each system depends on, the dependencies of system i start at dependency_offsets[i]. */
+    mecs_system_id_t* dependencies;
+    mecs_size_t* dependency_offsets;
+    mecs_bool_t built;
+
+    mecs_parallel_for_func_t parallel_for;
+    void* parallel_for_user_data;
+    mecs_clock_func_t clock;
+    void* clock_user_data;
+
+    mecs_scheduler_stats_t stats;
+} mecs_scheduler_t;
+
+typedef struct mecs_scheduler_job_t
+{
+    mecs_scheduler_t* scheduler;
+    mecs_registry_t* registry;
+    mecs_system_id_t const* systems;
+} mecs_scheduler_job_t;
+
+#define mecs_system_reads(io_scheduler, i_system, T)            mecs_system_access_impl((io_scheduler), (i_system), mecs_component_get_type_ptr(T), MECS_FALSE)
+#define mecs_system_writes(io_scheduler, i_system, T)           mecs_system_access_impl((io_scheduler), (i_system), mecs_component_get_type_ptr(T), MECS_TRUE)
+
+void                mecs_scheduler_create(mecs_scheduler_t* o_scheduler, mecs_parallel_for_func_t i_parallel_for, void* io_user_data);
+void                mecs_scheduler_destroy(mecs_scheduler_t* io_scheduler);
+void                mecs_scheduler_set_clock(mecs_scheduler_t* io_scheduler, mecs_clock_func_t i_clock, void* io_user_data);
+mecs_system_id_t    mecs_scheduler_add_system(mecs_scheduler_t* io_scheduler, char const* i_name, mecs_system_func_t i_func, void* io_user_data);
+void                mecs_system_access_impl(mecs_scheduler_t* io_scheduler, mecs_system_id_t i_system, mecs_component_type_t* i_type, mecs_bool_t i_write);
+void                mecs_system_set_structural(mecs_scheduler_t* io_scheduler, mecs_system_id_t i_system);
+void                mecs_scheduler_build(mecs_scheduler_t* io_scheduler);
+void                mecs_scheduler_run(mecs_scheduler_t* io_scheduler, mecs_registry_t* io_registry);
+void                mecs_scheduler_get_stats(mecs_scheduler_t const* i_scheduler, mecs_scheduler_stats_t* o_stats);
+
+/* Internal functions. */
+mecs_bool_t         mecs_system_conflicts(mecs_system_t const* i_system0, mecs_system_t const* i_system1);
+void                mecs_scheduler_run_system_job(void* io_job_data, mecs_size_t i_job_index);
+
+#endif /* MECS_SCHEDULER_H */
+
+#ifdef MECS_IMPLEMENTATION
+
+void mecs_scheduler_create(mecs_scheduler_t* o_scheduler, mecs_parallel_for_func_t i_parallel_for, void* io_user_data)
+{
+    mecs_assert(o_scheduler != NULL);
+
+    mecs_memset(o_scheduler, 0, sizeof(mecs_scheduler_t));
+    o_scheduler->parallel_for = i_parallel_for != NULL ? i_parallel_for : &mecs_parallel_for_sequential;
+    o_scheduler->parallel_for_user_data = io_user_data;
+}
+
+void mecs_scheduler_destroy(mecs_scheduler_t* io_scheduler)
+{
+    mecs_size_t i;
+    mecs_assert(io_scheduler != NULL);
+
+    for (i = 0; i < io_scheduler->systems_len; ++i)
+    {
+        if (io_scheduler->systems[i].accesses != NULL)
+        {
+            mecs_free(io_scheduler->systems[i].accesses);
+        }
+    }
+    if (io_scheduler->systems != NULL)
+    {
+        mecs_free(io_scheduler->systems);
+    }
+    if (io_scheduler->waves != NULL)
+    {
+        mecs_free(io_scheduler->waves);
+    }
+    if (io_scheduler->wave_offsets != NULL)
+    {
+        mecs_free(io_scheduler->wave_offsets);
+    }
+    if (io_scheduler->dependencies != NULL)
+    {
+        mecs_free(io_scheduler->dependencies);
+    }
+    if (io_scheduler->dependency_offsets != NULL)
+    {
+        mecs_free(io_scheduler->dependency_offsets);
+    }
+    mecs_memset(io_scheduler, 0, sizeof(mecs_scheduler_t));
+}
+
+void mecs_scheduler_set_clock(mecs_scheduler_t* io_scheduler, mecs_clock_func_t i_clock, void* io_user_data)
+{
+    mecs_assert(io_scheduler != NULL);
+    io_scheduler->clock = i_clock;
+    io_scheduler->clock_user_data = io_user_data;
+}
+
+mecs_system_id_t mecs_scheduler_add_system(mecs_scheduler_t* io_scheduler, char const* i_name, mecs_system_func_t i_func, void* io_user_data)
+{
+    mecs_system_t* systems_grown;
+    mecs_size_t systems_grown_cap;
+    mecs_system_t* system;
+    mecs_assert(io_scheduler != NULL);
+    mecs_assert(i_func != NULL);
+
+    if (io_scheduler->systems_len == io_scheduler->systems_cap)
+    {
+        systems_grown_cap = io_scheduler->systems_cap == 0 ? 16 : io_scheduler->systems_cap * 2;
+        systems_grown = mecs_realloc_arr(mecs_system_t, io_scheduler->systems, systems_grown_cap);
+        if (systems_grown == NULL)
+        {
+            mecs_assert(MECS_FALSE);
+            return io_scheduler->systems_len;
+        }
+        io_scheduler->systems = systems_grown;
+        io_scheduler->systems_cap = systems_grown_cap;
+    }
+
+    system = &io_scheduler->systems[io_scheduler->systems_len];
+    mecs_memset(system, 0, sizeof(mecs_system_t));
+    system->name = i_name;
+    system->func = i_func;
+    system->user_data = io_user_data;
+    io_scheduler->built = MECS_FALSE;
+    return io_scheduler->systems_len++;
+}
+
+void mecs_system_access_impl(mecs_scheduler_t* io_scheduler, mecs_system_id_t i_system, mecs_component_type_t* i_type, mecs_bool_t i_write)
+{
+    mecs_system_t* system;
+    mecs_system_access_t* accesses_grown;
+    mecs_size_t accesses_grown_cap;
+    mecs_size_t i;
+    mecs_assert(io_scheduler != NULL);
+    mecs_assert(i_system < io_scheduler->systems_len);
+    mecs_assert(i_type != NULL);
+
+    system = &io_scheduler->systems[i_system];
+    io_scheduler->built = MECS_FALSE;
+    for (i = 0; i < system->accesses_len; ++i)
+    {
+        if (system->accesses[i].type == i_type)
+        {
+            system->accesses[i].write = system->accesses[i].write || i_write;
+            return;
+        }
+    }
+
+    if (system->accesses_len == system->accesses_cap)
+    {
+        accesses_grown_cap = system->accesses_cap == 0 ? 4 : system->accesses_cap * 2;
+        accesses_grown = mecs_realloc_arr(mecs_system_access_t, system->accesses, accesses_grown_cap);
+        if (accesses_grown == NULL)
+        {
+            mecs_assert(MECS_FALSE);
+            return;
+        }
+        system->accesses = accesses_grown;
+        system->accesses_cap = accesses_grown_cap;
+    }
+    system->accesses[system->accesses_len].type = i_type;
+    system->accesses[system->accesses_len].write = i_write;
+    system->accesses_len += 1;
+}
+
+void mecs_system_set_structural(mecs_scheduler_t* io_scheduler, mecs_system_id_t i_system)
+{
+    mecs_assert(io_scheduler != NULL);
+    mecs_assert(i_system < io_scheduler->systems_len);
+
+    io_scheduler->systems[i_system].structural = MECS_TRUE;
+    io_scheduler->built = MECS_FALSE;
+}
+
+mecs_bool_t mecs_system_conflicts(mecs_system_t const* i_system0, mecs_system_t const* i_system1)
+{
+    mecs_size_t i;
+    mecs_size_t j;
+
+    if (i_system0->structural || i_system1->structural)
+    {
+        return MECS_TRUE;
+    }
+    for (i = 0; i < i_system0->accesses_len; ++i)
+    {
+        for (j = 0; j < i_system1->accesses_len; ++j)
+        {
+            if (i_system0->accesses[i].type == i_system1->accesses[j].type && (i_system0->accesses[i].write || i_system1->accesses[j].write))
+            {
+                return MECS_TRUE;
+            }
+        }
+    }
+    return MECS_FALSE;
+}
+
+void mecs_scheduler_build(mecs_scheduler_t* io_scheduler)
+{
+    mecs_size_t systems_len;
+    mecs_size_t dependencies_len;
+    mecs_size_t* levels;
+    mecs_size_t level;
+    mecs_size_t i;
+    mecs_size_t j;
+    mecs_assert(io_scheduler != NULL);
+
+    mecs_profile_begin("mecs_scheduler_build");
+
+    if (io_scheduler->waves != NULL)
+    {
+        mecs_free(io_scheduler->waves);
+    }
+    if (io_scheduler->wave_offsets != NULL)
+    {
+        mecs_free(io_scheduler->wave_offsets);
+    }
+    if (io_scheduler->dependencies != NULL)
+    {
+        mecs_free(io_scheduler->dependencies);
+    }
+    if (io_scheduler->dependency_offsets != NULL)
+    {
+        mecs_free(io_scheduler->dependency_offsets);
+    }
+
+    /* Count the conflicts with earlier systems first so the dependencies fit in one array. */
+    systems_len = io_scheduler->systems_len;
+    dependencies_len = 0;
+    for (j = 0; j < systems_len; ++j)
+    {
+        for (i = 0; i < j; ++i)
+        {
+            dependencies_len += mecs_system_conflicts(&io_scheduler->systems[i], &io_scheduler->systems[j]) ? 1 : 0;
+        }
+    }
+
+    /* Every array holds at least one element to tell an empty scheduler apart from a failed allocation. */
+    io_scheduler->waves = mecs_malloc_arr(mecs_system_id_t, systems_len + 1);
+    io_scheduler->wave_offsets = mecs_malloc_arr(mecs_size_t, systems_len + 1);
+    io_scheduler->dependencies = mecs_malloc_arr(mecs_system_id_t, dependencies_len + 1);
+    io_scheduler->dependency_offsets = mecs_malloc_arr(mecs_size_t, systems_len + 1);
+    levels = mecs_malloc_arr(mecs_size_t, systems_len + 1);
+    io_scheduler->waves_len = 0;
+    io_scheduler->built = MECS_FALSE;
+    if (io_scheduler->waves == NULL || io_scheduler->wave_offsets == NULL || io_scheduler->dependencies == NULL || io_scheduler->dependency_offsets == NULL || levels == NULL)
+    {
+        mecs_assert(MECS_FALSE);
+        if (levels != NULL)
+        {
+            mecs_free(levels);
+        }
+        mecs_profile_end("mecs_scheduler_build");
+        return;
+    }
+
+    /* A system runs one wave after the latest wave of the systems it depends on. */
+    dependencies_len = 0;
+    for (j = 0; j < systems_len; ++j)
+    {
+        io_scheduler->dependency_offsets[j] = dependencies_len;
+        levels[j] = 0;
+        for (i = 0; i < j; ++i)
+        {
+            if (mecs_system_conflicts(&io_scheduler->systems[i], &io_scheduler->systems[j]))
+            {
+                io_scheduler->dependencies[dependencies_len++] = i;
+                if (levels[i] + 1 > levels[j])
+                {
+                    levels[j] = levels[i] + 1;
+                }
+            }
+        }
+        if (levels[j] + 1 > io_scheduler->waves_len)
+        {
+            io_scheduler->waves_len = levels[j] + 1;
+        }
+    }
+    io_scheduler->dependency_offsets[systems_len] = dependencies_len;
+
+    /* Counting sort by level, keeping systems in the order they were added within each wave. */
+    for (level = 0; level <= io_scheduler->waves_len; ++level)
+    {
+        io_scheduler->wave_offsets[level] = 0;
+    }
+    for (j = 0; j < systems_len; ++j)
+    {
+        io_scheduler->wave_offsets[levels[j] + 1] += 1;
+    }
+    for (level = 0; level < io_scheduler->waves_len; ++level)
+    {
+        io_scheduler->wave_offsets[level + 1] += io_scheduler->wave_offsets[level];
+    }
+    for (j = 0; j < systems_len; ++j)
+    {
+        io_scheduler->waves[io_scheduler->wave_offsets[levels[j]]++] = j;
+    }
+    for (level = io_scheduler->waves_len; level > 0; --level)
+    {
+        io_scheduler->wave_offsets[level] = io_scheduler->wave_offsets[level - 1];
+    }
+    io_scheduler->wave_offsets[0] = 0;
+
+    mecs_free(levels);
+    io_scheduler->built = MECS_TRUE;
+    mecs_profile_end("mecs_scheduler_build");
+}
+
+void mecs_scheduler_run_system_job(void* io_job_data, mecs_size_t i_job_index)
+{
+    mecs_scheduler_job_t* job;
+    mecs_system_t* system;
+    double begin;
+
+    job = (mecs_scheduler_job_t*)io_job_data;
+    system = &job->scheduler->systems[job->systems[i_job_index]];
+    if (job->scheduler->clock == NULL)
+    {
+        system->func(job->registry, system->user_data);
+        return;
+    }
+
+    begin = job->scheduler->clock(job->scheduler->clock_user_data);
+    system->func(job->registry, system->user_data);
+    system->time = job->scheduler->clock(job->scheduler->clock_user_data) - begin;
+}
+
+void mecs_scheduler_run(mecs_scheduler_t* io_scheduler, mecs_registry_t* io_registry)
+{
+    mecs_scheduler_job_t job;
+    mecs_system_t* system;
+    mecs_size_t wave;
+    mecs_size_t i;
+    double begin;
+    double wave_time;
+    mecs_assert(io_scheduler != NULL);
+    mecs_assert(io_registry != NULL);
+
+    mecs_profile_begin("mecs_scheduler_run");
+
+    if (!io_scheduler->built)
+    {
+        mecs_scheduler_build(io_scheduler);
+        if (!io_scheduler->built)
+        {
+            mecs_profile_end("mecs_scheduler_run");
+            return;
+        }
+    }
+
+    begin = io_scheduler->clock != NULL ? io_scheduler->clock(io_scheduler->clock_user_data) : 0.0;
+    job.scheduler = io_scheduler;
+    job.registry = io_registry;
+    for (wave = 0; wave < io_scheduler->waves_len; ++wave)
+    {
+        job.systems = &io_scheduler->waves[io_scheduler->wave_offsets[wave]];
+        io_scheduler->parallel_for(io_scheduler->parallel_for_user_data, &mecs_scheduler_run_system_job, &job, io_scheduler->wave_offsets[wave + 1] - io_scheduler->wave_offsets[wave]);
+    }
+
+    mecs_memset(&io_scheduler->stats, 0, sizeof(mecs_scheduler_stats_t));
+    io_scheduler->stats.systems_count = io_scheduler->systems_len;
+    io_scheduler->stats.waves_count = io_scheduler->waves_len;
+    if (io_scheduler->clock != NULL)
+    {
+        io_scheduler->stats.frame_time = io_scheduler->clock(io_scheduler->clock_user_data) - begin;
+
+        /* Every wave waits for the whole previous wave, so the critical path is the slowest system of each wave. */
+        for (wave = 0; wave < io_scheduler->waves_len; ++wave)
+        {
+            wave_time = 0.0;
+            for (i = io_scheduler->wave_offsets[wave]; i < io_scheduler->wave_offsets[wave + 1]; ++i)
+            {
+                system = &io_scheduler->systems[io_scheduler->waves[i]];
+                system->path_time = io_scheduler->stats.critical_path_time + system->time;
+                io_scheduler->stats.systems_time += system->time;
+                if (system->time > wave_time)
+                {
+                    wave_time = system->time;
+                }
+            }
+            io_scheduler->stats.critical_path_time += wave_time;
+        }
+    }
+
+    mecs_profile_end("mecs_scheduler_run");
+}
+
+void mecs_scheduler_get_stats(mecs_scheduler_t const* i_scheduler, mecs_scheduler_stats_t* o_stats)
+{
+    mecs_assert(i_scheduler != NULL);
+    mecs_assert(o_stats != NULL);
+    *o_stats = i_scheduler->stats;
+}
+
+#endif /* MECS_IMPLEMENTATION */
@@ -19,6 +19,59 @@ Table:
 
 1.) FUNCTIONS
 
+    serialise_registry_binary
+    deserialise_registry_binary
+        void serialise_registry_binary(registry_t const* i_registry, void** o_data, mecs_size_t* o_size)
+        void deserialise_registry_binary(registry_t* o_registry, void* i_data, mecs_size_t i_size)
+
+    serialise_registry_binary_into
+        void serialise_registry_binary_into(serialiser_binary_t* io_serialiser, registry_t const* i_registry)
+
+        Resets the serialiser and serialises the registry into its buffer, available as data and size. The buffer
+        is kept between calls, so repeatedly taking snapshots only allocates while the registry grows.
+
+    serialiser_binary_create
+    serialiser_binary_create_with_buffer
+    serialiser_binary_destroy
+    serialiser_binary_reset
+        void serialiser_binary_create(serialiser_binary_t* o_serialiser)
+        void serialiser_binary_create_with_buffer(serialiser_binary_t* o_serialiser, void* io_buffer, mecs_size_t i_capacity)
+        void serialiser_binary_destroy(serialiser_binary_t* io_serialiser)
+        void serialiser_binary_reset(serialiser_binary_t* io_serialiser)
+
+        A serialiser created with a buffer writes into it without taking ownership. Once the buffer is full the
+        data is moved to a newly allocated buffer owned by the serialiser, which destroy frees. Reset empties the
+        serialiser while keeping its buffer.
+
+    serialise_registry_binary_parallel
+    deserialise_registry_binary_parallel
+        void serialise_registry_binary_parallel(registry_t const* i_registry, mecs_parallel_for_func_t i_parallel_for, void* io_user_data, void** o_data, mecs_size_t* o_size)
+        void deserialise_registry_binary_parallel(registry_t* o_registry, mecs_parallel_for_func_t i_parallel_for, void* io_user_data, void* i_data, mecs_size_t i_size)
+
+        Serialises each component store into its own buffer using the parallel for hook, after which the buffers
+        are concatenated behind a table holding the offset and size of each store. On load each component store
+        is deserialised as a separate job. Passing NULL as parallel for runs all jobs on the calling thread. The
+        output is not compatible with serialise_registry_binary.
+
+    Out of order serialisation
+        If allow_out_of_order is set, which is the default for the binary serialisers, component stores are keyed
+        by the hash of the name their component was registered with rather than by their id. Deserialising then
+        no longer depends on the order in which components are registered. Stores of components which are not
+        registered with the deserialising registry are skipped without being parsed.
+
+    Byte order
+        The binary serialisers write data in the byte order of the host, prefixed by a header describing the byte
+        order and the width of sizes. Data written on a machine with the same byte order is loaded as is. Otherwise
+        all values are converted while loading. Trivial components are written as binary blobs and need a
+        description of their fields to be converted, register one with COMPONENT_REGISTER_BYTE_SWAP_FIELDS. The
+        description lists the size in bytes of each consecutive field, padding included as fields of 1 byte.
+
+    COMPONENT_REGISTER_BYTE_SWAP_FIELDS
+        void COMPONENT_REGISTER_BYTE_SWAP_FIELDS(T, mecs_uint8_t const* i_field_sizes, mecs_size_t i_field_count)
+
+    byte_swap
+        void byte_swap(void* io_data, mecs_size_t i_value_size, mecs_size_t i_count)
+
 2.) COMPILE TIME OPTIONS
 
     #define MECS_NO_SHORT_NAMES
@@ -44,6 +97,12 @@ Table:
         Allows to disable support for serialising types defined by the standard
         library.
 
+    #define MECS_NO_SIMD
+        Must be defined by the file containing #define MECS_IMPLEMENTATION.
+
+        Allows to disable the use of SSSE3 instructions for converting byte
+        order, which are otherwise used when the compiler targets SSSE3 or AVX.
+
 */
 #ifndef MECS_SERIALISATION_H
 #define MECS_SERIALISATION_H
@@ -53,6 +112,8 @@ Table:
 #define deserialiser_t                          mecs_deserialiser_t
 #define serialise_registry                      mecs_serialise_registry
 #define deserialise_registry                    mecs_deserialise_registry
+#define serialise_entities                      mecs_serialise_entities
+#define deserialise_entities                    mecs_deserialise_entities
 #define serialise_component_store               mecs_serialise_component_store
 #define deserialise_component_store             mecs_deserialise_component_store
 
@@ -77,11 +138,19 @@ Table:
 #define COMPONENT_REGISTER_SERIALISATION_HOOKS  MECS_COMPONENT_REGISTER_SERIALISATION_HOOKS
 #define COMPONENT_REGISTER_SERIALISE_HOOK       MECS_COMPONENT_REGISTER_SERIALISE_HOOK
 #define COMPONENT_REGISTER_DESERIALISE_HOOK     MECS_COMPONENT_REGISTER_DESERIALISE_HOOK
+#define COMPONENT_REGISTER_BYTE_SWAP_FIELDS     MECS_COMPONENT_REGISTER_BYTE_SWAP_FIELDS
+#define byte_swap                               mecs_byte_swap
 #define serialiser_binary_t                     mecs_serialiser_binary_t
 #define deserialiser_binary_t                   mecs_deserialiser_binary_t
 #define serialise_registry_binary               mecs_serialise_registry_binary
 #define deserialise_registry_binary             mecs_deserialise_registry_binary
+#define serialise_registry_binary_parallel      mecs_serialise_registry_binary_parallel
+#define deserialise_registry_binary_parallel    mecs_deserialise_registry_binary_parallel
+#define serialise_registry_binary_into          mecs_serialise_registry_binary_into
 #define serialiser_binary_create                mecs_serialiser_binary_create
+#define serialiser_binary_create_with_buffer    mecs_serialiser_binary_create_with_buffer
+#define serialiser_binary_destroy               mecs_serialiser_binary_destroy
+#define serialiser_binary_reset                 mecs_serialiser_binary_reset
 #define deserialiser_binary_create              mecs_deserialiser_binary_create
 #endif
 
@@ -103,6 +172,9 @@ typedef void(*mecs_serialiser_list_end_func_t)(mecs_serialiser_t* io_serialiser)
 typedef void(*mecs_serialiser_map_begin_func_t)(mecs_serialiser_t* io_serialiser, mecs_size_t i_length);
 typedef void(*mecs_serialiser_map_end_func_t)(mecs_serialiser_t* io_serialiser);
 typedef void(*mecs_serialiser_write_func_t)(mecs_serialiser_t* io_serialiser, void const* i_data, mecs_size_t i_size);
+typedef void(*mecs_serialiser_write_values_func_t)(mecs_serialiser_t* io_serialiser, void const* i_data, mecs_size_t i_value_size, mecs_size_t i_count);
+typedef void(*mecs_serialiser_block_begin_func_t)(mecs_serialiser_t* io_serialiser, mecs_size_t* o_marker);
+typedef void(*mecs_serialiser_block_end_func_t)(mecs_serialiser_t* io_serialiser, mecs_size_t i_marker);
 
 struct mecs_serialiser_t
 {
@@ -119,6 +191,11 @@ struct mecs_serialiser_t
     mecs_serialiser_map_begin_func_t map_begin_func;
     mecs_serialiser_map_end_func_t map_end_func;
     mecs_serialiser_write_func_t write_func;
+    mecs_serialiser_write_values_func_t write_values_func; /* Writes an array of scalar values which may need their byte order converted. Falls back to write_func if NULL. */
+
+    /* Blocks are prefixed with their size in bytes, allowing deserialisers to skip over them. Required for out of order serialisation. */
+    mecs_serialiser_block_begin_func_t block_begin_func;
+    mecs_serialiser_block_end_func_t block_end_func;
 };
 
 typedef void(*mecs_deserialiser_object_begin_func_t)(mecs_deserialiser_t* io_deserialiser);
@@ -128,6 +205,10 @@ typedef void(*mecs_deserialiser_list_end_func_t)(mecs_deserialiser_t* io_deseria
 typedef void(*mecs_deserialiser_map_begin_func_t)(mecs_deserialiser_t* io_deserialiser, mecs_size_t* o_length);
 typedef void(*mecs_deserialiser_map_end_func_t)(mecs_deserialiser_t* io_deserialiser);
 typedef void(*mecs_deserialiser_read_func_t)(mecs_deserialiser_t* io_deserialiser, void* o_data, mecs_size_t i_size);
+typedef void(*mecs_deserialiser_read_values_func_t)(mecs_deserialiser_t* io_deserialiser, void* o_data, mecs_size_t i_value_size, mecs_size_t i_count);
+typedef void(*mecs_deserialiser_block_begin_func_t)(mecs_deserialiser_t* io_deserialiser, mecs_size_t* o_size);
+typedef void(*mecs_deserialiser_block_end_func_t)(mecs_deserialiser_t* io_deserialiser);
+typedef void(*mecs_deserialiser_skip_func_t)(mecs_deserialiser_t* io_deserialiser, mecs_size_t i_size);
 
 struct mecs_deserialiser_t
 {
@@ -136,6 +217,7 @@ struct mecs_deserialiser_t
     mecs_bool_t allow_binary;
     mecs_bool_t allow_out_of_order;
     mecs_bool_t is_versioned;
+    mecs_bool_t is_byte_swapped; /* The data was written on a machine with a different byte order. */
 
     mecs_deserialiser_object_begin_func_t object_begin_func;
     mecs_deserialiser_object_end_func_t object_end_func;
@@ -144,6 +226,12 @@ struct mecs_deserialiser_t
     mecs_deserialiser_map_begin_func_t map_begin_func;
     mecs_deserialiser_map_end_func_t map_end_func;
     mecs_deserialiser_read_func_t read_func;
+    mecs_deserialiser_read_values_func_t read_values_func; /* Reads an array of scalar values, converting their byte order if needed. Falls back to read_func if NULL. */
+
+    /* Blocks are prefixed with their size in bytes, allowing to skip over them. Required for out of order deserialisation. */
+    mecs_deserialiser_block_begin_func_t block_begin_func;
+    mecs_deserialiser_block_end_func_t block_end_func;
+    mecs_deserialiser_skip_func_t skip_func;
 };
 
 typedef union 
@@ -157,15 +245,14 @@ typedef union
     #define MECS_FUNC_NAME_DESERIALISE(T_type) mecs__deserialise
     #define MECS_FUNC_NAME_ARCHIVE(T_type) mecs__archive
 
-    template<class T_type>
-    struct mecs_serialisation_is_trivial_impl;
-
+    /* Triviality is encoded in the size of the return type of an overload which is never defined. Unlike a template
+       specialisation the overload may be declared in the namespace of the type, where it is found through argument
+       dependent lookup. */
     #define mecs_serialisation_is_trivial(T_type)                                                                           \
-        mecs_serialisation_is_trivial_impl<T_type>::v                                                                       \
+        (sizeof(mecs__is_trivial((T_type*)0)) == 2)                                                                         \
 
     #define MECS_SERIALISATION_IS_TRIVIAL_DECLARE(T_type, i_is_trivial)                                                     \
-        template<>                                                                                                          \
-        struct mecs_serialisation_is_trivial_impl<T_type> { enum { v = i_is_trivial }; }                                    \
+        char (&mecs__is_trivial(T_type*))[(i_is_trivial) ? 2 : 1]                                                           \
 
     /* Argument dependent lookup allows to invoke a function in a different namespace from outside of that namespace 
        based on the function argument passed. This helper allows grabbing a function pointer to the serialise and 
@@ -337,16 +424,23 @@ Core serialisation types
     {                                                                                                                       \
         if (i_is_writer)                                                                                                    \
         {                                                                                                                   \
-            io_archive.serialiser->write_func(io_archive.serialiser, io_data, sizeof(*io_data));                            \
+            if (io_archive.serialiser->write_values_func)                                                                   \
+                io_archive.serialiser->write_values_func(io_archive.serialiser, io_data, sizeof(*io_data), 1);              \
+            else                                                                                                            \
+                io_archive.serialiser->write_func(io_archive.serialiser, io_data, sizeof(*io_data));                        \
         }                                                                                                                   \
         else                                                                                                                \
         {                                                                                                                   \
-            io_archive.deserialiser->read_func(io_archive.deserialiser, io_data, sizeof(*io_data));                         \
+            if (io_archive.deserialiser->read_values_func)                                                                  \
+                io_archive.deserialiser->read_values_func(io_archive.deserialiser, io_data, sizeof(*io_data), 1);           \
+            else                                                                                                            \
+                io_archive.deserialiser->read_func(io_archive.deserialiser, io_data, sizeof(*io_data));                     \
         }                                                                                                                   \
     }                                                                                                                       \
 
 #if !defined(MECS_SERIALISATION_NO_SUPPORT_MECS_TYPES)
-    #if !defined(__cplusplus) || defined(MECS_SERIALISATION_NO_SUPPORT_STD_TYPES) /* If we are compiling C++ and want to support std types skip these to prevent redefinition. */
+    /* If we are compiling C++11 and want to support std types skip these to prevent redefinition. */
+    #if !defined(__cplusplus) || __cplusplus < 201103L || defined(MECS_SERIALISATION_NO_SUPPORT_STD_TYPES)
         MECS_ARCHIVE_CORE_TYPE(mecs_bool_t)
         MECS_ARCHIVE_CORE_TYPE(mecs_uint8_t)
         MECS_ARCHIVE_CORE_TYPE(mecs_uint16_t)
@@ -404,8 +498,20 @@ void mecs_component_register_serialisation_hooks_impl(mecs_component_type_t* o_t
 void mecs_component_register_serialise_hook_impl(mecs_component_type_t* o_type, mecs_serialise_func_t i_serialise, mecs_bool_t i_is_trivial);
 void mecs_component_register_deserialise_hook_impl(mecs_component_type_t* o_type, mecs_deserialise_func_t i_deserialise, mecs_bool_t i_is_trivial);
 
+#define MECS_COMPONENT_REGISTER_BYTE_SWAP_FIELDS(T_component, i_field_sizes, i_field_count)                                 \
+    mecs_component_register_byte_swap_fields_impl(mecs_component_get_type_ptr(T_component), (i_field_sizes), (i_field_count)) \
+
+void mecs_component_register_byte_swap_fields_impl(mecs_component_type_t* o_type, mecs_uint8_t const* i_field_sizes, mecs_size_t i_field_count);
+
+/* Reverse the byte order of an array of scalar values of 1, 2, 4 or 8 bytes. */
+void mecs_byte_swap(void* io_data, mecs_size_t i_value_size, mecs_size_t i_count);
+void mecs_byte_swap_fields(void* io_data, mecs_size_t i_count, mecs_size_t i_stride, mecs_uint8_t const* i_field_sizes, mecs_size_t i_field_count);
+mecs_bool_t mecs_is_little_endian(void);
+
 void mecs_serialise_registry(mecs_serialiser_t* io_serialiser, mecs_registry_t const* i_registry);
 void mecs_deserialise_registry(mecs_deserialiser_t* io_deserialiser, mecs_registry_t*o_registry);
+void mecs_serialise_entities(mecs_serialiser_t* io_serialiser, mecs_registry_t const* i_registry);
+void mecs_deserialise_entities(mecs_deserialiser_t* io_deserialiser, mecs_registry_t* o_registry);
 void mecs_serialise_component_store(mecs_serialiser_t* io_serialiser, mecs_component_store_t* i_component_store);
 void mecs_deserialise_component_store(mecs_deserialiser_t* io_deserialiser, mecs_component_store_t* i_component_store);
 
@@ -420,6 +526,7 @@ typedef struct
     void* data;
     mecs_size_t capacity;
     mecs_size_t size;
+    mecs_bool_t owns_data; /* False while writing into a buffer provided by the user. */
 } mecs_serialiser_binary_t;
 
 typedef struct
@@ -428,20 +535,55 @@ typedef struct
     void* data;
     mecs_size_t size;
     mecs_size_t position;
+    mecs_uint8_t size_width; /* Width in bytes of sizes in the data, as described by its header. */
 } mecs_deserialiser_binary_t;
 
+/* Header at the start of binary data describing the machine it was written on. */
+#define MECS_BINARY_HEADER_SIZE 8
+#define MECS_BINARY_HEADER_BIG_ENDIAN 0
+#define MECS_BINARY_HEADER_LITTLE_ENDIAN 1
+
+/* Jobs used to (de)serialise each component store into its own buffer concurrently. */
+typedef struct
+{
+    mecs_component_store_t** component_stores;
+    mecs_serialiser_binary_t* serialisers;
+    mecs_deserialiser_binary_t* deserialisers;
+} mecs_serialisation_binary_jobs_t;
+
 void mecs_serialise_registry_binary(mecs_registry_t const* i_registry, void** o_data, mecs_size_t* o_size);
 void mecs_deserialise_registry_binary(mecs_registry_t* o_registry, void* i_data, mecs_size_t i_size);
+void mecs_serialise_registry_binary_into(mecs_serialiser_binary_t* io_serialiser, mecs_registry_t const* i_registry);
+void mecs_serialise_registry_binary_parallel(mecs_registry_t const* i_registry, mecs_parallel_for_func_t i_parallel_for, void* io_user_data, void** o_data, mecs_size_t* o_size);
+void mecs_deserialise_registry_binary_parallel(mecs_registry_t* o_registry, mecs_parallel_for_func_t i_parallel_for, void* io_user_data, void* i_data, mecs_size_t i_size);
+void mecs_serialise_component_store_binary_job(void* io_jobs, mecs_size_t i_job_index);
+void mecs_deserialise_component_store_binary_job(void* io_jobs, mecs_size_t i_job_index);
 
 void mecs_serialiser_binary_create(mecs_serialiser_binary_t* o_serialiser);
+void mecs_serialiser_binary_create_with_buffer(mecs_serialiser_binary_t* o_serialiser, void* io_buffer, mecs_size_t i_capacity);
+void mecs_serialiser_binary_destroy(mecs_serialiser_binary_t* io_serialiser);
+void mecs_serialiser_binary_reset(mecs_serialiser_binary_t* io_serialiser);
+void mecs_serialiser_binary_reserve(mecs_serialiser_binary_t* io_serialiser, mecs_size_t i_capacity);
+void mecs_serialiser_binary_grow(mecs_serialiser_binary_t* io_serialiser, mecs_size_t i_capacity);
+void mecs_serialiser_binary_write_header(mecs_serialiser_binary_t* io_serialiser);
 void mecs_deserialiser_binary_create(mecs_deserialiser_binary_t* o_deserialiser, void* i_data, mecs_size_t i_size);
+void mecs_deserialiser_binary_read_header(mecs_deserialiser_binary_t* io_deserialiser);
+
+void mecs_serialiser_binary_write_size(mecs_serialiser_t* io_serialiser, mecs_size_t i_size);
+void mecs_deserialiser_binary_read_size(mecs_deserialiser_t* io_deserialiser, mecs_size_t* o_size);
+void mecs_serialiser_binary_write_values_func(mecs_serialiser_t* io_serialiser, void const* i_data, mecs_size_t i_value_size, mecs_size_t i_count);
+void mecs_deserialiser_binary_read_values_func(mecs_deserialiser_t* io_deserialiser, void* o_data, mecs_size_t i_value_size, mecs_size_t i_count);
 
 void mecs_serialiser_binary_list_begin_func(mecs_serialiser_t* io_serialiser, mecs_size_t i_length);
 void mecs_serialiser_binary_map_begin_func(mecs_serialiser_t* io_serialiser, mecs_size_t i_length);
 void mecs_serialiser_binary_write_func(mecs_serialiser_t* io_serialiser, void const* i_data, mecs_size_t i_size);
+void mecs_serialiser_binary_block_begin_func(mecs_serialiser_t* io_serialiser, mecs_size_t* o_marker);
+void mecs_serialiser_binary_block_end_func(mecs_serialiser_t* io_serialiser, mecs_size_t i_marker);
 void mecs_deserialiser_binary_list_begin_func(mecs_deserialiser_t* io_deserialiser, mecs_size_t* o_length);
 void mecs_deserialiser_binary_map_begin_func(mecs_deserialiser_t* io_deserialiser, mecs_size_t* o_length);
 void mecs_deserialiser_binary_read_func(mecs_deserialiser_t* io_deserialiser, void* o_data, mecs_size_t i_size);
+void mecs_deserialiser_binary_block_begin_func(mecs_deserialiser_t* io_deserialiser, mecs_size_t* o_size);
+void mecs_deserialiser_binary_skip_func(mecs_deserialiser_t* io_deserialiser, mecs_size_t i_size);
 
 #endif /* MECS_SERIALISATION_H */
 
@@ -472,6 +614,94 @@ void mecs_component_register_deserialise_hook_impl(mecs_component_type_t* o_type
     o_type->is_trivial = i_is_trivial;
 }
 
+void mecs_component_register_byte_swap_fields_impl(mecs_component_type_t* o_type, mecs_uint8_t const* i_field_sizes, mecs_size_t i_field_count)
+{
+    mecs_assert(o_type);
+    mecs_assert(i_field_sizes != NULL || i_field_count == 0);
+    o_type->byte_swap_fields = i_field_sizes;
+    o_type->byte_swap_fields_len = i_field_count;
+}
+
+#if !defined(MECS_NO_SIMD) && (defined(__SSSE3__) || defined(__AVX__))
+    #define MECS_SIMD_SSSE3
+    #include <tmmintrin.h>
+#endif
+
+void mecs_byte_swap(void* io_data, mecs_size_t i_value_size, mecs_size_t i_count)
+{
+    mecs_uint8_t* data;
+    mecs_uint8_t temp;
+    mecs_size_t bytes;
+    mecs_size_t i;
+    mecs_size_t lo;
+    mecs_size_t hi;
+    #if defined(MECS_SIMD_SSSE3)
+        __m128i shuffle;
+        __m128i values;
+    #endif
+    mecs_assert(io_data != NULL || i_count == 0);
+    mecs_assert(i_value_size == 1 || i_value_size == 2 || i_value_size == 4 || i_value_size == 8);
+
+    if (i_value_size == 1)
+    {
+        return;
+    }
+
+    data = (mecs_uint8_t*)io_data;
+    bytes = i_value_size * i_count;
+    i = 0;
+
+    #if defined(MECS_SIMD_SSSE3)
+        /* Reverse the bytes of 16 bytes worth of values at a time with a single shuffle. */
+        if (i_value_size == 2)      shuffle = _mm_set_epi8(14, 15, 12, 13, 10, 11, 8, 9, 6, 7, 4, 5, 2, 3, 0, 1);
+        else if (i_value_size == 4) shuffle = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+        else                        shuffle = _mm_set_epi8(8, 9, 10, 11, 12, 13, 14, 15, 0, 1, 2, 3, 4, 5, 6, 7);
+        for (; i + 16 <= bytes; i += 16)
+        {
+            values = _mm_loadu_si128((__m128i const*)(data + i));
+            _mm_storeu_si128((__m128i*)(data + i), _mm_shuffle_epi8(values, shuffle));
+        }
+    #endif
+
+    for (; i < bytes; i += i_value_size)
+    {
+        for (lo = i, hi = i + i_value_size - 1; lo < hi; ++lo, --hi)
+        {
+            temp = data[lo];
+            data[lo] = data[hi];
+            data[hi] = temp;
+        }
+    }
+}
+
+void mecs_byte_swap_fields(void* io_data, mecs_size_t i_count, mecs_size_t i_stride, mecs_uint8_t const* i_field_sizes, mecs_size_t i_field_count)
+{
+    mecs_uint8_t* data;
+    mecs_size_t i;
+    mecs_size_t field_idx;
+    mecs_size_t field_offset;
+    mecs_assert(io_data != NULL || i_count == 0);
+
+    data = (mecs_uint8_t*)io_data;
+    for (i = 0; i < i_count; ++i)
+    {
+        field_offset = 0;
+        for (field_idx = 0; field_idx < i_field_count; ++field_idx)
+        {
+            mecs_byte_swap(data + (i * i_stride) + field_offset, i_field_sizes[field_idx], 1);
+            field_offset += i_field_sizes[field_idx];
+        }
+        mecs_assert(field_offset == i_stride); /* The fields must describe the entire component including padding. */
+    }
+}
+
+mecs_bool_t mecs_is_little_endian(void)
+{
+    mecs_uint32_t value;
+    value = 1;
+    return *(mecs_uint8_t*)&value == 1 ? MECS_TRUE : MECS_FALSE;
+}
+
 #define mecs_object_begin(io_serialiser)            if ((io_serialiser)->object_begin_func) (io_serialiser)->object_begin_func(io_serialiser)
 #define mecs_object_end(io_serialiser)              if ((io_serialiser)->object_end_func) (io_serialiser)->object_end_func(io_serialiser)
 #define mecs_list_begin(io_serialiser, io_length)   if ((io_serialiser)->list_begin_func) (io_serialiser)->list_begin_func(io_serialiser, io_length)
@@ -480,6 +710,16 @@ void mecs_component_register_deserialise_hook_impl(mecs_component_type_t* o_type
 #define mecs_map_end(io_serialiser)                 if ((io_serialiser)->map_end_func) (io_serialiser)->map_end_func(io_serialiser)
 #define mecs_write(io_serialiser, i_data, i_size)   if ((io_serialiser)->write_func) (io_serialiser)->write_func((io_serialiser), (i_data), (i_size))
 #define mecs_read(io_serialiser, o_data, i_size)    if ((io_serialiser)->read_func) (io_serialiser)->read_func((io_serialiser), (o_data), (i_size))
+#define mecs_write_values(io_serialiser, i_data, i_value_size, i_count)                                                     \
+    if ((io_serialiser)->write_values_func) (io_serialiser)->write_values_func((io_serialiser), (i_data), (i_value_size), (i_count)); \
+    else mecs_write((io_serialiser), (i_data), (i_value_size) * (i_count))
+#define mecs_read_values(io_serialiser, o_data, i_value_size, i_count)                                                      \
+    if ((io_serialiser)->read_values_func) (io_serialiser)->read_values_func((io_serialiser), (o_data), (i_value_size), (i_count)); \
+    else mecs_read((io_serialiser), (o_data), (i_value_size) * (i_count))
+#define mecs_block_begin(io_serialiser, io_marker)  if ((io_serialiser)->block_begin_func) (io_serialiser)->block_begin_func((io_serialiser), (io_marker))
+#define mecs_block_end(io_serialiser, i_marker)     if ((io_serialiser)->block_end_func) (io_serialiser)->block_end_func((io_serialiser), (i_marker))
+#define mecs_block_end_read(io_serialiser)          if ((io_serialiser)->block_end_func) (io_serialiser)->block_end_func(io_serialiser)
+#define mecs_skip(io_serialiser, i_size)            if ((io_serialiser)->skip_func) (io_serialiser)->skip_func((io_serialiser), (i_size))
 
 
 void mecs_serialise_registry(mecs_serialiser_t* io_serialiser, mecs_registry_t const* i_registry)
@@ -487,26 +727,14 @@ void mecs_serialise_registry(mecs_serialiser_t* io_serialiser, mecs_registry_t c
     mecs_component_size_t i;
     mecs_component_size_t component_id;
     mecs_component_store_t* component_store;
+    mecs_size_t block_marker;
+    mecs_profile_begin("mecs_serialise_registry");
     mecs_assert(io_serialiser != NULL);
     mecs_assert(i_registry != NULL);
+    mecs_assert(!io_serialiser->allow_out_of_order || (io_serialiser->block_begin_func != NULL && io_serialiser->block_end_func != NULL));
 
-    /* Serialise free and allocated entities. */
-    mecs_list_begin(io_serialiser, i_registry->entities_len);
-    {
-        if (io_serialiser->allow_binary)
-        {
-            mecs_write(io_serialiser, i_registry->entities, i_registry->entities_len * sizeof(mecs_entity_t));
-        }
-        else
-        {
-            for (i = 0; i < i_registry->entities_len; ++i)
-            {
-                mecs_write(io_serialiser, &i_registry->entities[i], sizeof(mecs_entity_t));
-            }
-        }
-    }
-    mecs_list_end(io_serialiser);
-    mecs_write(io_serialiser, &i_registry->next_free_entity, sizeof(mecs_entity_t));
+    block_marker = 0;
+    mecs_serialise_entities(io_serialiser, i_registry);
 
     /* Serialise component stores. */
     mecs_map_begin(io_serialiser, i_registry->valid_components_count);
@@ -519,118 +747,193 @@ void mecs_serialise_registry(mecs_serialiser_t* io_serialiser, mecs_registry_t c
         }
 
         component_id = i;
-        mecs_write(io_serialiser, &component_id, sizeof(component_id));
-
         component_store = &i_registry->components[component_id];
-        mecs_serialise_component_store(io_serialiser, component_store);
+        if (io_serialiser->allow_out_of_order)
+        {
+            /* Key the component store by name and prefix it with its size so it can be skipped if the component no longer exists. */
+            mecs_write_values(io_serialiser, &component_store->type->name_hash, sizeof(mecs_uint32_t), 1);
+            mecs_block_begin(io_serialiser, &block_marker);
+            mecs_serialise_component_store(io_serialiser, component_store);
+            mecs_block_end(io_serialiser, block_marker);
+        }
+        else
+        {
+            mecs_write_values(io_serialiser, &component_id, sizeof(component_id), 1);
+            mecs_serialise_component_store(io_serialiser, component_store);
+        }
     }
     mecs_map_end(io_serialiser);
+    mecs_profile_end("mecs_serialise_registry");
 }
 
 void mecs_deserialise_registry(mecs_deserialiser_t* io_deserialiser, mecs_registry_t* o_registry)
 {
-    mecs_size_t entities_len;
     mecs_size_t valid_components_count;
-    mecs_entity_t* entity;
     mecs_component_size_t i;
     mecs_component_size_t component_id;
     mecs_component_store_t* component_store;
+    mecs_uint32_t name_hash;
+    mecs_component_type_t* type;
+    mecs_size_t block_size;
+    mecs_profile_begin("mecs_deserialise_registry");
     mecs_assert(io_deserialiser != NULL);
     mecs_assert(o_registry != NULL);
+    mecs_assert(!io_deserialiser->allow_out_of_order || (io_deserialiser->block_begin_func != NULL && io_deserialiser->skip_func != NULL));
 
-    entities_len = 0;
     valid_components_count = 0;
     component_id = 0;
+    name_hash = 0;
+    block_size = 0;
 
-    /* Deserialise free and allocated entities. */
-    mecs_list_begin(io_deserialiser, &entities_len);
+    mecs_deserialise_entities(io_deserialiser, o_registry);
+
+    /* Deserialise component stores. */
+    mecs_map_begin(io_deserialiser, &valid_components_count);
+    for (i = 0; i < valid_components_count; ++i)
     {
-        /* Ensure enough memory to deserialise entities. */
-        mecs_assert(entities_len < MECS_ENTITY_ID_INVALID);
-        entity = mecs_entity_create_array(o_registry, (mecs_entity_size_t)entities_len);
-        mecs_assert(entity != NULL);
+        /* TODO: Clear component stores not in deserialised data. */
+        if (io_deserialiser->allow_out_of_order)
+        {
+            mecs_read_values(io_deserialiser, &name_hash, sizeof(mecs_uint32_t), 1);
+            mecs_block_begin(io_deserialiser, &block_size);
+            type = mecs_component_find_by_name_hash(o_registry, name_hash);
+            if (type == NULL)
+            {
+                /* The component is not registered with this registry, skip over its data. */
+                mecs_skip(io_deserialiser, block_size);
+            }
+            else
+            {
+                mecs_deserialise_component_store(io_deserialiser, &o_registry->components[type->id]);
+                mecs_block_end_read(io_deserialiser);
+            }
+        }
+        else
+        {
+            mecs_read_values(io_deserialiser, &component_id, sizeof(component_id), 1);
+            mecs_assert(component_id < o_registry->components_len);
+            component_store = &o_registry->components[component_id];
+            mecs_deserialise_component_store(io_deserialiser, component_store);
+        }
+    }
+    mecs_map_end(io_deserialiser);
+    mecs_profile_end("mecs_deserialise_registry");
+}
 
-        if (io_deserialiser->allow_binary)
+void mecs_serialise_entities(mecs_serialiser_t* io_serialiser, mecs_registry_t const* i_registry)
+{
+    mecs_entity_size_t i;
+    mecs_assert(io_serialiser != NULL);
+    mecs_assert(i_registry != NULL);
+
+    /* Serialise free and allocated entities. */
+    mecs_list_begin(io_serialiser, i_registry->entities_len);
+    {
+        if (io_serialiser->allow_binary)
         {
-            mecs_read(io_deserialiser, o_registry->entities, entities_len * sizeof(mecs_entity_t));
+            mecs_write_values(io_serialiser, i_registry->entities, sizeof(mecs_entity_t), i_registry->entities_len);
         }
         else
         {
-            for (i = 0; i < entities_len; ++i)
+            for (i = 0; i < i_registry->entities_len; ++i)
             {
-                mecs_read(io_deserialiser, &o_registry->entities[i], sizeof(mecs_entity_t));
+                mecs_write_values(io_serialiser, &i_registry->entities[i], sizeof(mecs_entity_t), 1);
             }
         }
     }
-    mecs_list_end(io_deserialiser);
-    mecs_read(io_deserialiser, &o_registry->next_free_entity, sizeof(mecs_entity_t));
+    mecs_list_end(io_serialiser);
+    mecs_write_values(io_serialiser, &i_registry->next_free_entity, sizeof(mecs_entity_t), 1);
+}
 
-    /* Deserialise component stores. */
-    mecs_map_begin(io_deserialiser, &valid_components_count);
-    for (i = 0; i < valid_components_count; ++i)
+void mecs_deserialise_entities(mecs_deserialiser_t* io_deserialiser, mecs_registry_t* o_registry)
+{
+    mecs_size_t entities_len;
+    mecs_entity_size_t i;
+    mecs_assert(io_deserialiser != NULL);
+    mecs_assert(o_registry != NULL);
+
+    entities_len = 0;
+
+    /* Deserialise free and allocated entities. */
+    mecs_list_begin(io_deserialiser, &entities_len);
     {
-        mecs_read(io_deserialiser, &component_id, sizeof(component_id));
-        /* TODO: Clear component stores not in deserialised data. */
+        /* Ensure enough memory to deserialise entities. */
+        mecs_assert(entities_len < MECS_ENTITY_ID_INVALID);
+        if (mecs_entity_create_array(o_registry, (mecs_entity_size_t)entities_len) == NULL)
+        {
+            mecs_assert(MECS_FALSE);
+            mecs_list_end(io_deserialiser);
+            return;
+        }
 
-        if (io_deserialiser->allow_out_of_order)
+        if (io_deserialiser->allow_binary)
         {
-            /* TODO */
+            mecs_read_values(io_deserialiser, o_registry->entities, sizeof(mecs_entity_t), entities_len);
         }
         else
         {
-            mecs_assert(component_id < o_registry->components_len);
-            component_store = &o_registry->components[component_id];
-            mecs_deserialise_component_store(io_deserialiser, component_store);
+            for (i = 0; i < entities_len; ++i)
+            {
+                mecs_read_values(io_deserialiser, &o_registry->entities[i], sizeof(mecs_entity_t), 1);
+            }
         }
     }
-    mecs_map_end(io_deserialiser);
+    mecs_list_end(io_deserialiser);
+    mecs_read_values(io_deserialiser, &o_registry->next_free_entity, sizeof(mecs_entity_t), 1);
 }
 
 void mecs_serialise_component_store(mecs_serialiser_t* io_serialiser, mecs_component_store_t* i_component_store)
 {
     mecs_entity_size_t i;
+    mecs_entity_size_t page_count;
     mecs_entity_size_t page_index;
     mecs_entity_size_t page_offset;
     mecs_entity_size_t page_len;
     void* page;
     void* component;
+    mecs_profile_begin("mecs_serialise_component_store");
     mecs_assert(io_serialiser != NULL);
     mecs_assert(i_component_store != NULL);
     mecs_assert(i_component_store->type->serialise_func != NULL);
 
     mecs_object_begin(io_serialiser);
     {
-        mecs_list_begin(io_serialiser, i_component_store->entities_count);
+        mecs_list_begin(io_serialiser, i_component_store->entities_count - i_component_store->tombstones_count);
         {
-            /* Serialise all entities. Each index maps to an entry in the components list but its faster to not interleave the data. */
-            if (io_serialiser->allow_binary)
+            /* Serialise all entities. Each index maps to an entry in the components list but its faster to not interleave the data. 
+               Tombstones of stable components are left out, they are deserialised packed. */
+            if (io_serialiser->allow_binary && i_component_store->tombstones_count == 0)
             {
-                mecs_write(io_serialiser, i_component_store->dense, i_component_store->entities_count * sizeof(mecs_dense_t));
+                mecs_write_values(io_serialiser, i_component_store->dense, sizeof(mecs_dense_t), i_component_store->entities_count);
             }
             else 
             {
                 for (i = 0; i < i_component_store->entities_count; ++i)
                 {
-                    mecs_write(io_serialiser, &i_component_store->dense[i], sizeof(mecs_dense_t));
+                    if (mecs_entity_get_id(i_component_store->dense[i]) != MECS_ENTITY_ID_INVALID)
+                    {
+                        mecs_write_values(io_serialiser, &i_component_store->dense[i], sizeof(mecs_dense_t), 1);
+                    }
                 }
             }
         }
         mecs_list_end(io_serialiser);
-        mecs_list_begin(io_serialiser, i_component_store->entities_count);
+        mecs_list_begin(io_serialiser, i_component_store->entities_count - i_component_store->tombstones_count);
         {
             /* Serialise all components. */
-            if (io_serialiser->allow_binary && i_component_store->type->is_trivial)
+            if (io_serialiser->allow_binary && i_component_store->type->is_trivial && i_component_store->tombstones_count == 0)
             {
-                /* Serialise each component page as a single binary blob. */
-                for (page_index = 0; page_index < i_component_store->components_len - 1; ++page_index)
+                /* Serialise each component page as a single binary blob. Only the pages in use are written, there may be more pages allocated. */
+                page_count = i_component_store->entities_count / MECS_PAGE_LEN_DENSE;
+                for (page_index = 0; page_index < page_count; ++page_index)
                 {
                     page = i_component_store->components[page_index];
                     page_len = MECS_PAGE_LEN_DENSE;
                     mecs_write(io_serialiser, page, i_component_store->type->size * page_len);
                 }
-                if (i_component_store->components_len > 0)
+                if (i_component_store->entities_count % MECS_PAGE_LEN_DENSE != 0)
                 {
-                    page = i_component_store->components[i_component_store->components_len - 1];
+                    page = i_component_store->components[page_count];
                     page_len = i_component_store->entities_count % MECS_PAGE_LEN_DENSE;
                     mecs_write(io_serialiser, page, i_component_store->type->size * page_len);
                 }
@@ -640,6 +943,10 @@ void mecs_serialise_component_store(mecs_serialiser_t* io_serialiser, mecs_compo
                 /* Serialise each component individually. */
                 for (i = 0; i < i_component_store->entities_count; ++i)
                 {
+                    if (mecs_entity_get_id(i_component_store->dense[i]) == MECS_ENTITY_ID_INVALID)
+                    {
+                        continue;
+                    }
                     page_index = i / MECS_PAGE_LEN_DENSE;
                     page_offset = i % MECS_PAGE_LEN_DENSE;
                     page = i_component_store->components[page_index];
@@ -651,14 +958,15 @@ void mecs_serialise_component_store(mecs_serialiser_t* io_serialiser, mecs_compo
         mecs_list_end(io_serialiser);
     }
     mecs_object_end(io_serialiser);
+    mecs_profile_end("mecs_serialise_component_store");
 }
 
 void mecs_deserialise_component_store(mecs_deserialiser_t* io_deserialiser, mecs_component_store_t* o_component_store)
 {
     mecs_size_t entities_count;
+    mecs_entity_size_t first_index;
     mecs_entity_size_t i;
     mecs_dense_t entity;
-    mecs_sparse_t* sparse_elem;
 
     mecs_size_t components_count;
     mecs_entity_size_t page_count;
@@ -667,6 +975,8 @@ void mecs_deserialise_component_store(mecs_deserialiser_t* io_deserialiser, mecs
     mecs_entity_size_t page_len;
     void* page;
     void* component;
+    mecs_index_t* index;
+    mecs_profile_begin("mecs_deserialise_component_store");
     mecs_assert(io_deserialiser != NULL);
     mecs_assert(o_component_store != NULL);
     mecs_assert(o_component_store->type->deserialise_func != NULL);
@@ -680,33 +990,30 @@ void mecs_deserialise_component_store(mecs_deserialiser_t* io_deserialiser, mecs
         {
             /* Ensure enough memory to deserialise entities and components. */
             mecs_assert(entities_count < MECS_ENTITY_ID_INVALID);
-            mecs_component_add_dense_elements(o_component_store, (mecs_entity_size_t)entities_count);
+            mecs_assert(o_component_store->entities_count == 0); /* Deserialising into a component store which already holds components is not supported. */
+            first_index = o_component_store->entities_count;
+            if (entities_count != 0)
+            {
+                mecs_component_add_dense_elements(o_component_store, (mecs_entity_size_t)entities_count);
+            }
             mecs_assert(o_component_store->entities_count >= entities_count);
 
             /* Deserialise all entities. */
             if (io_deserialiser->allow_binary)
             {
-                mecs_read(io_deserialiser, o_component_store->dense, o_component_store->entities_count * sizeof(mecs_dense_t));
-
-                /* Need to reconstruct the sparse set as only the dense arrays are serialised. */
-                for (i = 0; i < entities_count; ++i)
-                {
-                    entity = o_component_store->dense[i];
-                    sparse_elem = mecs_component_add_sparse_element(o_component_store, entity);
-                    *sparse_elem = mecs_entity_compose(mecs_entity_get_generation(entity), i); /* Build sparse element out of version and dense index. */
-                }
+                mecs_read_values(io_deserialiser, o_component_store->dense + first_index, sizeof(mecs_dense_t), entities_count);
             }
             else 
             {
                 for (i = 0; i < entities_count; ++i)
                 {
-                    mecs_read(io_deserialiser, &entity, sizeof(mecs_dense_t));
-                    o_component_store->dense[i] = entity;
-                    sparse_elem = mecs_component_add_sparse_element(o_component_store, entity);
-                    *sparse_elem = mecs_entity_compose(mecs_entity_get_generation(entity), i); /* Build sparse element out of version and dense index. */
+                    mecs_read_values(io_deserialiser, &entity, sizeof(mecs_dense_t), 1);
+                    o_component_store->dense[first_index + i] = entity;
                 }
             }
 
+            /* Need to reconstruct the sparse set as only the dense arrays are serialised. */
+            mecs_component_add_sparse_elements(o_component_store, first_index, (mecs_entity_size_t)entities_count);
         }
         mecs_list_end(io_deserialiser);
         mecs_list_begin(io_deserialiser, &components_count);
@@ -716,6 +1023,9 @@ void mecs_deserialise_component_store(mecs_deserialiser_t* io_deserialiser, mecs
             /* Deserialise all components. */
             if (io_deserialiser->allow_binary && o_component_store->type->is_trivial)
             {
+                /* Converting the byte order of binary blobs requires a description of the component's fields. */
+                mecs_assert(!io_deserialiser->is_byte_swapped || o_component_store->type->byte_swap_fields != NULL);
+
                 /* Deserialise components as single binary blobs into pages. */
                 page_count = (mecs_entity_size_t)components_count / MECS_PAGE_LEN_DENSE;
                 for (page_index = 0; page_index < page_count; ++page_index)
@@ -723,12 +1033,20 @@ void mecs_deserialise_component_store(mecs_deserialiser_t* io_deserialiser, mecs
                     page = o_component_store->components[page_index];
                     page_len = MECS_PAGE_LEN_DENSE;
                     mecs_read(io_deserialiser, page, o_component_store->type->size * page_len);
+                    if (io_deserialiser->is_byte_swapped)
+                    {
+                        mecs_byte_swap_fields(page, page_len, o_component_store->type->size, o_component_store->type->byte_swap_fields, o_component_store->type->byte_swap_fields_len);
+                    }
                 }
-                if (o_component_store->components_len > 0)
+                if (components_count % MECS_PAGE_LEN_DENSE != 0)
                 {
                     page = o_component_store->components[page_count];
                     page_len = components_count % MECS_PAGE_LEN_DENSE;
                     mecs_read(io_deserialiser, page, o_component_store->type->size * page_len);
+                    if (io_deserialiser->is_byte_swapped)
+                    {
+                        mecs_byte_swap_fields(page, page_len, o_component_store->type->size, o_component_store->type->byte_swap_fields, o_component_store->type->byte_swap_fields_len);
+                    }
                 }
             }
             else 
@@ -747,6 +1065,13 @@ void mecs_deserialise_component_store(mecs_deserialiser_t* io_deserialiser, mecs
         mecs_list_end(io_deserialiser);
     }
     mecs_object_end(io_deserialiser);
+
+    /* Components are deserialised in bulk, index them by their deserialised keys. */
+    for (index = o_component_store->indexes; index != NULL; index = index->next)
+    {
+        mecs_index_rebuild(index);
+    }
+    mecs_profile_end("mecs_deserialise_component_store");
 }
 
 /* --------------------------------------------------
@@ -759,6 +1084,7 @@ void mecs_serialise_registry_binary(mecs_registry_t const* i_registry, void** o_
     mecs_assert(o_data != NULL);
 
     mecs_serialiser_binary_create(&serialiser);
+    mecs_serialiser_binary_write_header(&serialiser);
     mecs_serialise_registry(&serialiser.base, i_registry);
 
     /* Shrink to fit. */
@@ -772,15 +1098,244 @@ void mecs_serialise_registry_binary(mecs_registry_t const* i_registry, void** o_
     }
 }
 
+void mecs_serialise_registry_binary_into(mecs_serialiser_binary_t* io_serialiser, mecs_registry_t const* i_registry)
+{
+    mecs_assert(io_serialiser != NULL);
+
+    mecs_serialiser_binary_reset(io_serialiser);
+    mecs_serialiser_binary_write_header(io_serialiser);
+    mecs_serialise_registry(&io_serialiser->base, i_registry);
+}
+
 void mecs_deserialise_registry_binary(mecs_registry_t* o_registry, void* i_data, mecs_size_t i_size)
 {
     mecs_deserialiser_binary_t deserialiser;
     mecs_assert(i_data != NULL);
 
     mecs_deserialiser_binary_create(&deserialiser, i_data, i_size);
+    mecs_deserialiser_binary_read_header(&deserialiser);
     mecs_deserialise_registry(&deserialiser.base, o_registry);
 }
 
+void mecs_serialise_registry_binary_parallel(mecs_registry_t const* i_registry, mecs_parallel_for_func_t i_parallel_for, void* io_user_data, void** o_data, mecs_size_t* o_size)
+{
+    mecs_serialiser_binary_t serialiser;
+    mecs_serialisation_binary_jobs_t jobs;
+    mecs_size_t stores_len;
+    mecs_component_size_t i;
+    mecs_size_t store_idx;
+    mecs_size_t store_offset;
+    mecs_size_t store_size;
+    mecs_size_t total_size;
+    mecs_assert(i_registry != NULL);
+    mecs_assert(o_data != NULL);
+    mecs_assert(o_size != NULL);
+
+    if (i_parallel_for == NULL)
+    {
+        i_parallel_for = &mecs_parallel_for_sequential;
+    }
+
+    /* Serialise every component store into its own buffer. Stores are independent so this can happen concurrently. */
+    stores_len = i_registry->valid_components_count;
+    jobs.component_stores = NULL;
+    jobs.serialisers = NULL;
+    jobs.deserialisers = NULL;
+    if (stores_len != 0)
+    {
+        jobs.component_stores = mecs_malloc_arr(mecs_component_store_t*, stores_len);
+        jobs.serialisers = mecs_malloc_arr(mecs_serialiser_binary_t, stores_len);
+        if (jobs.component_stores == NULL || jobs.serialisers == NULL)
+        {
+            mecs_assert(MECS_FALSE);
+            if (jobs.component_stores != NULL)
+            {
+                mecs_free(jobs.component_stores);
+            }
+            if (jobs.serialisers != NULL)
+            {
+                mecs_free(jobs.serialisers);
+            }
+            *o_data = NULL;
+            *o_size = 0;
+            return;
+        }
+
+        store_idx = 0;
+        for (i = 0; i < i_registry->components_len; ++i)
+        {
+            if (i_registry->components[i].type != NULL)
+            {
+                jobs.component_stores[store_idx] = &i_registry->components[i];
+                store_idx += 1;
+            }
+        }
+        i_parallel_for(io_user_data, &mecs_serialise_component_store_binary_job, &jobs, stores_len);
+    }
+
+    mecs_serialiser_binary_create(&serialiser);
+    mecs_serialiser_binary_write_header(&serialiser);
+    mecs_serialise_entities(&serialiser.base, i_registry);
+
+    /* Grow the output once to fit the table and all component stores. */
+    store_offset = serialiser.size + sizeof(mecs_size_t) + stores_len * (sizeof(mecs_component_id_t) + sizeof(mecs_size_t) + sizeof(mecs_size_t));
+    total_size = store_offset;
+    for (store_idx = 0; store_idx < stores_len; ++store_idx)
+    {
+        total_size += jobs.serialisers[store_idx].size;
+    }
+    mecs_serialiser_binary_reserve(&serialiser, total_size);
+
+    /* Write a table of component ids, or name hashes if out of order, with the offset and size of their store from the start of the data. */
+    mecs_map_begin(&serialiser.base, stores_len);
+    for (store_idx = 0; store_idx < stores_len; ++store_idx)
+    {
+        store_size = jobs.serialisers[store_idx].size;
+        if (serialiser.base.allow_out_of_order)
+        {
+            mecs_write_values(&serialiser.base, &jobs.component_stores[store_idx]->type->name_hash, sizeof(mecs_uint32_t), 1);
+        }
+        else
+        {
+            mecs_write_values(&serialiser.base, &jobs.component_stores[store_idx]->type->id, sizeof(mecs_component_id_t), 1);
+        }
+        mecs_serialiser_binary_write_size(&serialiser.base, store_offset);
+        mecs_serialiser_binary_write_size(&serialiser.base, store_size);
+        store_offset += store_size;
+    }
+    mecs_map_end(&serialiser.base);
+
+    /* Concatenate all component stores. */
+    for (store_idx = 0; store_idx < stores_len; ++store_idx)
+    {
+        mecs_write(&serialiser.base, jobs.serialisers[store_idx].data, jobs.serialisers[store_idx].size);
+        mecs_serialiser_binary_destroy(&jobs.serialisers[store_idx]);
+    }
+    mecs_assert(serialiser.size == total_size);
+
+    if (stores_len != 0)
+    {
+        mecs_free(jobs.component_stores);
+        mecs_free(jobs.serialisers);
+    }
+
+    *o_data = serialiser.data;
+    *o_size = serialiser.size;
+}
+
+void mecs_deserialise_registry_binary_parallel(mecs_registry_t* o_registry, mecs_parallel_for_func_t i_parallel_for, void* io_user_data, void* i_data, mecs_size_t i_size)
+{
+    mecs_deserialiser_binary_t deserialiser;
+    mecs_serialisation_binary_jobs_t jobs;
+    mecs_size_t stores_len;
+    mecs_size_t store_idx;
+    mecs_component_id_t component_id;
+    mecs_size_t store_offset;
+    mecs_size_t store_size;
+    mecs_size_t jobs_len;
+    mecs_uint32_t name_hash;
+    mecs_component_type_t* type;
+    mecs_assert(o_registry != NULL);
+    mecs_assert(i_data != NULL);
+
+    if (i_parallel_for == NULL)
+    {
+        i_parallel_for = &mecs_parallel_for_sequential;
+    }
+
+    mecs_deserialiser_binary_create(&deserialiser, i_data, i_size);
+    mecs_deserialiser_binary_read_header(&deserialiser);
+    mecs_deserialise_entities(&deserialiser.base, o_registry);
+
+    stores_len = 0;
+    mecs_map_begin(&deserialiser.base, &stores_len);
+    if (stores_len == 0)
+    {
+        mecs_map_end(&deserialiser.base);
+        return;
+    }
+
+    jobs.component_stores = mecs_malloc_arr(mecs_component_store_t*, stores_len);
+    jobs.serialisers = NULL;
+    jobs.deserialisers = mecs_malloc_arr(mecs_deserialiser_binary_t, stores_len);
+    if (jobs.component_stores == NULL || jobs.deserialisers == NULL)
+    {
+        mecs_assert(MECS_FALSE);
+        if (jobs.component_stores != NULL)
+        {
+            mecs_free(jobs.component_stores);
+        }
+        if (jobs.deserialisers != NULL)
+        {
+            mecs_free(jobs.deserialisers);
+        }
+        mecs_map_end(&deserialiser.base);
+        return;
+    }
+
+    /* Read the table and give each component store its own deserialiser over its part of the data. */
+    component_id = MECS_COMPONENT_ID_INVALID;
+    name_hash = 0;
+    store_offset = 0;
+    store_size = 0;
+    jobs_len = 0;
+    for (store_idx = 0; store_idx < stores_len; ++store_idx)
+    {
+        if (deserialiser.base.allow_out_of_order)
+        {
+            mecs_read_values(&deserialiser.base, &name_hash, sizeof(mecs_uint32_t), 1);
+            type = mecs_component_find_by_name_hash(o_registry, name_hash);
+            component_id = type != NULL ? type->id : MECS_COMPONENT_ID_INVALID;
+        }
+        else
+        {
+            mecs_read_values(&deserialiser.base, &component_id, sizeof(mecs_component_id_t), 1);
+            mecs_assert(component_id < o_registry->components_len && o_registry->components[component_id].type != NULL);
+        }
+        mecs_deserialiser_binary_read_size(&deserialiser.base, &store_offset);
+        mecs_deserialiser_binary_read_size(&deserialiser.base, &store_size);
+        mecs_assert(store_offset <= i_size && store_size <= i_size - store_offset);
+
+        if (component_id == MECS_COMPONENT_ID_INVALID)
+        {
+            /* The component is not registered with this registry, there is nothing to deserialise. */
+            continue;
+        }
+
+        jobs.component_stores[jobs_len] = &o_registry->components[component_id];
+        mecs_deserialiser_binary_create(&jobs.deserialisers[jobs_len], ((char*)i_data) + store_offset, store_size);
+        jobs.deserialisers[jobs_len].base.is_byte_swapped = deserialiser.base.is_byte_swapped;
+        jobs.deserialisers[jobs_len].size_width = deserialiser.size_width;
+        jobs_len += 1;
+    }
+    mecs_map_end(&deserialiser.base);
+
+    /* Each component store is independent once the entities have been restored. */
+    i_parallel_for(io_user_data, &mecs_deserialise_component_store_binary_job, &jobs, jobs_len);
+
+    mecs_free(jobs.component_stores);
+    mecs_free(jobs.deserialisers);
+}
+
+void mecs_serialise_component_store_binary_job(void* io_jobs, mecs_size_t i_job_index)
+{
+    mecs_serialisation_binary_jobs_t* jobs;
+    mecs_assert(io_jobs != NULL);
+
+    jobs = (mecs_serialisation_binary_jobs_t*)io_jobs;
+    mecs_serialiser_binary_create(&jobs->serialisers[i_job_index]);
+    mecs_serialise_component_store(&jobs->serialisers[i_job_index].base, jobs->component_stores[i_job_index]);
+}
+
+void mecs_deserialise_component_store_binary_job(void* io_jobs, mecs_size_t i_job_index)
+{
+    mecs_serialisation_binary_jobs_t* jobs;
+    mecs_assert(io_jobs != NULL);
+
+    jobs = (mecs_serialisation_binary_jobs_t*)io_jobs;
+    mecs_deserialise_component_store(&jobs->deserialisers[i_job_index].base, jobs->component_stores[i_job_index]);
+}
+
 void mecs_serialiser_binary_create(mecs_serialiser_binary_t* o_serialiser)
 {
     mecs_assert(o_serialiser != NULL);
@@ -788,7 +1343,7 @@ void mecs_serialiser_binary_create(mecs_serialiser_binary_t* o_serialiser)
     o_serialiser->base.serialiser_data = o_serialiser;
     o_serialiser->base.version = MECS_SERIALISATION_VERSION_LATEST;
     o_serialiser->base.allow_binary = MECS_TRUE;
-    o_serialiser->base.allow_out_of_order = MECS_FALSE;
+    o_serialiser->base.allow_out_of_order = MECS_TRUE;
     o_serialiser->base.is_versioned = MECS_FALSE;
 
     o_serialiser->base.object_begin_func = NULL;
@@ -798,10 +1353,87 @@ void mecs_serialiser_binary_create(mecs_serialiser_binary_t* o_serialiser)
     o_serialiser->base.map_begin_func = &mecs_serialiser_binary_map_begin_func;
     o_serialiser->base.map_end_func = NULL;
     o_serialiser->base.write_func = &mecs_serialiser_binary_write_func;
+    o_serialiser->base.write_values_func = &mecs_serialiser_binary_write_values_func;
+    o_serialiser->base.block_begin_func = &mecs_serialiser_binary_block_begin_func;
+    o_serialiser->base.block_end_func = &mecs_serialiser_binary_block_end_func;
 
     o_serialiser->data = NULL;
     o_serialiser->capacity = 0;
     o_serialiser->size = 0;
+    o_serialiser->owns_data = MECS_TRUE;
+}
+
+void mecs_serialiser_binary_create_with_buffer(mecs_serialiser_binary_t* o_serialiser, void* io_buffer, mecs_size_t i_capacity)
+{
+    mecs_assert(o_serialiser != NULL);
+    mecs_assert(io_buffer != NULL || i_capacity == 0);
+
+    mecs_serialiser_binary_create(o_serialiser);
+    o_serialiser->data = io_buffer;
+    o_serialiser->capacity = i_capacity;
+    o_serialiser->owns_data = MECS_FALSE;
+}
+
+void mecs_serialiser_binary_destroy(mecs_serialiser_binary_t* io_serialiser)
+{
+    mecs_assert(io_serialiser != NULL);
+
+    if (io_serialiser->owns_data && io_serialiser->data != NULL)
+    {
+        mecs_free(io_serialiser->data);
+    }
+    io_serialiser->data = NULL;
+    io_serialiser->capacity = 0;
+    io_serialiser->size = 0;
+    io_serialiser->owns_data = MECS_TRUE;
+}
+
+void mecs_serialiser_binary_reset(mecs_serialiser_binary_t* io_serialiser)
+{
+    mecs_assert(io_serialiser != NULL);
+    io_serialiser->size = 0;
+}
+
+void mecs_serialiser_binary_grow(mecs_serialiser_binary_t* io_serialiser, mecs_size_t i_capacity)
+{
+    void* data_grown;
+    mecs_assert(io_serialiser != NULL);
+    mecs_assert(i_capacity > io_serialiser->capacity);
+
+    /* Never reallocate a buffer provided by the user, move its contents to a buffer we own instead. */
+    if (io_serialiser->owns_data)
+    {
+        data_grown = mecs_realloc(io_serialiser->data, i_capacity);
+    }
+    else
+    {
+        data_grown = mecs_malloc_arr(char, i_capacity);
+        if (data_grown != NULL && io_serialiser->size != 0)
+        {
+            memcpy(data_grown, io_serialiser->data, io_serialiser->size);
+        }
+    }
+
+    if (data_grown == NULL)
+    {
+        mecs_assert(MECS_FALSE);
+        return;
+    }
+    io_serialiser->data = data_grown;
+    io_serialiser->capacity = i_capacity;
+    io_serialiser->owns_data = MECS_TRUE;
+}
+
+void mecs_serialiser_binary_reserve(mecs_serialiser_binary_t* io_serialiser, mecs_size_t i_capacity)
+{
+    mecs_assert(io_serialiser != NULL);
+
+    if (io_serialiser->capacity >= i_capacity)
+    {
+        return;
+    }
+
+    mecs_serialiser_binary_grow(io_serialiser, i_capacity);
 }
 
 void mecs_deserialiser_binary_create(mecs_deserialiser_binary_t* o_deserialiser, void* i_data, mecs_size_t i_size)
@@ -811,8 +1443,9 @@ void mecs_deserialiser_binary_create(mecs_deserialiser_binary_t* o_deserialiser,
     o_deserialiser->base.serialiser_data = o_deserialiser;
     o_deserialiser->base.version = MECS_SERIALISATION_VERSION_LATEST;
     o_deserialiser->base.allow_binary = MECS_TRUE;
-    o_deserialiser->base.allow_out_of_order = MECS_FALSE;
+    o_deserialiser->base.allow_out_of_order = MECS_TRUE;
     o_deserialiser->base.is_versioned = MECS_FALSE;
+    o_deserialiser->base.is_byte_swapped = MECS_FALSE;
 
     o_deserialiser->base.object_begin_func = NULL;
     o_deserialiser->base.object_end_func = NULL;
@@ -821,28 +1454,77 @@ void mecs_deserialiser_binary_create(mecs_deserialiser_binary_t* o_deserialiser,
     o_deserialiser->base.map_begin_func = &mecs_deserialiser_binary_map_begin_func;
     o_deserialiser->base.map_end_func = NULL;
     o_deserialiser->base.read_func = &mecs_deserialiser_binary_read_func;
+    o_deserialiser->base.read_values_func = &mecs_deserialiser_binary_read_values_func;
+    o_deserialiser->base.block_begin_func = &mecs_deserialiser_binary_block_begin_func;
+    o_deserialiser->base.block_end_func = NULL;
+    o_deserialiser->base.skip_func = &mecs_deserialiser_binary_skip_func;
 
     o_deserialiser->data = i_data;
     o_deserialiser->size = i_size;
     o_deserialiser->position = 0;
+    o_deserialiser->size_width = sizeof(mecs_size_t);
+}
+
+void mecs_serialiser_binary_write_header(mecs_serialiser_binary_t* io_serialiser)
+{
+    mecs_uint8_t header[MECS_BINARY_HEADER_SIZE];
+    mecs_assert(io_serialiser != NULL);
+
+    header[0] = 'm';
+    header[1] = 'e';
+    header[2] = 'c';
+    header[3] = 's';
+    header[4] = mecs_is_little_endian() ? MECS_BINARY_HEADER_LITTLE_ENDIAN : MECS_BINARY_HEADER_BIG_ENDIAN;
+    header[5] = (mecs_uint8_t)sizeof(mecs_size_t);
+    header[6] = (mecs_uint8_t)sizeof(mecs_entity_t);
+    header[7] = (mecs_uint8_t)sizeof(mecs_component_id_t);
+    mecs_serialiser_binary_write_func(&io_serialiser->base, header, MECS_BINARY_HEADER_SIZE);
+}
+
+void mecs_deserialiser_binary_read_header(mecs_deserialiser_binary_t* io_deserialiser)
+{
+    mecs_uint8_t header[MECS_BINARY_HEADER_SIZE];
+    mecs_uint8_t endianness;
+    mecs_assert(io_deserialiser != NULL);
+
+    mecs_deserialiser_binary_read_func(&io_deserialiser->base, header, MECS_BINARY_HEADER_SIZE);
+    mecs_assert(header[0] == 'm' && header[1] == 'e' && header[2] == 'c' && header[3] == 's');
+    mecs_assert(header[5] == 4 || header[5] == 8);
+    mecs_assert(header[6] == sizeof(mecs_entity_t));
+    mecs_assert(header[7] == sizeof(mecs_component_id_t));
+
+    endianness = mecs_is_little_endian() ? MECS_BINARY_HEADER_LITTLE_ENDIAN : MECS_BINARY_HEADER_BIG_ENDIAN;
+    io_deserialiser->base.is_byte_swapped = header[4] != endianness;
+    io_deserialiser->size_width = header[5];
 }
 
 void mecs_serialiser_binary_list_begin_func(mecs_serialiser_t* io_serialiser, mecs_size_t i_length)
 {
     mecs_assert(io_serialiser != NULL);
-    mecs_serialiser_binary_write_func(io_serialiser, &i_length, sizeof(i_length));
+    mecs_serialiser_binary_write_size(io_serialiser, i_length);
 }
 
 void mecs_serialiser_binary_map_begin_func(mecs_serialiser_t* io_serialiser, mecs_size_t i_length)
 {
     mecs_assert(io_serialiser != NULL);
-    mecs_serialiser_binary_write_func(io_serialiser, &i_length, sizeof(i_length));
+    mecs_serialiser_binary_write_size(io_serialiser, i_length);
+}
+
+void mecs_serialiser_binary_write_size(mecs_serialiser_t* io_serialiser, mecs_size_t i_size)
+{
+    mecs_assert(io_serialiser != NULL);
+    mecs_serialiser_binary_write_func(io_serialiser, &i_size, sizeof(i_size));
+}
+
+void mecs_serialiser_binary_write_values_func(mecs_serialiser_t* io_serialiser, void const* i_data, mecs_size_t i_value_size, mecs_size_t i_count)
+{
+    /* Values are always written in the byte order of the host. */
+    mecs_serialiser_binary_write_func(io_serialiser, i_data, i_value_size * i_count);
 }
 
 void mecs_serialiser_binary_write_func(mecs_serialiser_t* io_serialiser, void const* i_data, mecs_size_t i_size)
 {
     mecs_serialiser_binary_t* serialiser;
-    void* data_grown;
     mecs_size_t capacity_grown;
     mecs_assert(io_serialiser != NULL);
 
@@ -877,31 +1559,92 @@ void mecs_serialiser_binary_write_func(mecs_serialiser_t* io_serialiser, void co
             return;
         }
 
-        data_grown = mecs_realloc(serialiser->data, capacity_grown);
-        if (data_grown == NULL)
+        mecs_serialiser_binary_grow(serialiser, capacity_grown);
+        if (serialiser->capacity != capacity_grown)
         {
-            mecs_assert(MECS_FALSE);
             return;
         }
-        serialiser->data = data_grown;
-        serialiser->capacity = capacity_grown;
-
     } 
 
     memcpy((char*)serialiser->data + serialiser->size, i_data, i_size);
     serialiser->size += i_size;
 }
 
+void mecs_serialiser_binary_block_begin_func(mecs_serialiser_t* io_serialiser, mecs_size_t* o_marker)
+{
+    mecs_serialiser_binary_t* serialiser;
+    mecs_size_t block_size;
+    mecs_assert(io_serialiser != NULL);
+    mecs_assert(o_marker != NULL);
+
+    /* Reserve space for the size of the block, it gets patched once the block ends. */
+    serialiser = (mecs_serialiser_binary_t*)io_serialiser->serialiser_data;
+    block_size = 0;
+    *o_marker = serialiser->size;
+    mecs_serialiser_binary_write_func(io_serialiser, &block_size, sizeof(block_size));
+}
+
+void mecs_serialiser_binary_block_end_func(mecs_serialiser_t* io_serialiser, mecs_size_t i_marker)
+{
+    mecs_serialiser_binary_t* serialiser;
+    mecs_size_t block_size;
+    mecs_assert(io_serialiser != NULL);
+
+    serialiser = (mecs_serialiser_binary_t*)io_serialiser->serialiser_data;
+    mecs_assert(i_marker + sizeof(block_size) <= serialiser->size);
+    block_size = serialiser->size - (i_marker + sizeof(block_size));
+    memcpy((char*)serialiser->data + i_marker, &block_size, sizeof(block_size));
+}
+
 void mecs_deserialiser_binary_list_begin_func(mecs_deserialiser_t* io_deserialiser, mecs_size_t* o_length)
 {
     mecs_assert(io_deserialiser != NULL);
-    mecs_deserialiser_binary_read_func(io_deserialiser, o_length, sizeof(*o_length));
+    mecs_deserialiser_binary_read_size(io_deserialiser, o_length);
 }
 
 void mecs_deserialiser_binary_map_begin_func(mecs_deserialiser_t* io_deserialiser, mecs_size_t* o_length)
 {
     mecs_assert(io_deserialiser != NULL);
-    mecs_deserialiser_binary_read_func(io_deserialiser, o_length, sizeof(*o_length));
+    mecs_deserialiser_binary_read_size(io_deserialiser, o_length);
+}
+
+void mecs_deserialiser_binary_read_size(mecs_deserialiser_t* io_deserialiser, mecs_size_t* o_size)
+{
+    mecs_deserialiser_binary_t* deserialiser;
+    mecs_uint32_t size32;
+    mecs_uint64_t size64;
+    mecs_assert(io_deserialiser != NULL);
+    mecs_assert(o_size != NULL);
+
+    /* Sizes are written with the width of the machine that wrote them. */
+    deserialiser = (mecs_deserialiser_binary_t*)io_deserialiser->serialiser_data;
+    if (deserialiser->size_width == sizeof(mecs_size_t))
+    {
+        mecs_deserialiser_binary_read_values_func(io_deserialiser, o_size, sizeof(mecs_size_t), 1);
+    }
+    else if (deserialiser->size_width == sizeof(mecs_uint32_t))
+    {
+        size32 = 0;
+        mecs_deserialiser_binary_read_values_func(io_deserialiser, &size32, sizeof(mecs_uint32_t), 1);
+        *o_size = (mecs_size_t)size32;
+    }
+    else
+    {
+        size64 = 0;
+        mecs_deserialiser_binary_read_values_func(io_deserialiser, &size64, sizeof(mecs_uint64_t), 1);
+        mecs_assert(size64 == (mecs_uint64_t)(mecs_size_t)size64); /* Data is too large for this machine. */
+        *o_size = (mecs_size_t)size64;
+    }
+}
+
+void mecs_deserialiser_binary_read_values_func(mecs_deserialiser_t* io_deserialiser, void* o_data, mecs_size_t i_value_size, mecs_size_t i_count)
+{
+    /* Data written with the same byte order is copied as is. */
+    mecs_deserialiser_binary_read_func(io_deserialiser, o_data, i_value_size * i_count);
+    if (io_deserialiser->is_byte_swapped)
+    {
+        mecs_byte_swap(o_data, i_value_size, i_count);
+    }
 }
 
 void mecs_deserialiser_binary_read_func(mecs_deserialiser_t* io_deserialiser, void* o_data, mecs_size_t i_size)
@@ -921,4 +1664,24 @@ void mecs_deserialiser_binary_read_func(mecs_deserialiser_t* io_deserialiser, vo
     deserialiser->position += i_size;
 }
 
+void mecs_deserialiser_binary_block_begin_func(mecs_deserialiser_t* io_deserialiser, mecs_size_t* o_size)
+{
+    mecs_assert(io_deserialiser != NULL);
+    mecs_deserialiser_binary_read_size(io_deserialiser, o_size);
+}
+
+void mecs_deserialiser_binary_skip_func(mecs_deserialiser_t* io_deserialiser, mecs_size_t i_size)
+{
+    mecs_deserialiser_binary_t* deserialiser;
+    mecs_assert(io_deserialiser != NULL);
+
+    deserialiser = (mecs_deserialiser_binary_t*)io_deserialiser->serialiser_data;
+    if (deserialiser->size - deserialiser->position < i_size)
+    {
+        mecs_assert(MECS_FALSE);
+        return;
+    }
+    deserialiser->position += i_size;
+}
+
 #endif /* MECS_IMPLEMENTATION */
\ No newline at end of file
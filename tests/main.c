@@ -35,15 +35,17 @@
     #pragma message("Compiling using unkown target")
 #endif
 
+#define MECS_QUERY_STATS
 #include "../mecs.h"
 #include "../mecs_serialisation.h"
+#include "../mecs_scheduler.h"
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <cassert>
+#include <assert.h>
 #include <string.h>
-#if defined(__cplusplus)
-#include <cstdint>
+#if defined(MECS_THREAD_SAFE) && defined(MECS_TEST_PTHREADS)
+    #include <pthread.h>
 #endif
 
 /* Constexpr definition. Prevents warnings for constant expression created by macros. */
@@ -72,9 +74,9 @@
 #define test_uint(i_value, i_expected)                                                              \
     MECS_CONST_EXPR_IF ((i_value) != (i_expected))                                                  \
     {                                                                                               \
-        mecs_size_t value = (mecs_size_t)(i_value);                                                           \
-        mecs_size_t expected = (mecs_size_t)(i_expected);                                                     \
-        printf("Test line %d failed. Expected: %zu, Got: %zu\n", __LINE__, expected, value);        \
+        unsigned long value = (unsigned long)(i_value);                                                     \
+        unsigned long expected = (unsigned long)(i_expected);                                               \
+        printf("Test line %d failed. Expected: %lu, Got: %lu\n", __LINE__, expected, value);        \
         assert(0);                                                                                  \
     }                                                                                               \
 
@@ -85,12 +87,15 @@ typedef struct
     char freed;
 } allocation_t;
 
-#define MAX_ALLOCATIONS 1024
+#define MAX_ALLOCATIONS 4096
 allocation_t g_memory_leak_allocations[MAX_ALLOCATIONS];
 mecs_size_t g_memory_leak_total_allocations_made;
 mecs_size_t g_memory_leak_total_allocated;
 mecs_size_t g_memory_leak_total_freed;
 
+mecs_size_t g_profile_begin_count;
+mecs_size_t g_profile_end_count;
+
 void memory_leak_detector_init(void) 
 { 
     mecs_size_t i;
@@ -117,17 +122,17 @@ void memory_leak_detector_shutdown(void)
         }
         if (g_memory_leak_allocations[i].freed == 0)
         {
-            printf("Memory leak detected. Address: %zx, Size %zu\n", g_memory_leak_allocations[i].address, g_memory_leak_allocations[i].size);
+            printf("Memory leak detected. Address: %lx, Size %lu\n", (unsigned long)g_memory_leak_allocations[i].address, (unsigned long)g_memory_leak_allocations[i].size);
         }
     }
 
     printf("--------------------------------------------------\n");
-    printf("Total allocations made: %zu.\n", g_memory_leak_total_allocations_made);
-    printf("Total memory allocted:  %zu bytes.\n", g_memory_leak_total_allocated);
-    printf("Total memory freed:     %zu bytes.\n", g_memory_leak_total_freed);
+    printf("Total allocations made: %lu.\n", (unsigned long)g_memory_leak_total_allocations_made);
+    printf("Total memory allocted:  %lu bytes.\n", (unsigned long)g_memory_leak_total_allocated);
+    printf("Total memory freed:     %lu bytes.\n", (unsigned long)g_memory_leak_total_freed);
     if (g_memory_leak_total_allocated != g_memory_leak_total_freed) 
     { 
-        printf("Total memory leaked:    %zu bytes.\n", g_memory_leak_total_allocated - g_memory_leak_total_freed);
+        printf("Total memory leaked:    %lu bytes.\n", (unsigned long)(g_memory_leak_total_allocated - g_memory_leak_total_freed));
         assert(0);
     }
     printf("--------------------------------------------------\n");
@@ -146,7 +151,7 @@ void* memory_leak_detector_realloc(void* i_ptr, mecs_size_t i_size)
             {
                 if (g_memory_leak_allocations[i].freed == 1)
                 {
-                    printf("Detected realloc of a freed address. Address: %zx, Size %zu\n", g_memory_leak_allocations[i].address, g_memory_leak_allocations[i].size);
+                    printf("Detected realloc of a freed address. Address: %lx, Size %lu\n", (unsigned long)g_memory_leak_allocations[i].address, (unsigned long)g_memory_leak_allocations[i].size);
                     assert(0);
                 }
                 g_memory_leak_allocations[i].freed = 1;
@@ -182,7 +187,7 @@ void memory_leak_detector_free(void* i_ptr)
         {
             if (g_memory_leak_allocations[i].freed == 1)
             {
-                printf("Detected double free. Address: %zx, Size %zu\n", g_memory_leak_allocations[i].address, g_memory_leak_allocations[i].size);
+                printf("Detected double free. Address: %lx, Size %lu\n", (unsigned long)g_memory_leak_allocations[i].address, (unsigned long)g_memory_leak_allocations[i].size);
                 assert(0);
             }
             g_memory_leak_allocations[i].freed = 1;
@@ -191,7 +196,7 @@ void memory_leak_detector_free(void* i_ptr)
             return;
         }
     }
-    printf("Allocation not found. Address: %zx\n", (mecs_size_t)i_ptr);
+    printf("Allocation not found. Address: %lx\n", (unsigned long)(mecs_size_t)i_ptr);
     assert(0);
 }
 
@@ -205,6 +210,26 @@ typedef struct
    mecs_uint64_t v; 
 } test_comp_8;
 
+typedef struct 
+{
+    mecs_uint16_t v; 
+} test_comp_2;
+
+typedef struct 
+{
+    mecs_uint32_t v; 
+} test_comp_stable;
+
+typedef struct 
+{
+    mecs_uint32_t v; 
+} test_comp_collide_0;
+
+typedef struct 
+{
+    mecs_uint32_t v; 
+} test_comp_collide_1;
+
 typedef struct 
 {
     mecs_uint32_t n; 
@@ -233,6 +258,16 @@ ARCHIVE(test_comp_serialise, MECS_TRUE)
     archive_add(test_comp_serialise_nested, v4, 0);
 }
 
+typedef struct 
+{
+    mecs_uint32_t v; 
+} test_comp_serialise_value;
+
+ARCHIVE(test_comp_serialise_value, MECS_TRUE)
+{
+    archive_add(mecs_uint32_t, v, 0);
+}
+
 #if defined(__cplusplus)
 namespace cpp
 {
@@ -246,32 +281,40 @@ public:
 
     ~test_comp_cpp() 
     { 
-        v = 11;
+        /* Written through volatile so the store isn't optimised away when the lifetime of the object ends. */
+        *(volatile mecs_uint64_t*)&v = 11;
     }
 
-    std::uint64_t v;
+    mecs_uint64_t v;
 };
 
 class test_comp_cpp_inner_scope
 {
-    std::uint32_t v;
+    mecs_uint32_t v;
+};
+
+class test_comp_cpp_trivial
+{
+public:
+    mecs_uint32_t v;
 };
 
 class test_comp_serialise_cpp 
 {
 public:
-    std::uint32_t v;
+    mecs_uint32_t v;
 };
 
 ARCHIVE(test_comp_serialise_cpp, MECS_TRUE)
 {
-    archive_add(std::uint32_t, v, 0);
+    archive_add(mecs_uint32_t, v, 0);
 }
 
 }
 #endif
 
 COMPONENT_DECLARE(test_comp_serialise);
+COMPONENT_DECLARE(test_comp_serialise_value);
 #if defined(__cplusplus)
 COMPONENT_DECLARE(cpp::test_comp_serialise_cpp);
 #endif
@@ -279,14 +322,30 @@ COMPONENT_DECLARE(cpp::test_comp_serialise_cpp);
 
 COMPONENT_DECLARE(test_comp_4);
 COMPONENT_DECLARE(test_comp_8);
+COMPONENT_DECLARE(test_comp_2);
+COMPONENT_DECLARE(test_comp_stable);
+COMPONENT_DECLARE(test_comp_collide_0);
+COMPONENT_DECLARE(test_comp_collide_1);
+
+/* Matches the order test_comp_4 and test_comp_8 are first registered in. */
+#define TEST_STATIC_COMPONENTS(X) X(test_comp_4) X(test_comp_8)
+STATIC_COMPONENTS_DECLARE(TEST_STATIC_COMPONENTS);
 #if defined(__cplusplus)
 COMPONENT_DECLARE(cpp::test_comp_cpp);
 namespace cpp { COMPONENT_DECLARE(test_comp_cpp_inner_scope); }
+COMPONENT_DECLARE(cpp::test_comp_cpp_trivial);
+
+/* Opt in to skipping the lifetime hooks, required before C++11. */
+template<> struct mecs_is_trivially_constructible<cpp::test_comp_cpp_trivial> { enum { value = 1 }; };
+template<> struct mecs_is_trivially_destructible<cpp::test_comp_cpp_trivial> { enum { value = 1 }; };
+template<> struct mecs_is_trivially_relocatable<cpp::test_comp_cpp_trivial> { enum { value = 1 }; };
+template<> struct mecs_is_trivially_copyable<cpp::test_comp_cpp_trivial> { enum { value = 1 }; };
 #endif
 
 void test_registry_create(void) 
 {
     registry_t* registry;
+    entity_t entity;
 
     registry = registry_create(4);
     COMPONENT_REGISTER(registry, test_comp_4);
@@ -319,6 +378,41 @@ void test_registry_create(void)
     test_uint(registry->components[1].type->alignment, 8);
 
     registry_destroy(registry);
+
+    /* Names with the same FNV-1a hash still register, only looking them up by that hash fails. */
+    registry = registry_create(0);
+    mecs_component_register_impl(registry, mecs_component_get_type_ptr(test_comp_collide_0), "costarring", sizeof(test_comp_collide_0), mecs_alignof(test_comp_collide_0), NULL, NULL, NULL, NULL);
+    mecs_component_register_impl(registry, mecs_component_get_type_ptr(test_comp_collide_1), "liquid", sizeof(test_comp_collide_1), mecs_alignof(test_comp_collide_1), NULL, NULL, NULL, NULL);
+    test_uint(component_name_hash("costarring"), component_name_hash("liquid"));
+    test_uint(registry->valid_components_count, 2);
+    test(component_find_by_name_hash(registry, component_name_hash("liquid")) == NULL);
+    entity = entity_create(registry);
+    component_add(registry, entity, test_comp_collide_0)->v = 1;
+    component_add(registry, entity, test_comp_collide_1)->v = 2;
+    test_uint(component_get(registry, entity, test_comp_collide_0)->v, 1);
+    test_uint(component_get(registry, entity, test_comp_collide_1)->v, 2);
+    registry_destroy(registry);
+}
+
+void test_static_components(void)
+{
+    registry_t* registry;
+    entity_t entity;
+
+    registry = registry_create(TEST_STATIC_COMPONENTS_COUNT);
+    STATIC_COMPONENTS_REGISTER(registry, TEST_STATIC_COMPONENTS);
+    test_uint(TEST_STATIC_COMPONENTS_COUNT, 2);
+    test_uint(registry->components_len, 2);
+    test_uint(MECS_STATIC_COMPONENT_ID(test_comp_8), mecs_component_get_type_ptr(test_comp_8)->id);
+
+    entity = entity_create(registry);
+    component_add(registry, entity, test_comp_8)->v = 8;
+    test_uint(component_has_static(registry, entity, test_comp_8), MECS_TRUE);
+    test_uint(component_has_static(registry, entity, test_comp_4), MECS_FALSE);
+    test_uint(component_get_static(registry, entity, test_comp_8)->v, 8);
+    test(component_get_by_id(registry, entity, 1) == component_get(registry, entity, test_comp_8));
+
+    registry_destroy(registry);
 }
 
 void test_entity_recycle(void) 
@@ -403,6 +497,632 @@ void test_has_component(void)
     registry_destroy(registry);
 }
 
+void test_component_pages(void)
+{
+    registry_t* registry;
+    entity_t* entities;
+    mecs_entity_size_t entities_count;
+    mecs_size_t i;
+
+    /* Fill multiple component pages, which hold fewer elements than sparse pages. */
+    registry = registry_create(2);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    COMPONENT_REGISTER(registry, test_comp_8);
+    entities_count = MECS_PAGE_LEN_DENSE * 3 + 1;
+    entities = entity_create_array(registry, entities_count);
+    for (i = 0; i < entities_count; ++i)
+    {
+        component_add(registry, entities[i], test_comp_8)->v = i;
+    }
+    test_uint(registry->components[(mecs_component_get_type_ptr(test_comp_8))->id].components_len, 4);
+
+    /* Removing swaps in the last component, which lives on the last page. */
+    component_remove(registry, entities[0], test_comp_8);
+    test_uint(component_get(registry, entities[entities_count - 1], test_comp_8)->v, (mecs_uint64_t)(entities_count - 1));
+    for (i = 1; i < entities_count; ++i)
+    {
+        test_uint(component_get(registry, entities[i], test_comp_8)->v, i);
+    }
+
+    /* Entities on sparse pages which were never allocated have no components. */
+    component_add(registry, entities[entities_count - 1], test_comp_4);
+    test_uint(component_has(registry, entities[0], test_comp_4), MECS_FALSE);
+
+    registry_destroy(registry);
+}
+
+void test_registry_stats(void)
+{
+    registry_t* registry;
+    entity_t* entities;
+    registry_stats_t stats;
+    component_store_stats_t component_stats[2];
+    mecs_component_id_t comp4_id;
+
+    registry = registry_create(2);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    comp4_id = (mecs_component_get_type_ptr(test_comp_4))->id;
+    entities = entity_create_array(registry, 10);
+    component_add(registry, entities[1], test_comp_4);
+    component_add(registry, entities[2], test_comp_4);
+    component_add(registry, entities[3], test_comp_4);
+    entity_destroy(registry, entities[2]);
+    entity_destroy(registry, entities[5]);
+
+    registry_get_stats(registry, &stats, component_stats);
+    test_uint(stats.entities_len, 10);
+    test_uint(stats.free_entities_len, 2);
+    test_uint(stats.entities_alive, 8);
+    test_uint(stats.component_stores_count, 1);
+    test(component_stats[comp4_id].type == mecs_component_get_type_ptr(test_comp_4));
+    test_uint(component_stats[comp4_id].entities_count, 2);
+    test_uint(component_stats[comp4_id].sparse_blocks_allocated, 1);
+    test_uint(component_stats[comp4_id].sparse_blocks_used, 1);
+    test_uint(component_stats[comp4_id].dense_capacity, MECS_PAGE_LEN_DENSE);
+    test_uint(component_stats[comp4_id].component_waste_bytes, (MECS_PAGE_LEN_DENSE - 2) * sizeof(test_comp_4));
+    test(stats.bytes > stats.component_stores_bytes);
+
+    /* Sparse blocks stay allocated once all their entities lost the component. */
+    entity_destroy(registry, entities[1]);
+    entity_destroy(registry, entities[3]);
+    component_store_get_stats(&registry->components[comp4_id], &component_stats[comp4_id]);
+    test_uint(component_stats[comp4_id].sparse_blocks_allocated, 1);
+    test_uint(component_stats[comp4_id].sparse_blocks_used, 0);
+
+    registry_destroy(registry);
+}
+
+void test_reserve(void)
+{
+    registry_t* registry;
+    entity_t* entities;
+    component_store_stats_t component_stats;
+    mecs_size_t allocations_made;
+    mecs_size_t i;
+
+    registry = registry_create(2);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    registry_reserve_entities(registry, 1000);
+    test(registry->entities_cap >= 1000);
+
+    /* Creating the reserved entities and adding reserved components doesn't allocate. */
+    allocations_made = g_memory_leak_total_allocations_made;
+    entities = entity_create_array(registry, 1000);
+    test_uint(g_memory_leak_total_allocations_made, allocations_made);
+    component_reserve(registry, test_comp_4, 1000);
+    component_reserve_ids(registry, test_comp_4, entity_get_id(entities[0]), 1000);
+    component_store_get_stats(&registry->components[mecs_component_get_type_ptr(test_comp_4)->id], &component_stats);
+    test_uint(component_stats.component_pages, (1000 + MECS_PAGE_LEN_DENSE - 1) / MECS_PAGE_LEN_DENSE);
+    test_uint(component_stats.sparse_blocks_allocated, (1000 + MECS_PAGE_LEN_SPARSE - 1) / MECS_PAGE_LEN_SPARSE);
+
+    allocations_made = g_memory_leak_total_allocations_made;
+    for (i = 0; i < 1000; ++i)
+    {
+        component_add(registry, entities[i], test_comp_4)->v = (mecs_uint32_t)i;
+    }
+    test_uint(g_memory_leak_total_allocations_made, allocations_made);
+    test_uint(component_get(registry, entities[999], test_comp_4)->v, 999);
+
+    /* Reserving less than is in use leaves the stores alone. */
+    registry_reserve_entities(registry, 0);
+    component_reserve(registry, test_comp_4, 1);
+    component_reserve_ids(registry, test_comp_4, 0, 1);
+    test_uint(g_memory_leak_total_allocations_made, allocations_made);
+
+    registry_destroy(registry);
+}
+
+void test_stable_storage(void)
+{
+    registry_t* registry;
+    entity_t entities[6];
+    test_comp_stable* components[6];
+    component_store_stats_t component_stats;
+    mecs_component_store_t* component_store;
+    query_it_t query;
+    mecs_uint32_t sum;
+    mecs_size_t i;
+
+    COMPONENT_REGISTER_STORAGE(test_comp_stable, MECS_STORAGE_STABLE);
+    registry = registry_create(2);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    COMPONENT_REGISTER(registry, test_comp_stable);
+    component_store = &registry->components[mecs_component_get_type_ptr(test_comp_stable)->id];
+    for (i = 0; i < 5; ++i)
+    {
+        entities[i] = entity_create(registry);
+        components[i] = component_add(registry, entities[i], test_comp_stable);
+        components[i]->v = (mecs_uint32_t)i;
+    }
+
+    /* Removing leaves tombstones, every other component stays where it was. */
+    component_remove(registry, entities[1], test_comp_stable);
+    component_remove(registry, entities[3], test_comp_stable);
+    test(component_get(registry, entities[0], test_comp_stable) == components[0]);
+    test(component_get(registry, entities[2], test_comp_stable) == components[2]);
+    test(component_get(registry, entities[4], test_comp_stable) == components[4]);
+    test_uint(component_has(registry, entities[3], test_comp_stable), MECS_FALSE);
+    component_store_get_stats(component_store, &component_stats);
+    test_uint(component_stats.entities_count, 3);
+    test_uint(component_stats.tombstones_count, 2);
+
+    /* Queries skip the tombstones. */
+    query = query_create();
+    query_with(&query, test_comp_stable);
+    sum = 0;
+    for (query_begin(registry, &query); query_next(&query);)
+    {
+        sum += query_component_get(&query, test_comp_stable, 0)->v;
+    }
+    test_uint(sum, 0 + 2 + 4);
+
+    /* Adding fills the most recent tombstone. */
+    entities[5] = entity_create(registry);
+    components[5] = component_add(registry, entities[5], test_comp_stable);
+    components[5]->v = 5;
+    test(components[5] == components[3]);
+    entity_destroy(registry, entities[2]);
+    component_store_get_stats(component_store, &component_stats);
+    test_uint(component_stats.entities_count, 3);
+    test_uint(component_stats.tombstones_count, 2);
+    #if defined(__cplusplus) && __cplusplus >= 201103L /* C++11 */
+    {
+        mecs_size_t count = 0;
+        mecs::view<mecs::with<test_comp_stable> >(registry).each([&](entity_t, test_comp_stable&) { count += 1; });
+        test_uint(count, 3);
+    }
+    #endif
+
+    /* Removing the last component doesn't leave a tombstone. */
+    component_remove(registry, entities[4], test_comp_stable);
+    test_uint(component_store->entities_count, 4);
+    test_uint(component_store->tombstones_count, 2);
+
+    /* Compacting moves components into the tombstones. */
+    component_compact(registry, test_comp_stable);
+    test_uint(component_store->entities_count, 2);
+    test_uint(component_store->tombstones_count, 0);
+    test_uint(component_get(registry, entities[0], test_comp_stable)->v, 0);
+    test_uint(component_get(registry, entities[5], test_comp_stable)->v, 5);
+    sum = 0;
+    for (query_begin(registry, &query); query_next(&query);)
+    {
+        sum += query_component_get(&query, test_comp_stable, 0)->v;
+    }
+    test_uint(sum, 0 + 5);
+
+    /* Tombstones left behind on destroying the registry are skipped. */
+    component_remove(registry, entities[0], test_comp_stable);
+    registry_destroy(registry);
+    COMPONENT_REGISTER_STORAGE(test_comp_stable, MECS_STORAGE_PACKED);
+}
+
+mecs_uint64_t test_comp_4_key(void const* i_component)
+{
+    return ((test_comp_4 const*)i_component)->v;
+}
+
+mecs_uint64_t test_comp_4_key_div_4(void const* i_component)
+{
+    return ((test_comp_4 const*)i_component)->v / 4;
+}
+
+void test_registry_clear(void)
+{
+    registry_t* registry;
+    entity_t entities[600];
+    entity_t stale;
+    index_t* index;
+    registry_stats_t stats;
+    mecs_size_t allocations_made;
+    mecs_size_t entities_cap;
+    mecs_size_t round;
+    mecs_size_t i;
+
+    registry = registry_create(2);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    COMPONENT_REGISTER(registry, test_comp_8);
+    index = index_create(registry, test_comp_4, MECS_INDEX_KIND_HASH_UNIQUE, &test_comp_4_key);
+    allocations_made = 0;
+    entities_cap = 0;
+    stale = MECS_ENTITY_INVALID;
+    for (round = 0; round < 3; ++round)
+    {
+        /* Every round after the first refills the memory kept by the clear, reusing the ids of the round before. */
+        test(entity_create_array_copy(registry, 600, entities));
+        for (i = 0; i < 600; ++i)
+        {
+            component_add(registry, entities[i], test_comp_4)->v = (mecs_uint32_t)(round * 1000 + i);
+            component_add(registry, entities[i], test_comp_8)->v = i;
+        }
+        test_uint(index_find(index, round * 1000 + 599), entities[599]);
+        if (round != 0)
+        {
+            test_uint(g_memory_leak_total_allocations_made, allocations_made);
+            test_uint(registry->entities_cap, entities_cap);
+
+            /* Handles from before the clear stay destroyed when their ids are handed out again. */
+            test_uint(entity_get_id(entities[0]), entity_get_id(stale));
+            test(entities[0] != stale);
+            test_uint(entity_is_destroyed(registry, stale), MECS_TRUE);
+        }
+
+        /* Clearing a single component leaves the others. */
+        component_clear(registry, test_comp_8);
+        test_uint(component_has(registry, entities[0], test_comp_8), MECS_FALSE);
+        test_uint(component_get(registry, entities[0], test_comp_4)->v, round * 1000);
+
+        registry_clear(registry);
+        registry_get_stats(registry, &stats, NULL);
+        test_uint(stats.entities_alive, 0);
+        test_uint(registry->components[mecs_component_get_type_ptr(test_comp_4)->id].entities_count, 0);
+        test_uint(index_find(index, round * 1000 + 599), MECS_ENTITY_INVALID);
+        allocations_made = g_memory_leak_total_allocations_made;
+        entities_cap = registry->entities_cap;
+        stale = entities[0];
+        test_uint(entity_is_destroyed(registry, stale), MECS_TRUE);
+    }
+
+    /* Single entities take the stored generations as well. */
+    stale = entity_create(registry);
+    test_uint(entity_get_id(stale), 0);
+    test_uint(entity_get_generation(stale), 3);
+
+    index_destroy(index);
+    registry_destroy(registry);
+}
+
+void test_entity_destroy_array(void)
+{
+    registry_t* registry;
+    entity_t entities[100];
+    entity_t doomed[62];
+    index_t* index;
+    registry_stats_t stats;
+    component_store_stats_t component_stats[2];
+    mecs_size_t i;
+
+    registry = registry_create(2);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    COMPONENT_REGISTER(registry, test_comp_8);
+    index = index_create(registry, test_comp_4, MECS_INDEX_KIND_HASH_UNIQUE, &test_comp_4_key);
+    memcpy(entities, entity_create_array(registry, 100), sizeof(entities));
+    for (i = 0; i < 100; ++i)
+    {
+        component_add(registry, entities[i], test_comp_4)->v = (mecs_uint32_t)i;
+        if (i % 2 == 0)
+        {
+            component_add(registry, entities[i], test_comp_8)->v = i;
+        }
+    }
+    test_uint(index_find(index, 10), entities[10]);
+
+    /* Most of both stores goes, so each is swept once. A duplicate and a destroyed entity are skipped. */
+    entity_destroy(registry, entities[99]);
+    memcpy(doomed, entities, 60 * sizeof(entity_t));
+    doomed[60] = entities[5];
+    doomed[61] = entities[99];
+    test_uint(entity_destroy_array(registry, doomed, 62), 60);
+    registry_get_stats(registry, &stats, component_stats);
+    test_uint(stats.entities_alive, 39);
+    test_uint(stats.free_entities_len, 61);
+    test_uint(component_stats[0].entities_count, 39);
+    test_uint(component_stats[1].entities_count, 20);
+    for (i = 0; i < 99; ++i)
+    {
+        test_uint(entity_is_destroyed(registry, entities[i]), i < 60);
+        if (i >= 60)
+        {
+            test_uint(component_get(registry, entities[i], test_comp_4)->v, i);
+            test_uint(component_has(registry, entities[i], test_comp_8), i % 2 == 0);
+        }
+    }
+    test_uint(index_find(index, 10), MECS_ENTITY_INVALID);
+    test_uint(index_find(index, 70), entities[70]);
+
+    /* Only a few entities go, their components are removed one by one. */
+    test_uint(entity_destroy_array(registry, &entities[60], 2), 2);
+    test_uint(component_has(registry, entities[62], test_comp_8), MECS_TRUE);
+    registry_get_stats(registry, &stats, component_stats);
+    test_uint(component_stats[0].entities_count, 37);
+    test_uint(component_stats[1].entities_count, 19);
+
+    /* Ids are reused with a new generation. */
+    test(entity_is_destroyed(registry, entities[61]));
+    test_uint(entity_get_generation(entity_create(registry)), 1);
+
+    index_destroy(index);
+    registry_destroy(registry);
+}
+
+void test_index(void)
+{
+    registry_t* registry;
+    entity_t entities[8];
+    entity_t many[300];
+    entity_t bulk[2000];
+    entity_t found[8];
+    index_t* index_unique;
+    index_t* index_multi;
+    index_t* index_ordered;
+    mecs_uint32_t i;
+
+    registry = registry_create(1);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    memcpy(entities, entity_create_array(registry, 8), sizeof(entities));
+
+    /* Components added before the index is created are indexed right away. */
+    component_add(registry, entities[0], test_comp_4)->v = 100;
+    index_unique = index_create(registry, test_comp_4, MECS_INDEX_KIND_HASH_UNIQUE, &test_comp_4_key);
+    index_multi = index_create(registry, test_comp_4, MECS_INDEX_KIND_HASH_MULTI, &test_comp_4_key_div_4);
+    index_ordered = index_create(registry, test_comp_4, MECS_INDEX_KIND_ORDERED, &test_comp_4_key);
+    test(index_find(index_unique, 100) == entities[0]);
+
+    /* Keys written right after adding a component are picked up by the next lookup. */
+    for (i = 1; i < 8; ++i)
+    {
+        component_add(registry, entities[i], test_comp_4)->v = 100 + i;
+    }
+    test(index_find(index_unique, 105) == entities[5]);
+    test(index_find(index_unique, 200) == MECS_ENTITY_INVALID);
+    test_uint(index_find_all(index_multi, 25, found, 8), 4);
+    test_uint(index_find_all(index_multi, 26, found, 2), 4);
+    test_uint(index_find_range(index_ordered, 102, 105, found, 8), 4);
+    test(found[0] == entities[2]);
+    test(found[3] == entities[5]);
+
+    /* Removing components and destroying entities leaves the index. */
+    component_remove(registry, entities[5], test_comp_4);
+    entity_destroy(registry, entities[6]);
+    test(index_find(index_unique, 105) == MECS_ENTITY_INVALID);
+    test(index_find(index_unique, 106) == MECS_ENTITY_INVALID);
+    test_uint(index_find_all(index_multi, 26, found, 8), 2);
+    test_uint(index_find_range(index_ordered, 0, 1000, found, 0), 6);
+
+    /* Changed keys need an update. */
+    component_get(registry, entities[7], test_comp_4)->v = 50;
+    index_update(registry, entities[7], test_comp_4);
+    test(index_find(index_unique, 50) == entities[7]);
+    test(index_find(index_unique, 107) == MECS_ENTITY_INVALID);
+    test_uint(index_find_range(index_ordered, 0, 99, found, 8), 1);
+
+    /* Added and removed again before any lookup. */
+    component_add(registry, entities[5], test_comp_4)->v = 300;
+    component_remove(registry, entities[5], test_comp_4);
+    test(index_find(index_unique, 300) == MECS_ENTITY_INVALID);
+
+    /* Grow the tables and remove every other entity, which shifts colliding entries back. */
+    index_destroy(index_unique);
+    memcpy(many, entity_create_array(registry, 300), sizeof(many));
+    for (i = 0; i < 300; ++i)
+    {
+        component_add(registry, many[i], test_comp_4)->v = 1000 + i;
+    }
+    for (i = 0; i < 300; i += 2)
+    {
+        component_remove(registry, many[i], test_comp_4);
+    }
+    for (i = 0; i < 300; i += 4)
+    {
+        test_uint(index_find_all(index_multi, (1000 + i) / 4, found, 8), 2);
+        test(found[0] == many[i + 1] || found[0] == many[i + 3]);
+    }
+    test_uint(index_find_range(index_ordered, 1000, 1299, found, 0), 150);
+
+    /* A large batch added between lookups is sorted and merged into the ordered entries in one flush. */
+    memcpy(bulk, entity_create_array(registry, 2000), sizeof(bulk));
+    for (i = 0; i < 2000; ++i)
+    {
+        component_add(registry, bulk[i], test_comp_4)->v = (i * 7919) % 2000; /* Every key below 2000 once, scattered. */
+    }
+    test_uint(index_find_range(index_ordered, 0, 1999, bulk, 2000), 2156);
+    for (i = 1; i < 2000; ++i)
+    {
+        test(component_get(registry, bulk[i - 1], test_comp_4)->v <= component_get(registry, bulk[i], test_comp_4)->v);
+    }
+    test_uint(index_find_range(index_ordered, 1000, 1299, found, 0), 450);
+
+    registry_destroy(registry);
+}
+
+void test_hierarchy(void)
+{
+    registry_t* registry;
+    entity_t entities[7];
+    entity_t visited[7];
+    hierarchy_it_t it;
+    mecs_size_t visited_len;
+    mecs_size_t i;
+    mecs_size_t j;
+
+    registry = registry_create(2);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    COMPONENT_REGISTER(registry, mecs_hierarchy_t);
+    memcpy(entities, entity_create_array(registry, 7), sizeof(entities));
+
+    /*  0       4
+       / \      |
+      1   2     5
+          |
+          3         6 has no hierarchy. */
+    hierarchy_set_parent(registry, entities[3], entities[2]);
+    hierarchy_set_parent(registry, entities[1], entities[0]);
+    hierarchy_set_parent(registry, entities[2], entities[0]);
+    hierarchy_set_parent(registry, entities[5], entities[4]);
+    test(hierarchy_get_parent(registry, entities[3]) == entities[2]);
+    test(hierarchy_get_parent(registry, entities[0]) == MECS_ENTITY_INVALID);
+    test(hierarchy_get_parent(registry, entities[6]) == MECS_ENTITY_INVALID);
+
+    /* Parents are visited before their children, with each subtree in one contiguous run. */
+    visited_len = 0;
+    for (hierarchy_begin(registry, &it); hierarchy_next(&it);)
+    {
+        test(it.hierarchy == component_get(registry, it.entity, mecs_hierarchy_t));
+        visited[visited_len++] = it.entity;
+    }
+    test_uint(visited_len, 6);
+    for (i = 0; i < visited_len; ++i)
+    {
+        for (j = 0; j < i; ++j)
+        {
+            test(hierarchy_get_parent(registry, visited[j]) != visited[i]);
+        }
+    }
+    for (i = 0; visited[i] != entities[0]; ++i);
+    test(visited[i + 1] == entities[2] || visited[i + 1] == entities[1]);
+    test(visited[i + 3] == entities[1] || visited[i + 3] == entities[3]);
+
+    /* Reparenting moves a whole subtree, destroying a parent turns its children into roots. */
+    hierarchy_set_parent(registry, entities[2], entities[5]);
+    test(hierarchy_get_parent(registry, entities[2]) == entities[5]);
+    test(component_get(registry, entities[0], mecs_hierarchy_t)->first_child == entities[1]);
+    entity_destroy(registry, entities[5]);
+    test(hierarchy_get_parent(registry, entities[2]) == MECS_ENTITY_INVALID);
+    test(component_get(registry, entities[4], mecs_hierarchy_t)->first_child == MECS_ENTITY_INVALID);
+
+    /* Recursive destroy. */
+    hierarchy_set_parent(registry, entities[2], entities[1]);
+    component_add(registry, entities[3], test_comp_4);
+    hierarchy_destroy_recursive(registry, entities[0]);
+    test(entity_is_destroyed(registry, entities[0]));
+    test(entity_is_destroyed(registry, entities[1]));
+    test(entity_is_destroyed(registry, entities[2]));
+    test(entity_is_destroyed(registry, entities[3]));
+    test(!entity_is_destroyed(registry, entities[4]));
+    test_uint(registry->components[(mecs_component_get_type_ptr(mecs_hierarchy_t))->id].entities_count, 1);
+    test_uint(registry->components[(mecs_component_get_type_ptr(test_comp_4))->id].entities_count, 0);
+
+    registry_destroy(registry);
+}
+
+mecs_uint32_t g_test_copy_count;
+
+void copy_test_comp8(void* o_dst, void const* i_src)
+{
+    ((test_comp_8*)o_dst)->v = ((test_comp_8 const*)i_src)->v + 1;
+    g_test_copy_count += 1;
+}
+
+void test_entity_clone(void)
+{
+    registry_t* registry;
+    registry_t* prefabs;
+    entity_t entity;
+    entity_t prefab;
+    entity_t clones[600];
+    mecs_size_t i;
+
+    registry = registry_create(2);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    COMPONENT_REGISTER(registry, test_comp_8);
+    entity = entity_create(registry);
+    component_add(registry, entity, test_comp_4)->v = 4;
+    component_add(registry, entity, test_comp_8)->v = 8;
+
+    /* Enough clones to span several component pages. */
+    entity_clone(registry, entity, 600, clones);
+    test_uint(registry->components[(mecs_component_get_type_ptr(test_comp_4))->id].entities_count, 601);
+    for (i = 0; i < 600; ++i)
+    {
+        test(clones[i] != entity);
+        test_uint(component_get(registry, clones[i], test_comp_4)->v, 4);
+        test_uint(component_get(registry, clones[i], test_comp_8)->v, 8);
+    }
+
+    /* Instantiate from a registry only holding prefabs, copying through the copy hook. */
+    prefabs = registry_create(1);
+    COMPONENT_REGISTER(prefabs, test_comp_8);
+    prefab = entity_create(prefabs);
+    component_add(prefabs, prefab, test_comp_8)->v = 20;
+    g_test_copy_count = 0;
+    COMPONENT_REGISTER_COPY_HOOK(test_comp_8, &copy_test_comp8);
+    entity_instantiate(registry, prefabs, prefab, 3, clones);
+    COMPONENT_REGISTER_COPY_HOOK(test_comp_8, NULL);
+    test_uint(g_test_copy_count, 3);
+    for (i = 0; i < 3; ++i)
+    {
+        test(!component_has(registry, clones[i], test_comp_4));
+        test_uint(component_get(registry, clones[i], test_comp_8)->v, 21);
+    }
+
+    registry_destroy(prefabs);
+    registry_destroy(registry);
+}
+
+void test_registry_merge(void)
+{
+    registry_t* dst;
+    registry_t* src;
+    entity_t src_entities[700];
+    entity_t remap[700];
+    entity_t moved[2];
+    entity_t entity;
+    index_t* index;
+    mecs_size_t i;
+
+    dst = registry_create(2);
+    src = registry_create(2);
+    COMPONENT_REGISTER(dst, test_comp_4);
+    COMPONENT_REGISTER(dst, mecs_hierarchy_t);
+    COMPONENT_REGISTER(src, test_comp_4);
+    COMPONENT_REGISTER(src, mecs_hierarchy_t);
+    for (i = 0; i < 3; ++i)
+    {
+        component_add(dst, entity_create(dst), test_comp_4)->v = (mecs_uint32_t)(10000 + i);
+    }
+
+    /* test_comp_4 is moved one by one behind the existing components, the hierarchy pages are handed over. */
+    memcpy(src_entities, entity_create_array(src, 700), sizeof(src_entities));
+    for (i = 0; i < 700; ++i)
+    {
+        component_add(src, src_entities[i], test_comp_4)->v = (mecs_uint32_t)i;
+        if (i % 2 == 0 && i != 0)
+        {
+            hierarchy_set_parent(src, src_entities[i], src_entities[0]);
+        }
+    }
+    entity_destroy(src, src_entities[5]);
+    registry_merge(dst, src, remap);
+
+    test(remap[5] == MECS_ENTITY_INVALID);
+    test_uint(dst->components[(mecs_component_get_type_ptr(test_comp_4))->id].entities_count, 702);
+    test_uint(dst->components[(mecs_component_get_type_ptr(mecs_hierarchy_t))->id].entities_count, 350);
+    test_uint(src->components[(mecs_component_get_type_ptr(test_comp_4))->id].entities_count, 0);
+    test_uint(src->components[(mecs_component_get_type_ptr(mecs_hierarchy_t))->id].entities_count, 0);
+    for (i = 0; i < 700; ++i)
+    {
+        test(i == 5 || entity_is_destroyed(src, src_entities[i]));
+        if (i != 5)
+        {
+            test_uint(component_get(dst, remap[i], test_comp_4)->v, i);
+            test(hierarchy_get_parent(dst, remap[i]) == (i % 2 == 0 && i != 0 ? remap[0] : MECS_ENTITY_INVALID));
+        }
+    }
+
+    /* The source stays usable after its pages were handed over. */
+    entity = entity_create(src);
+    hierarchy_set_parent(src, entity, MECS_ENTITY_INVALID);
+    test(component_has(src, entity, mecs_hierarchy_t));
+
+    /* Move part of a hierarchy, the link to the parent which stays behind is cut. */
+    index = index_create(dst, test_comp_4, MECS_INDEX_KIND_HASH_UNIQUE, &test_comp_4_key);
+    memcpy(src_entities, entity_create_array(src, 3), 3 * sizeof(entity_t));
+    hierarchy_set_parent(src, src_entities[1], src_entities[0]);
+    hierarchy_set_parent(src, src_entities[2], src_entities[1]);
+    component_add(src, src_entities[2], test_comp_4)->v = 5000;
+    registry_merge_entities(dst, src, src_entities + 1, 2, moved);
+    test(entity_is_destroyed(src, src_entities[1]));
+    test(entity_is_destroyed(src, src_entities[2]));
+    test(component_get(src, src_entities[0], mecs_hierarchy_t)->first_child == MECS_ENTITY_INVALID);
+    test(hierarchy_get_parent(dst, moved[0]) == MECS_ENTITY_INVALID);
+    test(hierarchy_get_parent(dst, moved[1]) == moved[0]);
+    test(index_find(index, 5000) == moved[1]);
+    test_uint(src->components[(mecs_component_get_type_ptr(test_comp_4))->id].entities_count, 0);
+
+    registry_destroy(src);
+    registry_destroy(dst);
+}
+
 void test_query(void)
 {
     registry_t* registry;
@@ -482,6 +1202,111 @@ void test_query(void)
     registry_destroy(registry);
 }
 
+void test_query_any_of(void)
+{
+    registry_t* registry;
+    entity_t entities[10];
+    entity_t visited[10];
+    query_it_t query;
+    mecs_size_t count;
+    mecs_size_t i;
+    mecs_size_t j;
+
+    registry = registry_create(3);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    COMPONENT_REGISTER(registry, test_comp_8);
+    COMPONENT_REGISTER(registry, test_comp_2);
+    memcpy(entities, entity_create_array(registry, 10), sizeof(entities));
+    for (i = 0; i < 10; ++i)
+    {
+        if (i % 2 == 0) component_add(registry, entities[i], test_comp_4)->v = (mecs_uint32_t)i;
+        if (i % 3 == 0) component_add(registry, entities[i], test_comp_8)->v = i;
+        if (i < 3) component_add(registry, entities[i], test_comp_2)->v = (mecs_uint16_t)i;
+    }
+
+    /* The union of both dense arrays is the base, entities with both components are visited once. */
+    query = query_create();
+    query_any_of(&query, test_comp_4, 0);
+    query_any_of(&query, test_comp_8, 0);
+    count = 0;
+    for (query_begin(registry, &query); query_next(&query);)
+    {
+        for (j = 0; j < count; ++j)
+        {
+            test(visited[j] != query_entity_get(&query));
+        }
+        visited[count++] = query_entity_get(&query);
+        test(query_component_has(&query, test_comp_4, 0) || query_component_has(&query, test_comp_8, 1));
+        if (query_component_has(&query, test_comp_8, 1))
+        {
+            test_uint(query_component_get(&query, test_comp_8, 1)->v, mecs_entity_get_id(query_entity_get(&query)));
+        }
+    }
+    test_uint(count, 7);
+
+    /* A smaller with argument becomes the base instead. */
+    query = query_create();
+    query_with(&query, test_comp_2);
+    query_any_of(&query, test_comp_4, 0);
+    query_any_of(&query, test_comp_8, 0);
+    count = 0;
+    for (query_begin(registry, &query); query_next(&query);)
+    {
+        count += 1;
+    }
+    test_uint(query.base_arg, 0);
+    test_uint(count, 2);
+
+    /* (test_comp_4 or test_comp_2) and test_comp_8 and not test_comp_2. */
+    query = query_create();
+    query_any_of(&query, test_comp_4, 0);
+    query_any_of(&query, test_comp_2, 0);
+    query_any_of(&query, test_comp_8, 1);
+    query_without(&query, test_comp_2);
+    count = 0;
+    for (query_begin(registry, &query); query_next(&query);)
+    {
+        test(query_entity_get(&query) == entities[6]);
+        count += 1;
+    }
+    test_uint(count, 1);
+
+    /* Arguments move to the heap once they no longer fit in the iterator. */
+    query = query_create();
+    for (i = 0; i < MECS_QUERY_LOCAL_LEN + 5; ++i)
+    {
+        query_optional(&query, test_comp_4);
+    }
+    query_with(&query, test_comp_8);
+    count = 0;
+    for (query_begin(registry, &query); query_next(&query);)
+    {
+        test_uint(query_component_get(&query, test_comp_8, MECS_QUERY_LOCAL_LEN + 5)->v, mecs_entity_get_id(query_entity_get(&query)));
+        test_uint(query_component_has(&query, test_comp_4, MECS_QUERY_LOCAL_LEN), mecs_entity_get_id(query_entity_get(&query)) % 2 == 0);
+        count += 1;
+    }
+    test_uint(count, 4);
+    query_destroy(&query);
+
+    /* A group summing to more entities than a single store holds still loses against a smaller with argument. */
+    for (i = 0; i < 33000; ++i)
+    {
+        entities[0] = entity_create(registry);
+        component_add(registry, entities[0], test_comp_4);
+        component_add(registry, entities[0], test_comp_8);
+        if (i % 33 == 0) component_add(registry, entities[0], test_comp_2);
+    }
+    query = query_create();
+    query_any_of(&query, test_comp_4, 0);
+    query_any_of(&query, test_comp_8, 0);
+    query_with(&query, test_comp_2);
+    query_begin(registry, &query);
+    test_uint(query.base_arg, 2);
+    query_end(&query);
+
+    registry_destroy(registry);
+}
+
 mecs_uint32_t g_test_destructor_count;
 
 void init_test_comp4(void* io_comp)
@@ -495,6 +1320,318 @@ void destroy_test_comp4(void* io_comp)
     g_test_destructor_count += 1;
 }
 
+void test_query_stats(void)
+{
+    registry_t* registry;
+    entity_t* entities;
+    query_it_t query;
+    mecs_size_t i;
+    mecs_size_t profile_begin_count;
+
+    registry = registry_create(2);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    COMPONENT_REGISTER(registry, test_comp_8);
+    entities = entity_create_array(registry, 8);
+    for (i = 0; i < 8; ++i)
+    {
+        component_add(registry, entities[i], test_comp_4);
+        component_add(registry, entities[i], test_comp_8);
+    }
+    component_remove(registry, entities[1], test_comp_8);
+    component_remove(registry, entities[2], test_comp_8);
+
+    /* The smaller store of test_comp_8 forms the base. Arguments are evaluated in order until one does not match. */
+    profile_begin_count = g_profile_begin_count;
+    query = query_create();
+    query_without(&query, test_comp_4);
+    query_with(&query, test_comp_8);
+    for (query_begin(registry, &query); query_next(&query);) {}
+    test_uint(query.entities_scanned, 6);
+    test_uint(query.entities_matched, 0);
+    test_uint(query.sparse_probes, 6);
+
+    query = query_create();
+    query_with(&query, test_comp_4);
+    query_with(&query, test_comp_8);
+    for (query_begin(registry, &query); query_next(&query);) {}
+    test_uint(query.entities_scanned, 6);
+    test_uint(query.entities_matched, 6);
+    test_uint(query.sparse_probes, 12);
+
+    /* Each call to begin and next is reported to the profiling hooks once, a query matching nothing returns from its first next. */
+    test_uint(g_profile_begin_count - profile_begin_count, (1 + 1) + (1 + 7));
+    test_uint(g_profile_begin_count, g_profile_end_count);
+
+    registry_destroy(registry);
+}
+
+void test_query_batch(void)
+{
+    registry_t* registry;
+    entity_t entities[70];
+    query_it_t query;
+    entity_t entity;
+    mecs_size_t matched;
+    mecs_size_t i;
+
+    COMPONENT_REGISTER_STORAGE(test_comp_stable, MECS_STORAGE_STABLE);
+    registry = registry_create(2);
+    COMPONENT_REGISTER(registry, test_comp_stable);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    for (i = 0; i < 70; ++i)
+    {
+        entities[i] = entity_create(registry);
+        component_add(registry, entities[i], test_comp_stable)->v = (mecs_uint32_t)i;
+        if (i % 3 == 0)
+        {
+            component_add(registry, entities[i], test_comp_4)->v = (mecs_uint32_t)i;
+        }
+    }
+    for (i = 0; i < 70; i += 5)
+    {
+        component_remove(registry, entities[i], test_comp_stable);
+    }
+
+    /* Candidates span several batches and tombstones, matches come back in dense order with their components. */
+    query = query_create();
+    query_with(&query, test_comp_stable);
+    query_without(&query, test_comp_4);
+    query_optional(&query, test_comp_4);
+    matched = 0;
+    i = 0;
+    for (query_begin(registry, &query); query_next(&query);)
+    {
+        entity = query_entity_get(&query);
+        while (entities[i] != entity)
+        {
+            i += 1;
+        }
+        test(i % 5 != 0 && i % 3 != 0);
+        test_uint(query_component_get(&query, test_comp_stable, 0)->v, i);
+        test_uint(query_component_has(&query, test_comp_4, 2), MECS_FALSE);
+        matched += 1;
+    }
+    test_uint(matched, 70 - 14 - 24 + 5);
+
+    query = query_create();
+    query_with(&query, test_comp_stable);
+    query_with(&query, test_comp_4);
+    matched = 0;
+    for (query_begin(registry, &query); query_next(&query);)
+    {
+        test_uint(query_component_get(&query, test_comp_4, 1)->v, query_component_get(&query, test_comp_stable, 0)->v);
+        test_uint(mecs_entity_get_id(query_entity_get(&query)) % 3, 0);
+        matched += 1;
+    }
+    test_uint(matched, 24 - 5);
+
+    /* A component removed by the loop body after its batch was matched, the entity must not be returned. With
+       MECS_THREAD_SAFE the loop holds read locks on the queried stores, so it can't remove their components. */
+    #if !defined(MECS_THREAD_SAFE)
+    matched = 0;
+    for (query_begin(registry, &query); query_next(&query);)
+    {
+        entity = query_entity_get(&query);
+        test(entity != entities[6]);
+        test_uint(query_component_has(&query, test_comp_stable, 0), MECS_TRUE);
+        if (entity == entities[3])
+        {
+            component_remove(registry, entities[6], test_comp_stable);
+        }
+        matched += 1;
+    }
+    test_uint(matched, 24 - 5 - 1);
+    #endif
+
+    registry_destroy(registry);
+}
+
+void test_thread_safe(void)
+{
+    /* Single threaded, checks every path releases the locks it takes. Locks left held would spin forever. */
+    registry_t* registry;
+    entity_t entities[4];
+    index_t* index;
+    query_it_t query;
+    registry_stats_t stats;
+    mecs_size_t i;
+
+    registry = registry_create(2);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    COMPONENT_REGISTER(registry, test_comp_8);
+    index = index_create(registry, test_comp_4, MECS_INDEX_KIND_HASH_UNIQUE, &test_comp_4_key);
+    for (i = 0; i < 4; ++i)
+    {
+        entities[i] = entity_create(registry);
+        component_add(registry, entities[i], test_comp_4)->v = (mecs_uint32_t)i;
+        component_add(registry, entities[i], test_comp_8)->v = i;
+    }
+    test_uint(index_find(index, 2), entities[2]);
+
+    /* Leave a query early, query_end releases its read locks so the store can be written again. */
+    query = query_create();
+    query_with(&query, test_comp_4);
+    query_with(&query, test_comp_8);
+    for (query_begin(registry, &query); query_next(&query);)
+    {
+        test_uint(component_has(registry, query_entity_get(&query), test_comp_4), MECS_TRUE);
+        break;
+    }
+    query_end(&query);
+    component_remove(registry, entities[0], test_comp_4);
+
+    /* Run the query to its end, which releases the locks as well. */
+    i = 0;
+    for (query_begin(registry, &query); query_next(&query);)
+    {
+        i += 1;
+    }
+    test_uint(i, 3);
+    entity_destroy(registry, entities[1]);
+    test_uint(entity_is_destroyed(registry, entities[1]), MECS_TRUE);
+
+    #if defined(MECS_THREAD_SAFE)
+        test_uint(registry->entities_lock.state, 0);
+        test_uint(registry->components[mecs_component_get_type_ptr(test_comp_4)->id].lock.state, 0);
+        test_uint(registry->components[mecs_component_get_type_ptr(test_comp_8)->id].lock.state, 0);
+    #endif
+    registry_get_stats(registry, &stats, NULL);
+    test_uint(stats.lock_read_contentions, 0);
+    test_uint(stats.lock_write_contentions, 0);
+
+    index_destroy(index);
+    registry_destroy(registry);
+}
+
+#if defined(MECS_THREAD_SAFE) && defined(MECS_TEST_PTHREADS)
+#define TEST_CONCURRENT_THREADS 4
+#define TEST_CONCURRENT_ENTITIES 1024
+
+typedef struct test_concurrent_t
+{
+    registry_t* registry;
+    entity_t entities[TEST_CONCURRENT_ENTITIES];
+    entity_t destroyed[TEST_CONCURRENT_ENTITIES / 2];
+} test_concurrent_t;
+
+void* test_entity_create_concurrent_thread(void* io_data)
+{
+    test_concurrent_t* data;
+    mecs_size_t i;
+
+    /* Create single entities and batches, destroy half of them and create them again to reuse their ids while the other threads do the same. */
+    data = (test_concurrent_t*)io_data;
+    for (i = 0; i < TEST_CONCURRENT_ENTITIES / 2; ++i)
+    {
+        data->entities[i] = entity_create(data->registry);
+    }
+    for (i = TEST_CONCURRENT_ENTITIES / 2; i < TEST_CONCURRENT_ENTITIES; i += 16)
+    {
+        test(entity_create_array_copy(data->registry, 16, &data->entities[i]));
+    }
+    for (i = 0; i < TEST_CONCURRENT_ENTITIES / 2; ++i)
+    {
+        data->destroyed[i] = data->entities[i * 2];
+        entity_destroy(data->registry, data->entities[i * 2]);
+    }
+    for (i = 0; i < TEST_CONCURRENT_ENTITIES / 2; ++i)
+    {
+        data->entities[i * 2] = entity_create(data->registry);
+    }
+    return NULL;
+}
+
+void test_entity_create_concurrent(void)
+{
+    registry_t* registry;
+    test_concurrent_t* data;
+    pthread_t threads[TEST_CONCURRENT_THREADS];
+    mecs_uint8_t* seen;
+    registry_stats_t stats;
+    mecs_size_t i;
+    mecs_size_t j;
+
+    /* Component free, the memory leak detector isn't thread safe and only growing the entities allocates, under the write lock. */
+    registry = registry_create(1);
+    data = (test_concurrent_t*)malloc(TEST_CONCURRENT_THREADS * sizeof(test_concurrent_t));
+    for (i = 0; i < TEST_CONCURRENT_THREADS; ++i)
+    {
+        data[i].registry = registry;
+        pthread_create(&threads[i], NULL, &test_entity_create_concurrent_thread, &data[i]);
+    }
+    for (i = 0; i < TEST_CONCURRENT_THREADS; ++i)
+    {
+        pthread_join(threads[i], NULL);
+    }
+
+    /* Every id was handed out once, and destroyed entities stay destroyed even when their id got reused. */
+    seen = (mecs_uint8_t*)calloc(registry->entities_len, 1);
+    for (i = 0; i < TEST_CONCURRENT_THREADS; ++i)
+    {
+        for (j = 0; j < TEST_CONCURRENT_ENTITIES; ++j)
+        {
+            test_uint(entity_is_destroyed(registry, data[i].entities[j]), MECS_FALSE);
+            test_uint(seen[entity_get_id(data[i].entities[j])], 0);
+            seen[entity_get_id(data[i].entities[j])] = 1;
+        }
+        for (j = 0; j < TEST_CONCURRENT_ENTITIES / 2; ++j)
+        {
+            test_uint(entity_is_destroyed(registry, data[i].destroyed[j]), MECS_TRUE);
+        }
+    }
+    registry_get_stats(registry, &stats, NULL);
+    test_uint(stats.entities_alive, TEST_CONCURRENT_THREADS * TEST_CONCURRENT_ENTITIES);
+
+    free(seen);
+    free(data);
+    registry_destroy(registry);
+}
+
+void* test_entity_destroy_in_query_thread(void* io_data)
+{
+    test_concurrent_t* data;
+    data = (test_concurrent_t*)io_data;
+    entity_destroy(data->registry, data->entities[0]);
+    return NULL;
+}
+
+void test_entity_destroy_in_query(void)
+{
+    registry_t* registry;
+    test_concurrent_t data;
+    pthread_t thread;
+    query_it_t query;
+    mecs_rwlock_t* lock;
+
+    /* One thread creates entities within a query while another destroys an entity of the queried store. */
+    registry = registry_create(1);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    data.registry = registry;
+    data.entities[0] = entity_create(registry);
+    component_add(registry, data.entities[0], test_comp_4);
+    while (registry->entities_len < registry->entities_cap)
+    {
+        entity_create(registry);
+    }
+    lock = &registry->components[mecs_component_get_type_ptr(test_comp_4)->id].lock;
+
+    query = query_create();
+    query_with(&query, test_comp_4);
+    query_begin(registry, &query);
+    pthread_create(&thread, NULL, &test_entity_destroy_in_query_thread, &data);
+    while (mecs_atomic_load(&lock->write_contentions) == 0)
+    {
+        mecs_pause(); /* Wait until the destroying thread waits for the store. */
+    }
+    entity_create(registry); /* Grows the entities, which hangs if the destroying thread holds the entities lock. */
+    query_end(&query);
+    pthread_join(thread, NULL);
+    test_uint(entity_is_destroyed(registry, data.entities[0]), MECS_TRUE);
+
+    registry_destroy(registry);
+}
+#endif
+
 void test_constructor_c(void)
 {
     registry_t* registry;
@@ -559,6 +1696,88 @@ void test_constructor_cpp(void)
 }
 #endif
 
+#if defined(__cplusplus) && __cplusplus >= 201103L /* C++11 */
+void test_view_cpp(void)
+{
+    registry_t* registry = registry_create(3);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    COMPONENT_REGISTER(registry, test_comp_8);
+    COMPONENT_REGISTER(registry, test_comp_2);
+
+    entity_t entities[600];
+    memcpy(entities, entity_create_array(registry, 600), sizeof(entities));
+    for (mecs_uint32_t i = 0; i < 600; ++i)
+    {
+        component_add(registry, entities[i], test_comp_4)->v = i;
+        if (i % 2 == 0) component_add(registry, entities[i], test_comp_8)->v = i * 2;
+        if (i % 3 == 0) component_add(registry, entities[i], test_comp_2);
+    }
+
+    /* test_comp_8 is the smaller store and becomes the base, components are passed by reference. */
+    mecs_size_t count = 0;
+    mecs::view<mecs::with<test_comp_4, test_comp_8>, mecs::without<test_comp_2> >(registry).each([&](entity_t i_entity, test_comp_4& io_comp4, test_comp_8& io_comp8)
+    {
+        test(i_entity == entities[io_comp4.v]);
+        test_uint(io_comp8.v, io_comp4.v * 2);
+        test(io_comp4.v % 2 == 0 && io_comp4.v % 3 != 0);
+        io_comp8.v = 1;
+        count += 1;
+    });
+    test_uint(count, 200);
+    test_uint(component_get(registry, entities[2], test_comp_8)->v, 1);
+
+    count = 0;
+    mecs::view<mecs::with<test_comp_4> >(registry).each([&](entity_t, test_comp_4&) { count += 1; });
+    test_uint(count, 600);
+
+    registry_destroy(registry);
+}
+#endif
+
+#if defined(__cplusplus)
+void test_trivial_hooks_cpp(void)
+{
+    registry_t* registry = registry_create(2);
+    COMPONENT_REGISTER(registry, cpp::test_comp_cpp);
+    COMPONENT_REGISTER(registry, cpp::test_comp_cpp_trivial);
+
+    mecs_component_type_t* type_cpp = mecs_component_get_type_ptr(cpp::test_comp_cpp);
+    mecs_component_type_t* type_trivial = mecs_component_get_type_ptr(cpp::test_comp_cpp_trivial);
+    test(type_cpp->ctor_func != NULL);
+    test(type_cpp->dtor_func != NULL);
+    test(type_cpp->move_and_dtor_func != NULL);
+    test(type_trivial->ctor_func == NULL);
+    test(type_trivial->dtor_func == NULL);
+    test(type_trivial->move_and_dtor_func == NULL);
+    test(type_cpp->copy_func != NULL);
+    test(type_trivial->copy_func == NULL);
+#if __cplusplus >= 201103L /* C++11 */
+    test(mecs_is_trivially_constructible<cpp::test_comp_serialise_cpp>::value);
+    test(mecs_is_trivially_destructible<cpp::test_comp_serialise_cpp>::value);
+    test(mecs_is_trivially_relocatable<cpp::test_comp_serialise_cpp>::value);
+    test(!mecs_is_trivially_relocatable<cpp::test_comp_cpp>::value);
+#endif
+
+    /* Removing relocates the last component with memcpy. */
+    entity_t entity0 = entity_create(registry);
+    entity_t entity1 = entity_create(registry);
+    component_add(registry, entity0, cpp::test_comp_cpp_trivial)->v = 1;
+    component_add(registry, entity1, cpp::test_comp_cpp_trivial)->v = 2;
+    component_remove(registry, entity0, cpp::test_comp_cpp_trivial);
+    test(!component_has(registry, entity0, cpp::test_comp_cpp_trivial));
+    test_uint(component_get(registry, entity1, cpp::test_comp_cpp_trivial)->v, 2);
+
+    /* Cloning uses the copy constructor. */
+    entity_t clones[2];
+    component_add(registry, entity1, cpp::test_comp_cpp)->v = 5;
+    entity_clone(registry, entity1, 2, clones);
+    test_uint(component_get(registry, clones[0], cpp::test_comp_cpp)->v, 5);
+    test_uint(component_get(registry, clones[1], cpp::test_comp_cpp_trivial)->v, 2);
+
+    registry_destroy(registry);
+}
+#endif
+
 void test_serialise(void)
 {
     registry_t* registry0;
@@ -651,19 +1870,355 @@ void test_serialise(void)
     registry_destroy(registry1);
 }
 
+void parallel_for_reversed(void* io_user_data, mecs_job_func_t i_job_func, void* io_job_data, mecs_size_t i_job_count)
+{
+    /* Run jobs out of order to make sure they do not depend on each other. */
+    mecs_size_t i;
+    (void)io_user_data;
+    for (i = i_job_count; i > 0; --i)
+    {
+        i_job_func(io_job_data, i - 1);
+    }
+}
+
+void test_serialise_parallel(void)
+{
+    registry_t* registry0;
+    registry_t* registry1;
+    entity_t entity0;
+    entity_t entity1;
+    test_comp_serialise* comp0;
+    test_comp_serialise_value* comp1;
+    void* buffer;
+    mecs_size_t buffer_size;
+
+    registry0 = registry_create(3);
+    COMPONENT_REGISTER_SERIALISATION_HOOKS(test_comp_serialise);
+    COMPONENT_REGISTER(registry0, test_comp_serialise);
+    COMPONENT_REGISTER(registry0, test_comp_serialise_value);
+    COMPONENT_REGISTER_SERIALISATION_HOOKS(test_comp_serialise_value);
+
+    entity0 = entity_create(registry0);
+    entity1 = entity_create(registry0);
+    comp0 = component_add(registry0, entity1, test_comp_serialise);
+    comp0->v1 = 1;
+    comp0->v4.n = 4;
+    comp1 = component_add(registry0, entity0, test_comp_serialise_value);
+    comp1->v = 5;
+    comp1 = component_add(registry0, entity1, test_comp_serialise_value);
+    comp1->v = 6;
+
+    serialise_registry_binary_parallel(registry0, &parallel_for_reversed, NULL, &buffer, &buffer_size);
+
+    registry1 = registry_create(3);
+    COMPONENT_REGISTER(registry1, test_comp_serialise);
+    COMPONENT_REGISTER(registry1, test_comp_serialise_value);
+    deserialise_registry_binary_parallel(registry1, NULL, NULL, buffer, buffer_size);
+
+    test_uint(registry1->entities_len, 2);
+    test_uint(component_has(registry1, entity0, test_comp_serialise), MECS_FALSE);
+    test_uint(component_has(registry1, entity1, test_comp_serialise), MECS_TRUE);
+    test_uint(component_get(registry1, entity1, test_comp_serialise)->v1, 1);
+    test_uint(component_get(registry1, entity1, test_comp_serialise)->v4.n, 4);
+    test_uint(component_get(registry1, entity0, test_comp_serialise_value)->v, 5);
+    test_uint(component_get(registry1, entity1, test_comp_serialise_value)->v, 6);
+
+    memory_leak_detector_free(buffer);
+    registry_destroy(registry0);
+    registry_destroy(registry1);
+}
+
+/* Systems append an id to the log so the test can check the order they ran in. */
+char g_scheduler_log[8];
+mecs_size_t g_scheduler_log_len;
+
+double test_scheduler_clock(void* io_user_data)
+{
+    /* Advances one tick per call, every system takes one tick. */
+    double* ticks;
+    ticks = (double*)io_user_data;
+    *ticks += 1.0;
+    return *ticks;
+}
+
+void test_system_write_4(registry_t* io_registry, void* io_user_data)
+{
+    query_it_t query;
+    (void)io_user_data;
+    g_scheduler_log[g_scheduler_log_len++] = 'a';
+    query = query_create();
+    query_with(&query, test_comp_4);
+    for (query_begin(io_registry, &query); query_next(&query);)
+    {
+        query_component_get(&query, test_comp_4, 0)->v += 1;
+    }
+}
+
+void test_system_read_8(registry_t* io_registry, void* io_user_data)
+{
+    (void)io_registry;
+    (void)io_user_data;
+    g_scheduler_log[g_scheduler_log_len++] = 'b';
+}
+
+void test_system_copy_4_to_8(registry_t* io_registry, void* io_user_data)
+{
+    query_it_t query;
+    (void)io_user_data;
+    g_scheduler_log[g_scheduler_log_len++] = 'c';
+    query = query_create();
+    query_with(&query, test_comp_4);
+    query_with(&query, test_comp_8);
+    for (query_begin(io_registry, &query); query_next(&query);)
+    {
+        query_component_get(&query, test_comp_8, 1)->v = query_component_get(&query, test_comp_4, 0)->v;
+    }
+}
+
+void test_system_spawn(registry_t* io_registry, void* io_user_data)
+{
+    entity_t entity;
+    (void)io_user_data;
+    g_scheduler_log[g_scheduler_log_len++] = 'd';
+    entity = entity_create(io_registry);
+    component_add(io_registry, entity, test_comp_4)->v = 0;
+}
+
+void test_scheduler(void)
+{
+    registry_t* registry;
+    entity_t entity;
+    scheduler_t scheduler;
+    scheduler_stats_t stats;
+    system_id_t system;
+    double ticks;
+
+    registry = registry_create(2);
+    COMPONENT_REGISTER(registry, test_comp_4);
+    COMPONENT_REGISTER(registry, test_comp_8);
+    entity = entity_create(registry);
+    component_add(registry, entity, test_comp_4)->v = 1;
+    component_add(registry, entity, test_comp_8)->v = 0;
+
+    scheduler_create(&scheduler, &parallel_for_reversed, NULL);
+    ticks = 0.0;
+    scheduler_set_clock(&scheduler, &test_scheduler_clock, &ticks);
+    system = scheduler_add_system(&scheduler, "write_4", &test_system_write_4, NULL);
+    system_writes(&scheduler, system, test_comp_4);
+    system = scheduler_add_system(&scheduler, "read_8", &test_system_read_8, NULL);
+    system_reads(&scheduler, system, test_comp_8);
+    system = scheduler_add_system(&scheduler, "copy_4_to_8", &test_system_copy_4_to_8, NULL);
+    system_reads(&scheduler, system, test_comp_4);
+    system_writes(&scheduler, system, test_comp_8);
+    system = scheduler_add_system(&scheduler, "spawn", &test_system_spawn, NULL);
+    system_set_structural(&scheduler, system);
+
+    /* write_4 and read_8 don't conflict and share the first wave, copy_4_to_8 waits for both, spawn runs alone. */
+    scheduler_build(&scheduler);
+    test_uint(scheduler.waves_len, 3);
+    test_uint(scheduler.wave_offsets[1], 2);
+    test_uint(scheduler.wave_offsets[2], 3);
+    test_uint(scheduler.wave_offsets[3], 4);
+
+    g_scheduler_log_len = 0;
+    scheduler_run(&scheduler, registry);
+    test_uint(g_scheduler_log_len, 4);
+    test_uint(memcmp(g_scheduler_log, "bacd", 4), 0);
+    test_uint(component_get(registry, entity, test_comp_8)->v, 2);
+    test_uint(registry->entities_len, 2);
+
+    scheduler_get_stats(&scheduler, &stats);
+    test_uint(stats.systems_count, 4);
+    test_uint(stats.waves_count, 3);
+    test_uint((mecs_size_t)stats.frame_time, 9);
+    test_uint((mecs_size_t)stats.systems_time, 4);
+    test_uint((mecs_size_t)stats.critical_path_time, 3);
+
+    /* Adding a reader of test_comp_4 after the structural system starts a fourth wave. */
+    system = scheduler_add_system(&scheduler, "read_4", &test_system_read_8, NULL);
+    system_reads(&scheduler, system, test_comp_4);
+    g_scheduler_log_len = 0;
+    scheduler_run(&scheduler, registry);
+    test_uint(scheduler.waves_len, 4);
+    test_uint(memcmp(g_scheduler_log, "bacdb", 5), 0);
+    test_uint(registry->entities_len, 3);
+
+    scheduler_destroy(&scheduler);
+    registry_destroy(registry);
+}
+
+void test_serialise_out_of_order(void)
+{
+    registry_t* registry0;
+    registry_t* registry1;
+    entity_t entity0;
+    void* buffer;
+    mecs_size_t buffer_size;
+
+    registry0 = registry_create(0);
+    COMPONENT_REGISTER(registry0, test_comp_serialise);
+    COMPONENT_REGISTER(registry0, test_comp_serialise_value);
+    test(component_find_by_name_hash(registry0, component_name_hash("test_comp_serialise")) == mecs_component_get_type_ptr(test_comp_serialise));
+    test(component_find_by_name_hash(registry0, component_name_hash("test_comp_serialise_value")) == mecs_component_get_type_ptr(test_comp_serialise_value));
+    test(component_find_by_name_hash(registry0, component_name_hash("test_comp_4")) == NULL);
+
+    entity0 = entity_create(registry0);
+    component_add(registry0, entity0, test_comp_serialise)->v1 = 1;
+    component_add(registry0, entity0, test_comp_serialise_value)->v = 2;
+    serialise_registry_binary(registry0, &buffer, &buffer_size);
+
+    /* The store of test_comp_serialise is unknown to this registry and must be skipped. */
+    registry1 = registry_create(0);
+    COMPONENT_REGISTER(registry1, test_comp_serialise_value);
+    deserialise_registry_binary(registry1, buffer, buffer_size);
+    test_uint(component_get(registry1, entity0, test_comp_serialise_value)->v, 2);
+
+    memory_leak_detector_free(buffer);
+    registry_destroy(registry0);
+    registry_destroy(registry1);
+}
+
+void test_serialise_sparse_pages(void)
+{
+    registry_t* registry0;
+    registry_t* registry1;
+    entity_t* entities;
+    void* buffer;
+    mecs_size_t buffer_size;
+
+    /* Entities spread over multiple sparse pages, with an empty page in between. */
+    registry0 = registry_create(0);
+    COMPONENT_REGISTER(registry0, test_comp_serialise_value);
+    entities = entity_create_array(registry0, MECS_PAGE_LEN_SPARSE * 3);
+    component_add(registry0, entities[MECS_PAGE_LEN_SPARSE * 2 + 1], test_comp_serialise_value)->v = 1;
+    component_add(registry0, entities[3], test_comp_serialise_value)->v = 2;
+    serialise_registry_binary(registry0, &buffer, &buffer_size);
+
+    registry1 = registry_create(0);
+    COMPONENT_REGISTER(registry1, test_comp_serialise_value);
+    deserialise_registry_binary(registry1, buffer, buffer_size);
+    test_uint(registry1->components[(mecs_component_get_type_ptr(test_comp_serialise_value))->id].sparse_len, 3);
+    test(registry1->components[(mecs_component_get_type_ptr(test_comp_serialise_value))->id].sparse[1] == NULL);
+    test_uint(component_has(registry1, registry1->entities[4], test_comp_serialise_value), MECS_FALSE);
+    test_uint(component_get(registry1, registry1->entities[MECS_PAGE_LEN_SPARSE * 2 + 1], test_comp_serialise_value)->v, 1);
+    test_uint(component_get(registry1, registry1->entities[3], test_comp_serialise_value)->v, 2);
+
+    memory_leak_detector_free(buffer);
+    registry_destroy(registry0);
+    registry_destroy(registry1);
+}
+
+void test_serialise_reuse(void)
+{
+    registry_t* registry0;
+    registry_t* registry1;
+    entity_t entity;
+    serialiser_binary_t serialiser;
+    char buffer[64];
+    mecs_size_t allocations_made;
+    mecs_size_t i;
+
+    registry0 = registry_create(0);
+    COMPONENT_REGISTER(registry0, test_comp_serialise_value);
+    entity = entity_create(registry0);
+    component_add(registry0, entity, test_comp_serialise_value)->v = 7;
+
+    /* Outgrowing a user provided buffer moves the data to an owned buffer. */
+    serialiser_binary_create_with_buffer(&serialiser, buffer, sizeof(buffer));
+    serialise_registry_binary_into(&serialiser, registry0);
+    test(serialiser.data != buffer);
+    test(serialiser.owns_data);
+
+    /* Repeated snapshots reuse the buffer. */
+    allocations_made = g_memory_leak_total_allocations_made;
+    for (i = 0; i < 4; ++i)
+    {
+        component_get(registry0, entity, test_comp_serialise_value)->v = (mecs_uint32_t)i;
+        serialise_registry_binary_into(&serialiser, registry0);
+    }
+    test_uint(g_memory_leak_total_allocations_made, allocations_made);
+
+    registry1 = registry_create(0);
+    COMPONENT_REGISTER(registry1, test_comp_serialise_value);
+    deserialise_registry_binary(registry1, serialiser.data, serialiser.size);
+    test_uint(component_get(registry1, entity, test_comp_serialise_value)->v, 3);
+
+    serialiser_binary_destroy(&serialiser);
+    registry_destroy(registry0);
+    registry_destroy(registry1);
+}
+
+void test_byte_swap(void)
+{
+    mecs_uint32_t values[37];
+    mecs_uint16_t shorts[3];
+    mecs_uint8_t fields[2];
+    mecs_uint8_t records[2][6];
+    mecs_size_t i;
+
+    /* Large enough to take the vectorised path and leave a scalar tail. */
+    for (i = 0; i < 37; ++i) { values[i] = (mecs_uint32_t)(0x01020300 + i); }
+    byte_swap(values, sizeof(mecs_uint32_t), 37);
+    for (i = 0; i < 37; ++i) { test_uint(values[i], (mecs_uint32_t)((i << 24) | 0x00030201)); }
+
+    shorts[0] = 0x0102; shorts[1] = 0x0304; shorts[2] = 0x0506;
+    byte_swap(shorts, sizeof(mecs_uint16_t), 3);
+    test_uint(shorts[0], 0x0201);
+    test_uint(shorts[2], 0x0605);
+
+    /* A record of a 4 byte field followed by a 2 byte field. */
+    fields[0] = 4; fields[1] = 2;
+    for (i = 0; i < 6; ++i) { records[0][i] = (mecs_uint8_t)i; records[1][i] = (mecs_uint8_t)(i + 6); }
+    mecs_byte_swap_fields(records, 2, 6, fields, 2);
+    test_uint(records[0][0], 3);
+    test_uint(records[0][3], 0);
+    test_uint(records[0][4], 5);
+    test_uint(records[1][0], 9);
+    test_uint(records[1][5], 10);
+}
+
 int main(void) 
 {
     memory_leak_detector_init();
     {
         test_registry_create();
+        test_static_components();
         test_entity_recycle();
+        test_entity_destroy_array();
         test_has_component();
+        test_component_pages();
+        test_registry_stats();
+        test_reserve();
+        test_stable_storage();
+        test_registry_clear();
+        test_index();
+        test_hierarchy();
+        test_entity_clone();
+        test_registry_merge();
         test_query();
+        test_query_any_of();
+        test_query_stats();
+        test_query_batch();
+        test_thread_safe();
+        #if defined(MECS_THREAD_SAFE) && defined(MECS_TEST_PTHREADS)
+        test_entity_create_concurrent();
+        test_entity_destroy_in_query();
+        #endif
+        test_scheduler();
         test_constructor_c();
         #if defined(__cplusplus)
         test_constructor_cpp();
+        test_trivial_hooks_cpp();
+        #endif
+        #if defined(__cplusplus) && __cplusplus >= 201103L /* C++11 */
+        test_view_cpp();
         #endif
         test_serialise();
+        test_serialise_parallel();
+        test_serialise_out_of_order();
+        test_serialise_sparse_pages();
+        test_serialise_reuse();
+        test_byte_swap();
     }
     memory_leak_detector_shutdown();
     printf("Shutdown");
@@ -672,6 +2227,9 @@ int main(void)
 
 #define mecs_realloc(io_data, i_size) memory_leak_detector_realloc((io_data), (i_size))
 #define mecs_free(io_data) memory_leak_detector_free(io_data)
+#define mecs_profile_begin(i_name) (g_profile_begin_count += 1)
+#define mecs_profile_end(i_name) (g_profile_end_count += 1)
 #define MECS_IMPLEMENTATION 
 #include "../mecs.h"
-#include "../mecs_serialisation.h"
\ No newline at end of file
+#include "../mecs_serialisation.h"
+#include "../mecs_scheduler.h"
\ No newline at end of file